@@ -50,6 +50,8 @@ public:
     using MacroAssemblerX86Common::call;
     using MacroAssemblerX86Common::loadDouble;
     using MacroAssemblerX86Common::convertInt32ToDouble;
+    using MacroAssemblerX86Common::branch32;
+    using MacroAssemblerX86Common::branchAdd32;
 
     void add32(Imm32 imm, AbsoluteAddress address)
     {
@@ -75,6 +77,18 @@ public:
         sub32(imm, Address(scratchRegister));
     }
 
+    Jump branch32(Condition cond, AbsoluteAddress left, Imm32 right)
+    {
+        move(ImmPtr(left.m_ptr), scratchRegister);
+        return branch32(cond, Address(scratchRegister), right);
+    }
+
+    Jump branchAdd32(Condition cond, Imm32 imm, AbsoluteAddress dest)
+    {
+        move(ImmPtr(dest.m_ptr), scratchRegister);
+        return branchAdd32(cond, imm, Address(scratchRegister));
+    }
+
     void load32(void* address, RegisterID dest)
     {
         if (dest == X86Registers::eax)
@@ -0,0 +1,823 @@
+/*
+ * Copyright (C) 2010 Apple Inc. All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY APPLE INC. ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL APPLE INC. OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+#include "BytecodeCache.h"
+
+#include "BytecodeGenerator.h"
+#include "CodeBlock.h"
+#include "Executable.h"
+#include "Interpreter.h"
+#include "JSGlobalObject.h"
+#include "JSString.h"
+#include "PrototypeFunction.h"
+#include "RegExpCache.h"
+#include <stdio.h>
+#include <string.h>
+#include <wtf/MD5.h>
+#include <wtf/StringHashFunctions.h>
+
+#if HAVE(MMAP)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace JSC {
+
+static const uint32_t fileMagic = 0x4a534243; // 'JSBC'
+static const uint32_t formatVersion = 1; // Bump whenever what an entry holds changes.
+
+struct FileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t configuration;
+    uint32_t entryCount;
+};
+
+// A file written by a build with other opcodes or side tables is of no use.
+static uint32_t buildConfiguration()
+{
+    uint32_t configuration = numOpcodeIDs | sizeof(void*) << 16;
+#if ENABLE(JIT)
+    configuration |= 1 << 24;
+#endif
+#if ENABLE(INTERPRETER)
+    configuration |= 1 << 25;
+#endif
+#if ENABLE(VALUE_PROFILER)
+    configuration |= 1 << 26;
+#endif
+    return configuration;
+}
+
+enum ConstantTag { EmptyConstant, UndefinedConstant, NullConstant, TrueConstant, FalseConstant, Int32Constant, DoubleConstant, StringConstant, GlobalObjectConstant };
+
+// The only pointers the bytecode generator puts into instructions.
+enum CellOperand { GlobalObjectOperand, CallFunctionOperand, ApplyFunctionOperand };
+
+static int cellOperandIndex(OpcodeID opcodeID)
+{
+    switch (opcodeID) {
+    case op_resolve_global:
+    case op_resolve_global_dynamic:
+    case op_get_global_var:
+    case op_jneq_ptr:
+        return 2;
+    case op_put_global_var:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+class BytecodeWriter {
+public:
+    void write(uint32_t value) { m_buffer.append(reinterpret_cast<const char*>(&value), sizeof(value)); }
+    void writeInt(int32_t value) { write(static_cast<uint32_t>(value)); }
+    void writeDouble(double value) { m_buffer.append(reinterpret_cast<const char*>(&value), sizeof(value)); }
+
+    void writeString(const UString& string)
+    {
+        write(string.size());
+        m_buffer.append(reinterpret_cast<const char*>(string.data()), string.size() * sizeof(UChar));
+    }
+
+    Vector<char>& buffer() { return m_buffer; }
+
+private:
+    Vector<char> m_buffer;
+};
+
+// Entries are checksummed, but every read is still bounded by the entry, and
+// a read past its end only leaves the reader failed.
+class BytecodeReader {
+public:
+    BytecodeReader(const char* data, size_t size)
+        : m_cursor(data)
+        , m_end(data + size)
+        , m_failed(false)
+    {
+    }
+
+    bool failed() const { return m_failed; }
+    bool atEnd() const { return m_cursor == m_end; }
+
+    uint32_t read()
+    {
+        uint32_t value = 0;
+        readBytes(&value, sizeof(value));
+        return value;
+    }
+
+    int32_t readInt() { return static_cast<int32_t>(read()); }
+
+    double readDouble()
+    {
+        double value = 0;
+        readBytes(&value, sizeof(value));
+        return value;
+    }
+
+    // A count of things each at least minimumSize bytes long, so that a bad one
+    // cannot make the caller allocate more than the entry could describe.
+    uint32_t readCount(size_t minimumSize)
+    {
+        uint32_t count = read();
+        if (count > static_cast<size_t>(m_end - m_cursor) / minimumSize) {
+            m_failed = true;
+            return 0;
+        }
+        return count;
+    }
+
+    UString readString()
+    {
+        uint32_t length = readCount(sizeof(UChar));
+        Vector<UChar> characters(length);
+        readBytes(characters.data(), length * sizeof(UChar));
+        return UString(characters.data(), length);
+    }
+
+private:
+    void readBytes(void* result, size_t size)
+    {
+        if (size > static_cast<size_t>(m_end - m_cursor)) {
+            m_failed = true;
+            m_cursor = m_end;
+            return;
+        }
+        memcpy(result, m_cursor, size);
+        m_cursor += size;
+    }
+
+    const char* m_cursor;
+    const char* m_end;
+    bool m_failed;
+};
+
+static uint32_t checksum(const char* data, size_t length)
+{
+    return WTF::stringHash(data, length);
+}
+
+BytecodeCache::BytecodeCache(const char* path)
+    : m_path(path)
+    , m_data(0)
+    , m_size(0)
+    , m_entries(0)
+    , m_entryCount(0)
+{
+    map();
+}
+
+BytecodeCache::~BytecodeCache()
+{
+    unmap();
+}
+
+void BytecodeCache::map()
+{
+#if HAVE(MMAP)
+    int fd = open(m_path.data(), O_RDONLY);
+    if (fd == -1)
+        return;
+    struct stat status;
+    if (!fstat(fd, &status) && status.st_size > 0) {
+        void* data = mmap(0, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            m_data = static_cast<const char*>(data);
+            m_size = status.st_size;
+        }
+    }
+    close(fd);
+#else
+    FILE* file = fopen(m_path.data(), "rb");
+    if (!file)
+        return;
+    if (!fseek(file, 0, SEEK_END)) {
+        long size = ftell(file);
+        if (size > 0 && !fseek(file, 0, SEEK_SET)) {
+            char* data = static_cast<char*>(fastMalloc(size));
+            if (fread(data, 1, size, file) == static_cast<size_t>(size)) {
+                m_data = data;
+                m_size = size;
+            } else
+                fastFree(data);
+        }
+    }
+    fclose(file);
+#endif
+    if (!m_data)
+        return;
+
+    const FileHeader* header = reinterpret_cast<const FileHeader*>(m_data);
+    if (m_size < sizeof(FileHeader) || header->magic != fileMagic || header->version != formatVersion || header->configuration != buildConfiguration()
+        || header->entryCount > (m_size - sizeof(FileHeader)) / sizeof(EntryHeader)) {
+        unmap();
+        return;
+    }
+
+    // Entries are sorted by key, and their data lies after the table.
+    const EntryHeader* entries = reinterpret_cast<const EntryHeader*>(m_data + sizeof(FileHeader));
+    size_t dataStart = sizeof(FileHeader) + header->entryCount * sizeof(EntryHeader);
+    for (size_t i = 0; i < header->entryCount; ++i) {
+        if (entries[i].offset < dataStart || entries[i].offset > m_size || entries[i].length > m_size - entries[i].offset
+            || (i && memcmp(entries[i - 1].key, entries[i].key, keySize) >= 0)) {
+            unmap();
+            return;
+        }
+    }
+    m_entries = entries;
+    m_entryCount = header->entryCount;
+}
+
+void BytecodeCache::unmap()
+{
+    if (!m_data)
+        return;
+#if HAVE(MMAP)
+    munmap(const_cast<char*>(m_data), m_size);
+#else
+    fastFree(const_cast<char*>(m_data));
+#endif
+    m_data = 0;
+    m_size = 0;
+    m_entries = 0;
+    m_entryCount = 0;
+}
+
+const BytecodeCache::EntryHeader* BytecodeCache::find(const unsigned char* key) const
+{
+    size_t low = 0;
+    size_t high = m_entryCount;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        int comparison = memcmp(m_entries[mid].key, key, keySize);
+        if (!comparison)
+            return &m_entries[mid];
+        if (comparison < 0)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return 0;
+}
+
+// Everything the bytecode of a function follows from, other than its scope chain.
+void BytecodeCache::computeKey(FunctionExecutable* executable, unsigned char* key)
+{
+    BytecodeWriter writer;
+    const SourceCode& source = executable->source();
+    writer.writeString(UString(source.data(), source.length()));
+    writer.writeString(executable->name().ustring());
+    writer.write(executable->parameterCount());
+    for (size_t i = 0; i < executable->parameterCount(); ++i)
+        writer.writeString(executable->m_parameters->at(i).ustring());
+    writer.write(executable->m_forceUsesArguments);
+
+    MD5 md5;
+    md5.addBytes(reinterpret_cast<const uint8_t*>(writer.buffer().data()), writer.buffer().size());
+    Vector<uint8_t, 16> digest = md5.checksum();
+    memcpy(key, digest.data(), 16);
+}
+
+void BytecodeCache::store(FunctionExecutable* executable, const ScopeChain& scopeChain, const Vector<ScopedPropertyLookup>& lookups)
+{
+#if ENABLE(OPCODE_SAMPLING)
+    // Exception info is kept with the bytecode, and is not cached.
+    return;
+#endif
+    CodeBlock* codeBlock = executable->m_codeBlock;
+    JSGlobalObject* globalObject = scopeChain.globalObject();
+    Interpreter* interpreter = codeBlock->m_globalData->interpreter;
+    const SourceCode& source = executable->source();
+    BytecodeWriter writer;
+
+    // Offsets and lines are relative to the function, so that moving it in its file keeps its entry.
+    writer.write(executable->m_features);
+    writer.writeInt(executable->m_firstLine - source.firstLine());
+    writer.writeInt(executable->m_lastLine - source.firstLine());
+
+    writer.write(lookups.size());
+    for (size_t i = 0; i < lookups.size(); ++i) {
+        const ScopedPropertyLookup& lookup = lookups[i];
+        writer.writeString(lookup.property.ustring());
+        writer.write(lookup.forWriting | lookup.found << 1 | lookup.requiresDynamicChecks << 2 | lookup.foundGlobalObject << 3);
+        writer.writeInt(lookup.index);
+        writer.write(lookup.depth);
+    }
+
+    writer.writeInt(codeBlock->m_numCalleeRegisters);
+    writer.writeInt(codeBlock->m_numVars);
+    writer.writeInt(codeBlock->m_numParameters);
+    writer.writeInt(codeBlock->m_thisRegister);
+    writer.write(codeBlock->m_needsFullScopeChain | codeBlock->m_usesArguments << 1 | codeBlock->m_isNumericCompareFunction << 2);
+
+    writer.write(codeBlock->m_identifiers.size());
+    for (size_t i = 0; i < codeBlock->m_identifiers.size(); ++i)
+        writer.writeString(codeBlock->m_identifiers[i].ustring());
+
+    writer.write(codeBlock->m_constantRegisters.size());
+    for (size_t i = 0; i < codeBlock->m_constantRegisters.size(); ++i) {
+        JSValue value = codeBlock->m_constantRegisters[i].jsValue();
+        if (!value)
+            writer.write(EmptyConstant);
+        else if (value.isUndefined())
+            writer.write(UndefinedConstant);
+        else if (value.isNull())
+            writer.write(NullConstant);
+        else if (value.isTrue())
+            writer.write(TrueConstant);
+        else if (value.isFalse())
+            writer.write(FalseConstant);
+        else if (value.isInt32()) {
+            writer.write(Int32Constant);
+            writer.writeInt(value.asInt32());
+        } else if (value.isNumber()) {
+            writer.write(DoubleConstant);
+            writer.writeDouble(value.uncheckedGetNumber());
+        } else if (value.isString()) {
+            writer.write(StringConstant);
+            writer.writeString(asString(value)->tryGetValue());
+        } else if (value == JSValue(globalObject))
+            writer.write(GlobalObjectConstant);
+        else
+            return;
+    }
+
+    for (int kind = 0; kind < 2; ++kind) {
+        Vector<RefPtr<FunctionExecutable> >& functions = kind ? codeBlock->m_functionExprs : codeBlock->m_functionDecls;
+        writer.write(functions.size());
+        for (size_t i = 0; i < functions.size(); ++i) {
+            FunctionExecutable* function = functions[i].get();
+            const SourceCode& functionSource = function->source();
+            writer.writeString(function->name().ustring());
+            writer.writeInt(functionSource.startOffset() - source.startOffset());
+            writer.writeInt(functionSource.endOffset() - source.startOffset());
+            writer.writeInt(functionSource.firstLine() - source.firstLine());
+            // Only a function expression with a null name goes without a scope for its name.
+            writer.write(function->m_forceUsesArguments | function->name().isNull() << 1);
+            writer.write(function->parameterCount());
+            for (size_t j = 0; j < function->parameterCount(); ++j)
+                writer.writeString(function->m_parameters->at(j).ustring());
+            writer.writeInt(function->m_firstLine - source.firstLine());
+            writer.writeInt(function->m_lastLine - source.firstLine());
+        }
+    }
+
+    CodeBlock::RareData* rareData = codeBlock->m_rareData.get();
+    writer.write(rareData ? rareData->m_regexps.size() : 0);
+    for (size_t i = 0; rareData && i < rareData->m_regexps.size(); ++i) {
+        RegExp* regExp = rareData->m_regexps[i].get();
+        char flags[4];
+        char* flag = flags;
+        if (regExp->global())
+            *flag++ = 'g';
+        if (regExp->ignoreCase())
+            *flag++ = 'i';
+        if (regExp->multiline())
+            *flag++ = 'm';
+        *flag = 0;
+        writer.writeString(regExp->pattern());
+        writer.writeString(flags);
+    }
+
+    writer.write(rareData ? rareData->m_exceptionHandlers.size() : 0);
+    for (size_t i = 0; rareData && i < rareData->m_exceptionHandlers.size(); ++i) {
+        const HandlerInfo& handler = rareData->m_exceptionHandlers[i];
+        writer.write(handler.start);
+        writer.write(handler.end);
+        writer.write(handler.target);
+        writer.write(handler.scopeDepth);
+    }
+
+    for (int kind = 0; kind < 2; ++kind) {
+        size_t count = rareData ? (kind ? rareData->m_characterSwitchJumpTables.size() : rareData->m_immediateSwitchJumpTables.size()) : 0;
+        writer.write(count);
+        for (size_t i = 0; i < count; ++i) {
+            const SimpleJumpTable& jumpTable = kind ? rareData->m_characterSwitchJumpTables[i] : rareData->m_immediateSwitchJumpTables[i];
+            writer.writeInt(jumpTable.min);
+            writer.write(jumpTable.branchOffsets.size());
+            for (size_t j = 0; j < jumpTable.branchOffsets.size(); ++j)
+                writer.writeInt(jumpTable.branchOffsets[j]);
+        }
+    }
+
+    writer.write(rareData ? rareData->m_stringSwitchJumpTables.size() : 0);
+    for (size_t i = 0; rareData && i < rareData->m_stringSwitchJumpTables.size(); ++i) {
+        const StringJumpTable::StringOffsetTable& offsetTable = rareData->m_stringSwitchJumpTables[i].offsetTable;
+        writer.write(offsetTable.size());
+        StringJumpTable::StringOffsetTable::const_iterator end = offsetTable.end();
+        for (StringJumpTable::StringOffsetTable::const_iterator iter = offsetTable.begin(); iter != end; ++iter) {
+            writer.writeString(UString(iter->first));
+            writer.writeInt(iter->second.branchOffset);
+        }
+    }
+
+    SymbolTable& symbolTable = *codeBlock->m_symbolTable;
+    writer.write(symbolTable.size());
+    SymbolTable::const_iterator end = symbolTable.end();
+    for (SymbolTable::const_iterator iter = symbolTable.begin(); iter != end; ++iter) {
+        writer.writeString(UString(iter->first));
+        writer.writeInt(iter->second.getIndex());
+        writer.write(iter->second.getAttributes());
+    }
+
+    writer.write(codeBlock->m_jumpTargets.size());
+    for (size_t i = 0; i < codeBlock->m_jumpTargets.size(); ++i)
+        writer.write(codeBlock->m_jumpTargets[i]);
+
+    Vector<Instruction>& instructions = codeBlock->m_instructions;
+    writer.write(instructions.size());
+    for (size_t i = 0; i < instructions.size(); ) {
+        OpcodeID opcodeID = interpreter->getOpcodeID(instructions[i].u.opcode);
+        int cellOperand = cellOperandIndex(opcodeID);
+        writer.write(opcodeID);
+        for (int j = 1; j < opcodeLengths[opcodeID]; ++j) {
+            if (j != cellOperand) {
+                writer.writeInt(instructions[i + j].u.operand);
+                continue;
+            }
+            JSCell* cell = instructions[i + j].u.jsCell;
+            if (cell == globalObject)
+                writer.write(GlobalObjectOperand);
+            else if (cell == globalObject->d()->callFunction)
+                writer.write(CallFunctionOperand);
+            else if (cell == globalObject->d()->applyFunction)
+                writer.write(ApplyFunctionOperand);
+            else
+                return;
+        }
+        i += opcodeLengths[opcodeID];
+    }
+
+#if ENABLE(INTERPRETER)
+    writer.write(codeBlock->m_propertyAccessInstructions.size());
+    for (size_t i = 0; i < codeBlock->m_propertyAccessInstructions.size(); ++i)
+        writer.write(codeBlock->m_propertyAccessInstructions[i]);
+    writer.write(codeBlock->m_globalResolveInstructions.size());
+    for (size_t i = 0; i < codeBlock->m_globalResolveInstructions.size(); ++i)
+        writer.write(codeBlock->m_globalResolveInstructions[i]);
+#endif
+#if ENABLE(JIT)
+    writer.write(codeBlock->m_structureStubInfos.size());
+    for (size_t i = 0; i < codeBlock->m_structureStubInfos.size(); ++i)
+        writer.write(codeBlock->m_structureStubInfos[i].accessType);
+    writer.write(codeBlock->m_globalResolveInfos.size());
+    for (size_t i = 0; i < codeBlock->m_globalResolveInfos.size(); ++i)
+        writer.write(codeBlock->m_globalResolveInfos[i].bytecodeOffset);
+    writer.write(codeBlock->m_callLinkInfos.size());
+    writer.write(rareData ? rareData->m_functionRegisterInfos.size() : 0);
+    for (size_t i = 0; rareData && i < rareData->m_functionRegisterInfos.size(); ++i) {
+        writer.write(rareData->m_functionRegisterInfos[i].bytecodeOffset);
+        writer.writeInt(rareData->m_functionRegisterInfos[i].functionRegisterIndex);
+    }
+#endif
+#if ENABLE(VALUE_PROFILER)
+    writer.write(codeBlock->m_valueProfiles.size());
+    for (size_t i = 0; i < codeBlock->m_valueProfiles.size(); ++i) {
+        writer.write(codeBlock->m_valueProfiles[i].bytecodeOffset);
+        writer.write(codeBlock->m_valueProfiles[i].opcodeID);
+    }
+#endif
+
+    m_newEntries.grow(m_newEntries.size() + 1);
+    NewEntry& entry = m_newEntries.last();
+    computeKey(executable, entry.key);
+    entry.data.swap(writer.buffer());
+}
+
+CodeBlock* BytecodeCache::load(FunctionExecutable* executable, const ScopeChain& scopeChain)
+{
+#if ENABLE(OPCODE_SAMPLING)
+    return 0;
+#endif
+    unsigned char key[keySize];
+    computeKey(executable, key);
+    const EntryHeader* entry = find(key);
+    if (!entry || checksum(m_data + entry->offset, entry->length) != entry->checksum)
+        return 0;
+
+    JSGlobalObject* globalObject = scopeChain.globalObject();
+    JSGlobalData* globalData = &globalObject->globalExec()->globalData();
+    const SourceCode& source = executable->source();
+    BytecodeReader reader(m_data + entry->offset, entry->length);
+
+    CodeFeatures features = reader.read();
+    int firstLine = source.firstLine() + reader.readInt();
+    int lastLine = source.firstLine() + reader.readInt();
+
+    // The bytecode is only right if the scope chain resolves every name as it did.
+    for (size_t count = reader.readCount(sizeof(uint32_t) * 4), i = 0; i < count; ++i) {
+        Identifier property(globalData, reader.readString());
+        uint32_t flags = reader.read();
+        int index = reader.readInt();
+        size_t depth = reader.read();
+
+        int foundIndex = 0;
+        size_t foundDepth = 0;
+        bool requiresDynamicChecks = false;
+        JSObject* foundGlobalObject = 0;
+        bool found = BytecodeGenerator::lookUpScopedProperty(scopeChain, property, foundIndex, foundDepth, flags & 1, requiresDynamicChecks, foundGlobalObject);
+        if (reader.failed() || found != !!(flags & 2) || requiresDynamicChecks != !!(flags & 4) || !!foundGlobalObject != !!(flags & 8) || foundIndex != index || foundDepth != depth)
+            return 0;
+    }
+
+    executable->recordParse(features, firstLine, lastLine);
+    CodeBlock* codeBlock = new FunctionCodeBlock(executable, FunctionCode, source.provider(), source.startOffset());
+    codeBlock->setGlobalData(globalData);
+
+    codeBlock->m_numCalleeRegisters = reader.readInt();
+    codeBlock->m_numVars = reader.readInt();
+    codeBlock->m_numParameters = reader.readInt();
+    codeBlock->m_thisRegister = reader.readInt();
+    uint32_t flags = reader.read();
+    codeBlock->m_needsFullScopeChain = flags & 1;
+    codeBlock->m_usesArguments = flags & 2;
+    codeBlock->m_isNumericCompareFunction = flags & 4;
+
+    for (size_t count = reader.readCount(sizeof(uint32_t)), i = 0; i < count; ++i)
+        codeBlock->addIdentifier(Identifier(globalData, reader.readString()));
+
+    for (size_t count = reader.readCount(sizeof(uint32_t)), i = 0; i < count && !reader.failed(); ++i) {
+        JSValue value;
+        switch (reader.read()) {
+        case EmptyConstant:
+            break;
+        case UndefinedConstant:
+            value = jsUndefined();
+            break;
+        case NullConstant:
+            value = jsNull();
+            break;
+        case TrueConstant:
+            value = jsBoolean(true);
+            break;
+        case FalseConstant:
+            value = jsBoolean(false);
+            break;
+        case Int32Constant:
+            value = jsNumber(globalData, reader.readInt());
+            break;
+        case DoubleConstant:
+            value = jsNumber(globalData, reader.readDouble());
+            break;
+        case StringConstant:
+            value = jsOwnedString(globalData, reader.readString());
+            break;
+        case GlobalObjectConstant:
+            value = globalObject;
+            break;
+        default:
+            delete codeBlock;
+            return 0;
+        }
+        codeBlock->addConstantRegister(value);
+        globalData->heap.addNurseryRoot(value);
+    }
+
+    for (int kind = 0; kind < 2; ++kind) {
+        for (size_t count = reader.readCount(sizeof(uint32_t) * 8), i = 0; i < count && !reader.failed(); ++i) {
+            UString nameString = reader.readString();
+            int startOffset = source.startOffset() + reader.readInt();
+            int endOffset = source.startOffset() + reader.readInt();
+            int sourceFirstLine = source.firstLine() + reader.readInt();
+            uint32_t functionFlags = reader.read();
+            Identifier name = functionFlags & 2 ? Identifier() : Identifier(globalData, nameString);
+            RefPtr<FunctionParameters> parameters = FunctionParameters::create(0);
+            for (size_t parameterCount = reader.readCount(sizeof(uint32_t)), j = 0; j < parameterCount; ++j)
+                parameters->append(Identifier(globalData, reader.readString()));
+            int functionFirstLine = source.firstLine() + reader.readInt();
+            int functionLastLine = source.firstLine() + reader.readInt();
+            if (startOffset < source.startOffset() || endOffset > source.endOffset() || startOffset > endOffset) {
+                delete codeBlock;
+                return 0;
+            }
+            RefPtr<FunctionExecutable> function = FunctionExecutable::create(globalData, name, SourceCode(source.provider(), startOffset, endOffset, sourceFirstLine), functionFlags & 1, parameters.get(), functionFirstLine, functionLastLine);
+            if (kind)
+                codeBlock->addFunctionExpr(function.release());
+            else
+                codeBlock->addFunctionDecl(function.release());
+        }
+    }
+
+    for (size_t count = reader.readCount(sizeof(uint32_t) * 2), i = 0; i < count && !reader.failed(); ++i) {
+        UString pattern = reader.readString();
+        UString flags = reader.readString();
+        codeBlock->addRegExp(globalData->regExpCache()->lookupOrCreate(pattern, flags).get());
+    }
+
+    for (size_t count = reader.readCount(sizeof(uint32_t) * 4), i = 0; i < count; ++i) {
+        HandlerInfo handler;
+        handler.start = reader.read();
+        handler.end = reader.read();
+        handler.target = reader.read();
+        handler.scopeDepth = reader.read();
+        codeBlock->addExceptionHandler(handler);
+    }
+
+    for (int kind = 0; kind < 2; ++kind) {
+        for (size_t count = reader.readCount(sizeof(uint32_t) * 2), i = 0; i < count && !reader.failed(); ++i) {
+            SimpleJumpTable& jumpTable = kind ? codeBlock->addCharacterSwitchJumpTable() : codeBlock->addImmediateSwitchJumpTable();
+            jumpTable.min = reader.readInt();
+            for (size_t offsetCount = reader.readCount(sizeof(uint32_t)), j = 0; j < offsetCount; ++j)
+                jumpTable.branchOffsets.append(reader.readInt());
+        }
+    }
+
+    for (size_t count = reader.readCount(sizeof(uint32_t)), i = 0; i < count && !reader.failed(); ++i) {
+        StringJumpTable& jumpTable = codeBlock->addStringSwitchJumpTable();
+        for (size_t offsetCount = reader.readCount(sizeof(uint32_t) * 2), j = 0; j < offsetCount; ++j) {
+            Identifier clause(globalData, reader.readString());
+            OffsetLocation location;
+            location.branchOffset = reader.readInt();
+            jumpTable.offsetTable.add(clause.ustring().rep(), location);
+        }
+    }
+
+    for (size_t count = reader.readCount(sizeof(uint32_t) * 3), i = 0; i < count && !reader.failed(); ++i) {
+        Identifier name(globalData, reader.readString());
+        int index = reader.readInt();
+        unsigned attributes = reader.read();
+        codeBlock->symbolTable()->add(name.ustring().rep(), SymbolTableEntry(index, attributes));
+    }
+
+    for (size_t count = reader.readCount(sizeof(uint32_t)), i = 0; i < count; ++i)
+        codeBlock->addJumpTarget(reader.read());
+
+    Interpreter* interpreter = globalData->interpreter;
+    Vector<Instruction>& instructions = codeBlock->m_instructions;
+    size_t instructionCount = reader.readCount(sizeof(uint32_t));
+    instructions.reserveCapacity(instructionCount);
+    while (instructions.size() < instructionCount && !reader.failed()) {
+        uint32_t opcodeID = reader.read();
+        if (opcodeID >= static_cast<uint32_t>(numOpcodeIDs) || instructions.size() + opcodeLengths[opcodeID] > instructionCount) {
+            delete codeBlock;
+            return 0;
+        }
+        instructions.append(Instruction(interpreter->getOpcode(static_cast<OpcodeID>(opcodeID))));
+        int cellOperand = cellOperandIndex(static_cast<OpcodeID>(opcodeID));
+        for (int j = 1; j < opcodeLengths[opcodeID]; ++j) {
+            if (j != cellOperand) {
+                instructions.append(Instruction(reader.readInt()));
+                continue;
+            }
+            switch (reader.read()) {
+            case GlobalObjectOperand:
+                instructions.append(Instruction(static_cast<JSCell*>(globalObject)));
+                break;
+            case CallFunctionOperand:
+                instructions.append(Instruction(static_cast<JSCell*>(globalObject->d()->callFunction)));
+                break;
+            case ApplyFunctionOperand:
+                instructions.append(Instruction(static_cast<JSCell*>(globalObject->d()->applyFunction)));
+                break;
+            default:
+                delete codeBlock;
+                return 0;
+            }
+        }
+    }
+
+#if ENABLE(INTERPRETER)
+    for (size_t count = reader.readCount(sizeof(uint32_t)), i = 0; i < count; ++i)
+        codeBlock->addPropertyAccessInstruction(reader.read());
+    for (size_t count = reader.readCount(sizeof(uint32_t)), i = 0; i < count; ++i)
+        codeBlock->addGlobalResolveInstruction(reader.read());
+#endif
+#if ENABLE(JIT)
+    for (size_t count = reader.readCount(sizeof(uint32_t)), i = 0; i < count; ++i)
+        codeBlock->addStructureStubInfo(StructureStubInfo(static_cast<AccessType>(reader.read())));
+    for (size_t count = reader.readCount(sizeof(uint32_t)), i = 0; i < count; ++i)
+        codeBlock->addGlobalResolveInfo(reader.read());
+    for (size_t count = reader.read(), i = 0; i < count && !reader.failed(); ++i)
+        codeBlock->addCallLinkInfo();
+    for (size_t count = reader.readCount(sizeof(uint32_t) * 2), i = 0; i < count; ++i) {
+        unsigned bytecodeOffset = reader.read();
+        codeBlock->addFunctionRegisterInfo(bytecodeOffset, reader.readInt());
+    }
+#endif
+#if ENABLE(VALUE_PROFILER)
+    for (size_t count = reader.readCount(sizeof(uint32_t) * 2), i = 0; i < count; ++i) {
+        unsigned bytecodeOffset = reader.read();
+        codeBlock->addValueProfile(bytecodeOffset, static_cast<OpcodeID>(reader.read()));
+    }
+#endif
+
+    if (reader.failed() || !reader.atEnd() || instructions.size() != instructionCount) {
+        delete codeBlock;
+        return 0;
+    }
+
+    // What BytecodeGenerator::generate() does once the instructions are emitted.
+#ifndef NDEBUG
+    codeBlock->setInstructionCount(instructions.size());
+#endif
+    codeBlock->computeCallSiteLiveness();
+    codeBlock->clearExceptionInfo();
+    codeBlock->shrinkToFit();
+    return codeBlock;
+}
+
+static bool keyLess(const unsigned char* a, const unsigned char* b)
+{
+    return memcmp(a, b, 16) < 0;
+}
+
+struct SavedEntry {
+    const unsigned char* key;
+    const char* data;
+    uint32_t length;
+    uint32_t checksum;
+};
+
+bool BytecodeCache::save()
+{
+    // New entries replace older ones with the same key, the last one added winning.
+    Vector<const NewEntry*> newEntries;
+    for (size_t i = m_newEntries.size(); i--; )
+        newEntries.append(&m_newEntries[i]);
+    for (size_t i = 1; i < newEntries.size(); ++i) {
+        const NewEntry* entry = newEntries[i];
+        size_t j = i;
+        for (; j && keyLess(entry->key, newEntries[j - 1]->key); --j)
+            newEntries[j] = newEntries[j - 1];
+        newEntries[j] = entry;
+    }
+
+    Vector<SavedEntry> entries;
+    size_t oldIndex = 0;
+    for (size_t i = 0; i <= newEntries.size(); ++i) {
+        const unsigned char* newKey = i < newEntries.size() ? newEntries[i]->key : 0;
+        if (newKey && i && !memcmp(newKey, newEntries[i - 1]->key, keySize))
+            continue;
+        for (; oldIndex < m_entryCount && (!newKey || keyLess(m_entries[oldIndex].key, newKey)); ++oldIndex) {
+            const EntryHeader& old = m_entries[oldIndex];
+            SavedEntry saved = { old.key, m_data + old.offset, old.length, old.checksum };
+            entries.append(saved);
+        }
+        if (!newKey)
+            break;
+        if (oldIndex < m_entryCount && !memcmp(m_entries[oldIndex].key, newKey, keySize))
+            ++oldIndex;
+        const Vector<char>& data = newEntries[i]->data;
+        SavedEntry saved = { newKey, data.data(), data.size(), checksum(data.data(), data.size()) };
+        entries.append(saved);
+    }
+
+    // Written aside and renamed into place, so that no process ever maps half a file.
+    Vector<char> temporaryPath;
+    temporaryPath.append(m_path.data(), m_path.length());
+    temporaryPath.append(".tmp", 5);
+    FILE* file = fopen(temporaryPath.data(), "wb");
+    if (!file)
+        return false;
+
+    FileHeader header = { fileMagic, formatVersion, buildConfiguration(), entries.size() };
+    bool success = fwrite(&header, sizeof(header), 1, file) == 1;
+    uint32_t offset = sizeof(FileHeader) + entries.size() * sizeof(EntryHeader);
+    for (size_t i = 0; success && i < entries.size(); ++i) {
+        EntryHeader entryHeader;
+        memcpy(entryHeader.key, entries[i].key, keySize);
+        entryHeader.offset = offset;
+        entryHeader.length = entries[i].length;
+        entryHeader.checksum = entries[i].checksum;
+        success = fwrite(&entryHeader, sizeof(entryHeader), 1, file) == 1;
+        offset += entries[i].length;
+    }
+    for (size_t i = 0; success && i < entries.size(); ++i)
+        success = !entries[i].length || fwrite(entries[i].data, entries[i].length, 1, file) == 1;
+    success = !fclose(file) && success;
+
+    if (!success || rename(temporaryPath.data(), m_path.data())) {
+        remove(temporaryPath.data());
+        return false;
+    }
+    return true;
+}
+
+} // namespace JSC
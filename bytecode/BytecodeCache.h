@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2010 Apple Inc. All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY APPLE INC. ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL APPLE INC. OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BytecodeCache_h
+#define BytecodeCache_h
+
+#include <wtf/Noncopyable.h>
+#include <wtf/Vector.h>
+#include <wtf/text/CString.h>
+
+namespace JSC {
+
+    class CodeBlock;
+    class FunctionExecutable;
+    class ScopeChain;
+
+    struct ScopedPropertyLookup;
+
+    // Bytecode of functions, kept in a file so that later processes running the
+    // same scripts need not parse and compile them again. Entries are keyed by a
+    // digest of the function's source text and hold no pointers. Each one lists
+    // what the bytecode generator found out from the scope chain, and is only
+    // reused where the scope chain still gives the same answers.
+    class BytecodeCache : public Noncopyable {
+    public:
+        // Maps the cache at path, if it holds a valid one. Either way, save()
+        // writes it back with the entries added since.
+        BytecodeCache(const char* path);
+        ~BytecodeCache();
+
+        // The bytecode for executable from the cache, or 0 if there is none that
+        // fits the scope chain.
+        CodeBlock* load(FunctionExecutable*, const ScopeChain&);
+
+        // Adds the bytecode just generated for executable, before it first runs.
+        void store(FunctionExecutable*, const ScopeChain&, const Vector<ScopedPropertyLookup>&);
+
+        bool save();
+
+    private:
+        static const size_t keySize = 16;
+
+        struct EntryHeader {
+            unsigned char key[keySize];
+            uint32_t offset;
+            uint32_t length;
+            uint32_t checksum;
+        };
+
+        struct NewEntry {
+            unsigned char key[keySize];
+            Vector<char> data;
+        };
+
+        static void computeKey(FunctionExecutable*, unsigned char* key);
+
+        void map();
+        void unmap();
+        const EntryHeader* find(const unsigned char* key) const;
+
+        CString m_path;
+
+        const char* m_data;
+        size_t m_size;
+        const EntryHeader* m_entries;
+        size_t m_entryCount;
+
+        Vector<NewEntry> m_newEntries;
+    };
+
+} // namespace JSC
+
+#endif // BytecodeCache_h
@@ -37,6 +37,7 @@
 #include "JSStaticScopeObject.h"
 #include "Debugger.h"
 #include "BytecodeGenerator.h"
+#include <algorithm>
 #include <stdio.h>
 #include <wtf/StringExtras.h>
 
@@ -250,6 +251,9 @@ static void printStructureStubInfo(const StructureStubInfo& stubInfo, unsigned i
     case access_put_by_id_replace:
         printf("  [%4d] %s: %s\n", instructionOffset, "put_by_id_replace", pointerToSourceString(stubInfo.u.putByIdReplace.baseObjectStructure).UTF8String().data());
         return;
+    case access_put_by_id_list:
+        printf("  [%4d] %s: %s (%d)\n", instructionOffset, "put_by_id_list", pointerToSourceString(stubInfo.u.putByIdList.structureList).UTF8String().data(), stubInfo.u.putByIdList.listSize);
+        return;
     case access_get_by_id:
         printf("  [%4d] %s\n", instructionOffset, "get_by_id");
         return;
@@ -1346,6 +1350,13 @@ CodeBlock::CodeBlock(ScriptExecutable* ownerExecutable, CodeType codeType, PassR
     , m_codeType(codeType)
     , m_source(sourceProvider)
     , m_sourceOffset(sourceOffset)
+#if ENABLE(JIT_OPTIMIZING_TIER)
+    , m_optimizationCounter(0)
+    , m_speculationFailures(0)
+#endif
+#if ENABLE(INTERPRETER_OSR)
+    , m_jitExecutionCounter(std::numeric_limits<int32_t>::min())
+#endif
     , m_symbolTable(symTab)
     , m_exceptionInfo(new ExceptionInfo)
 {
@@ -1395,6 +1406,11 @@ CodeBlock::~CodeBlock()
 
 #endif // ENABLE(JIT)
 
+#if ENABLE(VALUE_PROFILER)
+    for (size_t size = m_valueProfiles.size(), i = 0; i < size; ++i)
+        m_valueProfiles[i].deref();
+#endif
+
 #if DUMP_CODE_BLOCK_STATISTICS
     liveCodeBlockSet.remove(this);
 #endif
@@ -1704,6 +1720,610 @@ bool CodeBlock::hasGlobalResolveInfoAtBytecodeOffset(unsigned bytecodeOffset)
 }
 #endif
 
+// A set of temporaries, one bit per register in [m_numVars, m_numCalleeRegisters).
+class TemporarySet {
+public:
+    TemporarySet(uint32_t* bits, int firstTemporary, int numTemporaries)
+        : m_bits(bits)
+        , m_firstTemporary(firstTemporary)
+        , m_numTemporaries(numTemporaries)
+    {
+    }
+
+    void add(int index)
+    {
+        unsigned bit = index - m_firstTemporary;
+        if (bit < static_cast<unsigned>(m_numTemporaries))
+            m_bits[bit / 32] |= 1u << (bit % 32);
+    }
+
+    void remove(int index)
+    {
+        unsigned bit = index - m_firstTemporary;
+        if (bit < static_cast<unsigned>(m_numTemporaries))
+            m_bits[bit / 32] &= ~(1u << (bit % 32));
+    }
+
+    void addRange(int first, int count)
+    {
+        for (int i = 0; i < count; ++i)
+            add(first + i);
+    }
+
+    void addAll()
+    {
+        addRange(m_firstTemporary, m_numTemporaries);
+    }
+
+private:
+    uint32_t* m_bits;
+    int m_firstTemporary;
+    int m_numTemporaries;
+};
+
+// Turns the set of temporaries live after vPC into the set live before it.
+// Writes are only treated as kills where they happen on every path out of
+// the instruction; anything not understood here is assumed to read every
+// temporary, which is always safe.
+static void computeLiveBefore(OpcodeID opcodeID, const Instruction* vPC, TemporarySet& live)
+{
+    switch (opcodeID) {
+    case op_enter:
+    case op_init_arguments:
+    case op_create_arguments:
+    case op_tear_off_arguments:
+    case op_method_check:
+    case op_pop_scope:
+    case op_jmp:
+    case op_loop:
+    case op_jmp_scopes:
+    case op_debug:
+        return;
+    case op_enter_with_activation:
+    case op_new_object:
+    case op_new_regexp:
+    case op_new_func:
+    case op_new_func_exp:
+    case op_resolve:
+    case op_resolve_skip:
+    case op_resolve_global:
+    case op_resolve_global_dynamic:
+    case op_get_global_var:
+    case op_get_scoped_var:
+    case op_resolve_base:
+    case op_new_error:
+    case op_catch:
+    case op_jsr:
+        live.remove(vPC[1].u.operand);
+        return;
+    case op_resolve_with_base:
+        live.remove(vPC[1].u.operand);
+        live.remove(vPC[2].u.operand);
+        return;
+    case op_mov:
+    case op_not:
+    case op_eq_null:
+    case op_neq_null:
+    case op_post_inc:
+    case op_post_dec:
+    case op_to_jsnumber:
+    case op_negate:
+    case op_bitnot:
+    case op_typeof:
+    case op_is_undefined:
+    case op_is_boolean:
+    case op_is_number:
+    case op_is_string:
+    case op_is_object:
+    case op_is_function:
+    case op_to_primitive:
+    case op_del_by_id:
+    case op_get_by_id:
+    case op_get_by_id_self:
+    case op_get_by_id_self_list:
+    case op_get_by_id_proto:
+    case op_get_by_id_proto_list:
+    case op_get_by_id_chain:
+    case op_get_by_id_getter_self:
+    case op_get_by_id_getter_self_list:
+    case op_get_by_id_getter_proto:
+    case op_get_by_id_getter_proto_list:
+    case op_get_by_id_getter_chain:
+    case op_get_by_id_custom_self:
+    case op_get_by_id_custom_self_list:
+    case op_get_by_id_custom_proto:
+    case op_get_by_id_custom_proto_list:
+    case op_get_by_id_custom_chain:
+    case op_get_by_id_generic:
+    case op_get_array_length:
+    case op_get_string_length:
+        live.remove(vPC[1].u.operand);
+        live.add(vPC[2].u.operand);
+        return;
+    case op_eq:
+    case op_neq:
+    case op_stricteq:
+    case op_nstricteq:
+    case op_less:
+    case op_lesseq:
+    case op_add:
+    case op_mul:
+    case op_div:
+    case op_mod:
+    case op_sub:
+    case op_lshift:
+    case op_rshift:
+    case op_urshift:
+    case op_bitand:
+    case op_bitxor:
+    case op_bitor:
+    case op_in:
+    case op_get_by_val:
+    case op_del_by_val:
+        live.remove(vPC[1].u.operand);
+        live.add(vPC[2].u.operand);
+        live.add(vPC[3].u.operand);
+        return;
+    case op_instanceof:
+        live.remove(vPC[1].u.operand);
+        live.add(vPC[2].u.operand);
+        live.add(vPC[3].u.operand);
+        live.add(vPC[4].u.operand);
+        return;
+    case op_get_by_pname:
+        live.remove(vPC[1].u.operand);
+        live.add(vPC[2].u.operand);
+        live.add(vPC[3].u.operand);
+        live.add(vPC[4].u.operand);
+        live.add(vPC[5].u.operand);
+        live.add(vPC[6].u.operand);
+        return;
+    case op_new_array:
+    case op_strcat:
+        live.remove(vPC[1].u.operand);
+        live.addRange(vPC[2].u.operand, vPC[3].u.operand);
+        return;
+    case op_push_new_scope:
+        live.remove(vPC[1].u.operand);
+        live.add(vPC[3].u.operand);
+        return;
+    case op_convert_this:
+    case op_pre_inc:
+    case op_pre_dec:
+    case op_push_scope:
+    case op_tear_off_activation:
+    case op_ret:
+    case op_end:
+    case op_throw:
+    case op_sret:
+    case op_profile_will_call:
+    case op_profile_did_call:
+    case op_jtrue:
+    case op_jfalse:
+    case op_jeq_null:
+    case op_jneq_null:
+    case op_jneq_ptr:
+    case op_loop_if_true:
+    case op_loop_if_false:
+        live.add(vPC[1].u.operand);
+        return;
+    case op_jnless:
+    case op_jnlesseq:
+    case op_jless:
+    case op_jlesseq:
+    case op_loop_if_less:
+    case op_loop_if_lesseq:
+    case op_construct_verify:
+        live.add(vPC[1].u.operand);
+        live.add(vPC[2].u.operand);
+        return;
+    case op_switch_imm:
+    case op_switch_char:
+    case op_switch_string:
+    case op_put_scoped_var:
+    case op_put_global_var:
+        live.add(vPC[3].u.operand);
+        return;
+    case op_put_by_id:
+    case op_put_by_id_transition:
+    case op_put_by_id_replace:
+    case op_put_by_id_generic:
+    case op_put_by_index:
+    case op_put_getter:
+    case op_put_setter:
+        live.add(vPC[1].u.operand);
+        live.add(vPC[3].u.operand);
+        return;
+    case op_put_by_val:
+        live.add(vPC[1].u.operand);
+        live.add(vPC[2].u.operand);
+        live.add(vPC[3].u.operand);
+        return;
+    case op_get_pnames:
+        // dst, i and size are not written when base is null or undefined.
+        live.add(vPC[2].u.operand);
+        return;
+    case op_next_pname:
+        live.add(vPC[2].u.operand);
+        live.add(vPC[3].u.operand);
+        live.add(vPC[4].u.operand);
+        live.add(vPC[5].u.operand);
+        return;
+    case op_call:
+    case op_call_eval:
+        live.remove(vPC[1].u.operand);
+        live.add(vPC[2].u.operand);
+        live.addRange(vPC[4].u.operand - RegisterFile::CallFrameHeaderSize - vPC[3].u.operand, vPC[3].u.operand);
+        return;
+    case op_construct:
+        live.remove(vPC[1].u.operand);
+        live.add(vPC[2].u.operand);
+        live.add(vPC[5].u.operand);
+        live.addRange(vPC[4].u.operand - RegisterFile::CallFrameHeaderSize - vPC[3].u.operand, vPC[3].u.operand);
+        return;
+    default:
+        // op_call_varargs and op_load_varargs address a dynamic number of
+        // argument registers.
+        live.addAll();
+        return;
+    }
+}
+
+static bool isCallSite(OpcodeID opcodeID)
+{
+    return opcodeID == op_call || opcodeID == op_call_eval || opcodeID == op_call_varargs || opcodeID == op_construct;
+}
+
+// Appends the bytecode offsets control can reach from the instruction at
+// bytecodeOffset, other than by throwing. Returns false if it falls through.
+static bool appendJumpTargets(CodeBlock* codeBlock, OpcodeID opcodeID, unsigned bytecodeOffset, const Vector<unsigned>& jsrReturnOffsets, Vector<unsigned, 8>& targets)
+{
+    const Instruction* vPC = codeBlock->instructions().begin() + bytecodeOffset;
+    switch (opcodeID) {
+    case op_jmp:
+    case op_loop:
+    case op_jmp_scopes:
+    case op_jsr:
+        targets.append(bytecodeOffset + vPC[opcodeID == op_jmp || opcodeID == op_loop ? 1 : 2].u.operand);
+        return true;
+    case op_jtrue:
+    case op_jfalse:
+    case op_jeq_null:
+    case op_jneq_null:
+    case op_loop_if_true:
+    case op_loop_if_false:
+        targets.append(bytecodeOffset + vPC[2].u.operand);
+        return false;
+    case op_jneq_ptr:
+    case op_jnless:
+    case op_jnlesseq:
+    case op_jless:
+    case op_jlesseq:
+    case op_loop_if_less:
+    case op_loop_if_lesseq:
+        targets.append(bytecodeOffset + vPC[3].u.operand);
+        return false;
+    case op_get_pnames:
+        targets.append(bytecodeOffset + vPC[5].u.operand);
+        return false;
+    case op_next_pname:
+        targets.append(bytecodeOffset + vPC[6].u.operand);
+        return false;
+    case op_switch_imm:
+    case op_switch_char: {
+        targets.append(bytecodeOffset + vPC[2].u.operand);
+        SimpleJumpTable& jumpTable = opcodeID == op_switch_imm ? codeBlock->immediateSwitchJumpTable(vPC[1].u.operand) : codeBlock->characterSwitchJumpTable(vPC[1].u.operand);
+        for (size_t i = 0; i < jumpTable.branchOffsets.size(); ++i) {
+            if (jumpTable.branchOffsets[i])
+                targets.append(bytecodeOffset + jumpTable.branchOffsets[i]);
+        }
+        return true;
+    }
+    case op_switch_string: {
+        targets.append(bytecodeOffset + vPC[2].u.operand);
+        StringJumpTable::StringOffsetTable& offsetTable = codeBlock->stringSwitchJumpTable(vPC[1].u.operand).offsetTable;
+        StringJumpTable::StringOffsetTable::iterator end = offsetTable.end();
+        for (StringJumpTable::StringOffsetTable::iterator it = offsetTable.begin(); it != end; ++it) {
+            if (it->second.branchOffset)
+                targets.append(bytecodeOffset + it->second.branchOffset);
+        }
+        return true;
+    }
+    case op_sret:
+        targets.append(jsrReturnOffsets.data(), jsrReturnOffsets.size());
+        return true;
+    case op_ret:
+    case op_end:
+    case op_throw:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void CodeBlock::computeCallSiteLiveness()
+{
+    m_callSiteBytecodeOffsets.clear();
+    m_callSiteLiveTemporaries.clear();
+
+    Interpreter* interpreter = m_globalData->interpreter;
+    unsigned instructionCount = m_instructions.size();
+
+    // Find the instruction boundaries and the basic block leaders.
+    Vector<unsigned> instructionOffsets;
+    Vector<OpcodeID> opcodeIDs;
+    Vector<unsigned> jsrReturnOffsets;
+    bool hasCallSite = false;
+    for (unsigned offset = 0; offset < instructionCount; ) {
+        OpcodeID opcodeID = interpreter->getOpcodeID(m_instructions[offset].u.opcode);
+        instructionOffsets.append(offset);
+        opcodeIDs.append(opcodeID);
+        hasCallSite |= isCallSite(opcodeID);
+        offset += opcodeLengths[opcodeID];
+        if (opcodeID == op_jsr)
+            jsrReturnOffsets.append(offset);
+    }
+    if (!hasCallSite || m_numCalleeRegisters <= m_numVars)
+        return;
+
+    Vector<unsigned> leaders;
+    leaders.append(0);
+    Vector<unsigned, 8> targets;
+    for (size_t i = 0; i < instructionOffsets.size(); ++i) {
+        targets.shrink(0);
+        bool endsBlock = appendJumpTargets(this, opcodeIDs[i], instructionOffsets[i], jsrReturnOffsets, targets);
+        if (endsBlock || targets.size()) {
+            leaders.append(targets.data(), targets.size());
+            if (i + 1 < instructionOffsets.size())
+                leaders.append(instructionOffsets[i + 1]);
+        }
+    }
+    for (size_t i = 0; i < numberOfExceptionHandlers(); ++i)
+        leaders.append(exceptionHandler(i).target);
+    std::sort(leaders.begin(), leaders.end());
+    leaders.shrink(std::unique(leaders.begin(), leaders.end()) - leaders.begin());
+
+    // Blocks are numbered by leader; block b holds the instructions in
+    // [firstInstruction[b], firstInstruction[b + 1]).
+    size_t numBlocks = leaders.size();
+    Vector<size_t> firstInstruction(numBlocks + 1);
+    for (size_t i = 0, b = 0; i < instructionOffsets.size(); ++i) {
+        if (b < numBlocks && instructionOffsets[i] == leaders[b])
+            firstInstruction[b++] = i;
+    }
+    ASSERT(firstInstruction[numBlocks - 1] < instructionOffsets.size() && instructionOffsets[firstInstruction[numBlocks - 1]] == leaders[numBlocks - 1]);
+    firstInstruction[numBlocks] = instructionOffsets.size();
+
+    Vector<size_t> successorStart(numBlocks + 1);
+    Vector<size_t> successors;
+    for (size_t b = 0; b < numBlocks; ++b) {
+        successorStart[b] = successors.size();
+        size_t last = firstInstruction[b + 1] - 1;
+        targets.shrink(0);
+        if (!appendJumpTargets(this, opcodeIDs[last], instructionOffsets[last], jsrReturnOffsets, targets) && b + 1 < numBlocks)
+            successors.append(b + 1);
+        for (size_t i = 0; i < targets.size(); ++i)
+            successors.append(std::lower_bound(leaders.begin(), leaders.end(), targets[i]) - leaders.begin());
+    }
+    successorStart[numBlocks] = successors.size();
+
+    Vector<size_t> handlerBlocks(numberOfExceptionHandlers());
+    for (size_t i = 0; i < handlerBlocks.size(); ++i)
+        handlerBlocks[i] = std::lower_bound(leaders.begin(), leaders.end(), exceptionHandler(i).target) - leaders.begin();
+
+    int numTemporaries = m_numCalleeRegisters - m_numVars;
+    unsigned words = liveTemporaryWords();
+    Vector<uint32_t> liveIn;
+    liveIn.fill(0, numBlocks * words);
+    Vector<uint32_t> live(words);
+    TemporarySet liveSet(live.data(), m_numVars, numTemporaries);
+
+    // Standard backwards dataflow to a fixed point. An instruction inside a
+    // try range may also leave through its handler, so everything live into
+    // the handler is live before it. The call sites seen on the last pass,
+    // which changed nothing, have their final live sets.
+    Vector<unsigned> callSiteOffsets;
+    Vector<uint32_t> callSiteLiveTemporaries;
+    for (bool changed = true; changed; ) {
+        changed = false;
+        callSiteOffsets.shrink(0);
+        callSiteLiveTemporaries.shrink(0);
+        for (size_t b = numBlocks; b--; ) {
+            memset(live.data(), 0, words * sizeof(uint32_t));
+            for (size_t s = successorStart[b]; s < successorStart[b + 1]; ++s) {
+                for (unsigned w = 0; w < words; ++w)
+                    live[w] |= liveIn[successors[s] * words + w];
+            }
+            for (size_t i = firstInstruction[b + 1]; i-- > firstInstruction[b]; ) {
+                unsigned offset = instructionOffsets[i];
+                for (size_t h = 0; h < handlerBlocks.size(); ++h) {
+                    HandlerInfo& handler = exceptionHandler(h);
+                    if (handler.start <= offset && handler.end >= offset) {
+                        for (unsigned w = 0; w < words; ++w)
+                            live[w] |= liveIn[handlerBlocks[h] * words + w];
+                    }
+                }
+                if (isCallSite(opcodeIDs[i])) {
+                    callSiteOffsets.append(offset + opcodeLengths[opcodeIDs[i]]);
+                    callSiteLiveTemporaries.append(live.data(), words);
+                }
+                computeLiveBefore(opcodeIDs[i], m_instructions.begin() + offset, liveSet);
+            }
+            if (memcmp(live.data(), liveIn.data() + b * words, words * sizeof(uint32_t))) {
+                memcpy(liveIn.data() + b * words, live.data(), words * sizeof(uint32_t));
+                changed = true;
+            }
+        }
+    }
+
+    // The passes run backwards, so the call sites were found in reverse order.
+    m_callSiteBytecodeOffsets.reserveCapacity(callSiteOffsets.size());
+    m_callSiteLiveTemporaries.reserveCapacity(callSiteLiveTemporaries.size());
+    for (size_t i = callSiteOffsets.size(); i--; ) {
+        m_callSiteBytecodeOffsets.append(callSiteOffsets[i]);
+        m_callSiteLiveTemporaries.append(callSiteLiveTemporaries.data() + i * words, words);
+    }
+}
+
+const uint32_t* CodeBlock::liveTemporariesAtCallReturn(unsigned bytecodeOffset) const
+{
+    int low = 0;
+    int high = m_callSiteBytecodeOffsets.size();
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (m_callSiteBytecodeOffsets[mid] <= bytecodeOffset)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    if (!low || m_callSiteBytecodeOffsets[low - 1] != bytecodeOffset)
+        return 0;
+    return m_callSiteLiveTemporaries.data() + (low - 1) * liveTemporaryWords();
+}
+
+#if ENABLE(JIT)
+bool CodeBlock::bytecodeOffsetForCallReturn(ReturnAddressPtr returnAddress, unsigned& bytecodeOffset)
+{
+    if (!m_jitCode)
+        return false;
+    uintptr_t callReturnOffset = reinterpret_cast<uintptr_t>(returnAddress.value()) - reinterpret_cast<uintptr_t>(m_jitCode.addressForCall().executableAddress());
+    if (callReturnOffset >= m_jitCode.size())
+        return false;
+
+    int low = 0;
+    int high = m_callSiteReturnOffsets.size();
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (m_callSiteReturnOffsets[mid].callReturnOffset <= callReturnOffset)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    if (!low || m_callSiteReturnOffsets[low - 1].callReturnOffset != callReturnOffset)
+        return false;
+    bytecodeOffset = m_callSiteReturnOffsets[low - 1].bytecodeIndex;
+    return true;
+}
+#endif
+
+#if ENABLE(JIT_OPTIMIZING_TIER) || ENABLE(INTERPRETER_OSR)
+static OSRPoint* findOSRPoint(Vector<OSRPoint>& osrPoints, unsigned bytecodeIndex)
+{
+    int low = 0;
+    int high = osrPoints.size();
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (osrPoints[mid].bytecodeIndex < bytecodeIndex)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    if (low == static_cast<int>(osrPoints.size()) || osrPoints[low].bytecodeIndex != bytecodeIndex)
+        return 0;
+    return &osrPoints[low];
+}
+#endif
+
+#if ENABLE(JIT_OPTIMIZING_TIER)
+OSRPoint* CodeBlock::osrPointForBytecodeIndex(unsigned bytecodeIndex)
+{
+    return findOSRPoint(m_osrPoints, bytecodeIndex);
+}
+#endif
+
+#if ENABLE(INTERPRETER_OSR)
+OSRPoint* CodeBlock::loopEntryPointForBytecodeIndex(unsigned bytecodeIndex)
+{
+    return findOSRPoint(m_loopEntryPoints, bytecodeIndex);
+}
+#endif
+
+#if ENABLE(VALUE_PROFILER)
+ValueProfile* CodeBlock::valueProfileForBytecodeOffset(unsigned bytecodeOffset)
+{
+    int low = 0;
+    int high = m_valueProfiles.size();
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (m_valueProfiles[mid].bytecodeOffset < bytecodeOffset)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    if (low == static_cast<int>(m_valueProfiles.size()) || m_valueProfiles[low].bytecodeOffset != bytecodeOffset)
+        return 0;
+    return &m_valueProfiles[low];
+}
+
+void CodeBlock::dumpValueProfiles() const
+{
+    printf("%lu value profiles for CodeBlock %p\n", static_cast<unsigned long>(m_valueProfiles.size()), this);
+    for (size_t i = 0; i < m_valueProfiles.size(); ++i) {
+        const ValueProfile& profile = m_valueProfiles[i];
+        printf("[%4d] %s:%s %u samples: int32 %u, double %u, string %u, cell %u, other %u", profile.bytecodeOffset, opcodeNames[profile.opcodeID], padOpcodeName(profile.opcodeID, 16), profile.numberOfSamples(),
+            profile.counts[ValueProfile::Int32Value], profile.counts[ValueProfile::DoubleValue], profile.counts[ValueProfile::StringValue], profile.counts[ValueProfile::CellValue], profile.counts[ValueProfile::OtherValue]);
+        for (unsigned j = 0; j < ValueProfile::numberOfStructureBuckets && profile.structures[j]; ++j)
+            printf("%s%p x %u", j ? ", " : " (structures ", profile.structures[j], profile.structureCounts[j]);
+        if (profile.polymorphicCount)
+            printf(", %u with other structures", profile.polymorphicCount);
+        if (profile.structures[0])
+            printf(")");
+        printf("\n");
+    }
+}
+
+void ValueProfile::observe(JSValue value)
+{
+    if (value.isInt32())
+        ++counts[Int32Value];
+    else if (value.isNumber())
+        ++counts[DoubleValue];
+    else if (value.isString())
+        ++counts[StringValue];
+    else if (value.isCell())
+        observeCell(value.asCell());
+    else
+        ++counts[OtherValue];
+}
+
+void ValueProfile::observeCell(JSCell* cell)
+{
+    ++counts[CellValue];
+    Structure* structure = cell->structure();
+    for (unsigned i = 0; i < numberOfStructureBuckets; ++i) {
+        if (structures[i] == structure) {
+            ++structureCounts[i];
+            return;
+        }
+        if (!structures[i]) {
+            structure->ref();
+            structures[i] = structure;
+            structureCounts[i] = 1;
+            return;
+        }
+    }
+    ++polymorphicCount;
+}
+
+void ValueProfile::deref()
+{
+    for (unsigned i = 0; i < numberOfStructureBuckets && structures[i]; ++i)
+        structures[i]->deref();
+}
+
+unsigned ValueProfile::numberOfSamples() const
+{
+    unsigned samples = 0;
+    for (unsigned i = 0; i < NumberOfValueKinds; ++i)
+        samples += counts[i];
+    return samples;
+}
+#endif
+
 void CodeBlock::shrinkToFit()
 {
     m_instructions.shrinkToFit();
@@ -1718,11 +2338,19 @@ void CodeBlock::shrinkToFit()
     m_callLinkInfos.shrinkToFit();
     m_linkedCallerList.shrinkToFit();
 #endif
+#if ENABLE(VALUE_PROFILER)
+    m_valueProfiles.shrinkToFit();
+#endif
 
     m_identifiers.shrinkToFit();
     m_functionDecls.shrinkToFit();
     m_functionExprs.shrinkToFit();
     m_constantRegisters.shrinkToFit();
+    m_callSiteBytecodeOffsets.shrinkToFit();
+    m_callSiteLiveTemporaries.shrinkToFit();
+#if ENABLE(JIT)
+    m_callSiteReturnOffsets.shrinkToFit();
+#endif
 
     if (m_exceptionInfo) {
         m_exceptionInfo->m_expressionInfo.shrinkToFit();
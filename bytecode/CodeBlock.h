@@ -200,6 +200,25 @@ namespace JSC {
         unsigned bytecodeIndex;
     };
 
+#if ENABLE(JIT_OPTIMIZING_TIER) || ENABLE(INTERPRETER_OSR)
+    // A point at which a running frame can switch between the baseline and the
+    // optimized code for its function: the instructions optimized code may bail
+    // out to in baseline code, and the loop headers of optimized code. Frames
+    // the interpreter is running also enter baseline code at its loop headers.
+    struct OSRPoint {
+        OSRPoint(unsigned bytecodeIndex, CodeLocationLabel machineCode, int cachedResultRegister)
+            : bytecodeIndex(bytecodeIndex)
+            , machineCode(machineCode)
+            , cachedResultRegister(cachedResultRegister)
+        {
+        }
+
+        unsigned bytecodeIndex;
+        CodeLocationLabel machineCode;
+        int cachedResultRegister; // Virtual register baseline code expects in its cached result register, or INT_MAX.
+    };
+#endif
+
     // valueAtPosition helpers for the binaryChop algorithm below.
 
     inline void* getStructureStubInfoReturnLocation(StructureStubInfo* structureStubInfo)
@@ -259,6 +278,44 @@ namespace JSC {
     }
 #endif
 
+#if ENABLE(VALUE_PROFILER)
+    // Counts the kinds of value one instruction has produced. The interpreter and
+    // baseline JIT code fill these in; the optimizing tier reads them to decide
+    // what is worth speculating on.
+    struct ValueProfile {
+        enum ValueKind { Int32Value, DoubleValue, StringValue, CellValue, OtherValue, NumberOfValueKinds };
+        static const unsigned numberOfStructureBuckets = 4;
+
+        ValueProfile(unsigned bytecodeOffset, OpcodeID opcodeID)
+            : bytecodeOffset(bytecodeOffset)
+            , opcodeID(opcodeID)
+            , polymorphicCount(0)
+        {
+            for (unsigned i = 0; i < NumberOfValueKinds; ++i)
+                counts[i] = 0;
+            for (unsigned i = 0; i < numberOfStructureBuckets; ++i) {
+                structures[i] = 0;
+                structureCounts[i] = 0;
+            }
+        }
+
+        void observe(JSValue);
+        void observeCell(JSCell*);
+        void deref();
+
+        unsigned numberOfSamples() const;
+        bool hasOnlyInt32Samples() const { return counts[Int32Value] == numberOfSamples(); }
+        bool hasOnlyNumberSamples() const { return counts[Int32Value] + counts[DoubleValue] == numberOfSamples(); }
+
+        unsigned bytecodeOffset;
+        OpcodeID opcodeID;
+        unsigned counts[NumberOfValueKinds];
+        Structure* structures[numberOfStructureBuckets]; // Non-string cells, in the order first seen.
+        unsigned structureCounts[numberOfStructureBuckets];
+        unsigned polymorphicCount; // Non-string cells whose structure found no free bucket.
+    };
+#endif
+
     struct ExceptionInfo : FastAllocBase {
         Vector<ExpressionRangeInfo> m_expressionInfo;
         Vector<LineInfo> m_lineInfo;
@@ -270,6 +327,7 @@ namespace JSC {
     };
 
     class CodeBlock : public FastAllocBase {
+        friend class BytecodeCache;
         friend class JIT;
     protected:
         CodeBlock(ScriptExecutable* ownerExecutable, CodeType, PassRefPtr<SourceProvider>, unsigned sourceOffset, SymbolTable* symbolTable);
@@ -350,7 +408,7 @@ namespace JSC {
         unsigned getBytecodeIndex(CallFrame* callFrame, ReturnAddressPtr returnAddress)
         {
             reparseForExceptionInfoIfNecessary(callFrame);
-            return binaryChop<CallReturnOffsetToBytecodeIndex, unsigned, getCallReturnOffset>(callReturnIndexVector().begin(), callReturnIndexVector().size(), ownerExecutable()->generatedJITCode().offsetOf(returnAddress.value()))->bytecodeIndex;
+            return binaryChop<CallReturnOffsetToBytecodeIndex, unsigned, getCallReturnOffset>(callReturnIndexVector().begin(), callReturnIndexVector().size(), m_jitCode.offsetOf(returnAddress.value()))->bytecodeIndex;
         }
         
         bool functionRegisterForBytecodeOffset(unsigned bytecodeOffset, int& functionRegisterIndex);
@@ -360,6 +418,13 @@ namespace JSC {
         {
             return static_cast<Instruction*>(returnAddress) - instructions().begin();
         }
+
+        // Interpreted and JIT frames of the same code can be on the stack at once.
+        // A frame is being interpreted if its callee returns into its bytecode.
+        bool isInterpreterReturnAddress(Instruction* returnAddress)
+        {
+            return returnAddress >= m_instructions.begin() && returnAddress < m_instructions.end();
+        }
 #endif
 
         void setIsNumericCompareFunction(bool isNumericCompareFunction) { m_isNumericCompareFunction = isNumericCompareFunction; }
@@ -374,8 +439,9 @@ namespace JSC {
 #endif
 
 #if ENABLE(JIT)
-        JITCode& getJITCode() { return ownerExecutable()->generatedJITCode(); }
-        ExecutablePool* executablePool() { return ownerExecutable()->getExecutablePool(); }
+        void setJITCode(const JITCode& jitCode) { m_jitCode = jitCode; }
+        JITCode& getJITCode() { return m_jitCode; }
+        ExecutablePool* executablePool() { return m_jitCode.getExecutablePool(); }
 #endif
 
         ScriptExecutable* ownerExecutable() const { return m_ownerExecutable; }
@@ -425,6 +491,46 @@ namespace JSC {
 
         void addFunctionRegisterInfo(unsigned bytecodeOffset, int functionIndex) { createRareDataIfNecessary(); m_rareData->m_functionRegisterInfos.append(FunctionRegisterInfo(bytecodeOffset, functionIndex)); }
 #endif
+#if ENABLE(VALUE_PROFILER)
+        void addValueProfile(unsigned bytecodeOffset, OpcodeID opcodeID) { m_valueProfiles.append(ValueProfile(bytecodeOffset, opcodeID)); }
+        size_t numberOfValueProfiles() const { return m_valueProfiles.size(); }
+        ValueProfile& valueProfile(int index) { return m_valueProfiles[index]; }
+        ValueProfile* valueProfileForBytecodeOffset(unsigned bytecodeOffset);
+        void dumpValueProfiles() const;
+#endif
+#if ENABLE(JIT_OPTIMIZING_TIER)
+        // Baseline code counts function entries and loop iterations up towards
+        // zero, and asks for optimized code when the counter gets there.
+        void optimizeAfter(unsigned executions) { m_optimizationCounter = -static_cast<int32_t>(std::min<unsigned>(executions, std::numeric_limits<int32_t>::max())); }
+        void optimizeNever() { m_optimizationCounter = std::numeric_limits<int32_t>::min(); }
+        int32_t* addressOfOptimizationCounter() { return &m_optimizationCounter; }
+
+        // Counted by optimized code each time it bails out to the baseline code.
+        unsigned speculationFailures() const { return m_speculationFailures; }
+        unsigned* addressOfSpeculationFailures() { return &m_speculationFailures; }
+
+        void addOSRPoint(const OSRPoint& osrPoint) { m_osrPoints.append(osrPoint); }
+        OSRPoint* osrPointForBytecodeIndex(unsigned bytecodeIndex);
+
+        // Optimized code guards the calls it inlines on the callee's executable,
+        // and the property loads in them on a structure; both must outlive it.
+        void addInlinedExecutable(PassRefPtr<FunctionExecutable> executable) { m_inlinedExecutables.append(executable); }
+        void addInlinedStructure(PassRefPtr<Structure> structure) { m_inlinedStructures.append(structure); }
+#endif
+#if ENABLE(INTERPRETER_OSR)
+        // The interpreter counts calls and loop iterations up towards zero. A loop
+        // header enters the JIT code when the counter gets there; a call does once
+        // the counter is anywhere past it.
+        void jitAfter(unsigned iterations) { m_jitExecutionCounter = -static_cast<int32_t>(std::min<unsigned>(iterations, std::numeric_limits<int32_t>::max())); }
+        void jitNever() { m_jitExecutionCounter = std::numeric_limits<int32_t>::min(); }
+        bool checkIfJITThresholdReached() { return !++m_jitExecutionCounter; }
+        bool checkIfJITThresholdReachedOnCall() { return ++m_jitExecutionCounter >= 0; }
+
+        // Entry points into the baseline code that set up a frame the interpreter
+        // has been running and jump to a loop header.
+        void addLoopEntryPoint(const OSRPoint& entryPoint) { m_loopEntryPoints.append(entryPoint); }
+        OSRPoint* loopEntryPointForBytecodeIndex(unsigned bytecodeIndex);
+#endif
 
         // Exception handling support
 
@@ -447,6 +553,24 @@ namespace JSC {
         Vector<CallReturnOffsetToBytecodeIndex>& callReturnIndexVector() { ASSERT(m_exceptionInfo); return m_exceptionInfo->m_callReturnIndexVector; }
 #endif
 
+        // Call site liveness
+
+        // Records, for every call site, which temporaries may still be read once
+        // the call returns. Frames suspended in a call are marked from this map
+        // instead of conservatively (see RegisterFile::markCallFrames).
+        void computeCallSiteLiveness();
+        unsigned liveTemporaryWords() const { return (m_numCalleeRegisters - m_numVars + 31) / 32; }
+        // bytecodeOffset is the offset of the instruction following the call,
+        // which is where the callee returns to. Returns 0 if it is not a call site.
+        const uint32_t* liveTemporariesAtCallReturn(unsigned bytecodeOffset) const;
+
+#if ENABLE(JIT)
+        // Unlike callReturnIndexVector(), this survives clearExceptionInfo(): the
+        // collector needs it and cannot reparse.
+        void addCallSiteReturnOffset(unsigned callReturnOffset, unsigned bytecodeOffset) { m_callSiteReturnOffsets.append(CallReturnOffsetToBytecodeIndex(callReturnOffset, bytecodeOffset)); }
+        bool bytecodeOffsetForCallReturn(ReturnAddressPtr, unsigned& bytecodeOffset);
+#endif
+
         // Constant Pool
 
         size_t numberOfIdentifiers() const { return m_identifiers.size(); }
@@ -547,10 +671,31 @@ namespace JSC {
         Vector<CallLinkInfo> m_callLinkInfos;
         Vector<MethodCallLinkInfo> m_methodCallLinkInfos;
         Vector<CallLinkInfo*> m_linkedCallerList;
+        JITCode m_jitCode;
+#endif
+#if ENABLE(VALUE_PROFILER)
+        Vector<ValueProfile> m_valueProfiles;
+#endif
+#if ENABLE(JIT_OPTIMIZING_TIER)
+        int32_t m_optimizationCounter;
+        unsigned m_speculationFailures;
+        Vector<OSRPoint> m_osrPoints;
+        Vector<RefPtr<FunctionExecutable> > m_inlinedExecutables;
+        Vector<RefPtr<Structure> > m_inlinedStructures;
+#endif
+#if ENABLE(INTERPRETER_OSR)
+        int32_t m_jitExecutionCounter;
+        Vector<OSRPoint> m_loopEntryPoints;
 #endif
 
         Vector<unsigned> m_jumpTargets;
 
+        Vector<unsigned> m_callSiteBytecodeOffsets;
+        Vector<uint32_t> m_callSiteLiveTemporaries; // liveTemporaryWords() per call site.
+#if ENABLE(JIT)
+        Vector<CallReturnOffsetToBytecodeIndex> m_callSiteReturnOffsets;
+#endif
+
         // Constant Pool
         Vector<Identifier> m_identifiers;
         Vector<Register> m_constantRegisters;
@@ -37,6 +37,11 @@
 
 #define POLYMORPHIC_LIST_CACHE_SIZE 8
 
+// The number of Structures a put_by_id caches stubs for before it stops adding more.
+#ifndef POLYMORPHIC_PUT_LIST_CACHE_SIZE
+#define POLYMORPHIC_PUT_LIST_CACHE_SIZE 8
+#endif
+
 namespace JSC {
 
     // *Sigh*, If the JIT is enabled we need to track the stubRountine (of type CodeLocationLabel),
@@ -122,6 +127,59 @@ namespace JSC {
         }
     };
 
+    // Structure used by polymorphic put_by_id stubs to hold data off the main code stream. An entry
+    // that adds a property holds the Structures before and after the put; one that replaces a
+    // property holds only the first.
+    struct PolymorphicPutByIdList : FastAllocBase {
+        struct PutByIdStubInfo {
+            PolymorphicAccessStructureListStubRoutineType stubRoutine;
+            Structure* oldStructure;
+            Structure* newStructure;
+            StructureChain* chain;
+
+            void set(PolymorphicAccessStructureListStubRoutineType _stubRoutine, Structure* _structure)
+            {
+                stubRoutine = _stubRoutine;
+                oldStructure = _structure;
+                newStructure = 0;
+                chain = 0;
+            }
+
+            void set(PolymorphicAccessStructureListStubRoutineType _stubRoutine, Structure* _oldStructure, Structure* _newStructure, StructureChain* _chain)
+            {
+                stubRoutine = _stubRoutine;
+                oldStructure = _oldStructure;
+                newStructure = _newStructure;
+                chain = _chain;
+            }
+        } list[POLYMORPHIC_PUT_LIST_CACHE_SIZE];
+
+        PolymorphicPutByIdList(PolymorphicAccessStructureListStubRoutineType stubRoutine, Structure* firstStructure)
+        {
+            list[0].set(stubRoutine, firstStructure);
+        }
+
+        PolymorphicPutByIdList(PolymorphicAccessStructureListStubRoutineType stubRoutine, Structure* firstOldStructure, Structure* firstNewStructure, StructureChain* firstChain)
+        {
+            list[0].set(stubRoutine, firstOldStructure, firstNewStructure, firstChain);
+        }
+
+        void derefStructures(int count)
+        {
+            for (int i = 0; i < count; ++i) {
+                PutByIdStubInfo& info = list[i];
+
+                ASSERT(info.oldStructure);
+                info.oldStructure->deref();
+
+                if (info.newStructure) {
+                    info.newStructure->deref();
+                    info.chain->deref();
+                }
+            }
+        }
+    };
+
     struct Instruction {
         Instruction(Opcode opcode)
         {
@@ -43,6 +43,7 @@ namespace JSC {
         access_get_by_id_proto_list,
         access_put_by_id_transition,
         access_put_by_id_replace,
+        access_put_by_id_list,
         access_get_by_id,
         access_put_by_id,
         access_get_by_id_generic,
@@ -128,6 +129,14 @@ namespace JSC {
             baseObjectStructure->ref();
         }
 
+        void initPutByIdList(PolymorphicPutByIdList* structureList, int listSize)
+        {
+            accessType = access_put_by_id_list;
+
+            u.putByIdList.structureList = structureList;
+            u.putByIdList.listSize = listSize;
+        }
+
         void deref();
 
         bool seenOnce()
@@ -171,6 +180,10 @@ namespace JSC {
             struct {
                 Structure* baseObjectStructure;
             } putByIdReplace;
+            struct {
+                PolymorphicPutByIdList* structureList;
+                int listSize;
+            } putByIdList;
         } u;
 
         CodeLocationLabel stubRoutine;
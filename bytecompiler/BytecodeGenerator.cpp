@@ -155,6 +155,9 @@ void BytecodeGenerator::generate()
         
     m_codeBlock->setIsNumericCompareFunction(instructions() == m_globalData->numericCompareFunction(m_scopeChain->globalObject()->globalExec()));
 
+    if (!m_regeneratingForExceptionInfo)
+        m_codeBlock->computeCallSiteLiveness();
+
 #if !ENABLE(OPCODE_SAMPLING)
     if (!m_regeneratingForExceptionInfo && (m_codeType == FunctionCode || m_codeType == EvalCode))
         m_codeBlock->clearExceptionInfo();
@@ -222,6 +225,7 @@ BytecodeGenerator::BytecodeGenerator(ProgramNode* programNode, const Debugger* d
     , m_emitNodeDepth(0)
     , m_regeneratingForExceptionInfo(false)
     , m_codeBlockBeingRegeneratedFrom(0)
+    , m_scopedPropertyLookups(0)
 {
     if (m_shouldEmitDebugHooks)
         m_codeBlock->setNeedsFullScopeChain(true);
@@ -306,6 +310,7 @@ BytecodeGenerator::BytecodeGenerator(FunctionBodyNode* functionBody, const Debug
     , m_emitNodeDepth(0)
     , m_regeneratingForExceptionInfo(false)
     , m_codeBlockBeingRegeneratedFrom(0)
+    , m_scopedPropertyLookups(0)
 {
     if (m_shouldEmitDebugHooks)
         m_codeBlock->setNeedsFullScopeChain(true);
@@ -389,6 +394,7 @@ BytecodeGenerator::BytecodeGenerator(EvalNode* evalNode, const Debugger* debugge
     , m_emitNodeDepth(0)
     , m_regeneratingForExceptionInfo(false)
     , m_codeBlockBeingRegeneratedFrom(0)
+    , m_scopedPropertyLookups(0)
 {
     if (m_shouldEmitDebugHooks || m_baseScopeDepth)
         m_codeBlock->setNeedsFullScopeChain(true);
@@ -821,6 +827,7 @@ RegisterID* BytecodeGenerator::addConstantValue(JSValue v)
         m_constantPoolRegisters.append(FirstConstantRegisterIndex + m_nextConstantOffset);
         ++m_nextConstantOffset;
         m_codeBlock->addConstantRegister(JSValue(v));
+        m_globalData->heap.addNurseryRoot(v);
     } else
         index = result.first->second;
 
@@ -880,6 +887,10 @@ RegisterID* BytecodeGenerator::emitPostDec(RegisterID* dst, RegisterID* srcDst)
 
 RegisterID* BytecodeGenerator::emitBinaryOp(OpcodeID opcodeID, RegisterID* dst, RegisterID* src1, RegisterID* src2, OperandTypes types)
 {
+#if ENABLE(VALUE_PROFILER)
+    if (opcodeID == op_add || opcodeID == op_sub || opcodeID == op_mul || opcodeID == op_div || opcodeID == op_mod)
+        m_codeBlock->addValueProfile(instructions().size(), opcodeID);
+#endif
     emitOpcode(opcodeID);
     instructions().append(dst->index());
     instructions().append(src1->index());
@@ -1005,10 +1016,20 @@ bool BytecodeGenerator::findScopedProperty(const Identifier& property, int& inde
         return false;
     }
 
+    bool found = lookUpScopedProperty(*m_scopeChain, property, index, stackDepth, forWriting, requiresDynamicChecks, globalObject);
+    if (m_scopedPropertyLookups) {
+        ScopedPropertyLookup lookup = { property, forWriting, found, index, stackDepth, requiresDynamicChecks, !!globalObject };
+        m_scopedPropertyLookups->append(lookup);
+    }
+    return found;
+}
+
+bool BytecodeGenerator::lookUpScopedProperty(const ScopeChain& scopeChain, const Identifier& property, int& index, size_t& stackDepth, bool forWriting, bool& requiresDynamicChecks, JSObject*& globalObject)
+{
     size_t depth = 0;
     requiresDynamicChecks = false;
-    ScopeChainIterator iter = m_scopeChain->begin();
-    ScopeChainIterator end = m_scopeChain->end();
+    ScopeChainIterator iter = scopeChain.begin();
+    ScopeChainIterator end = scopeChain.end();
     for (; iter != end; ++iter, ++depth) {
         JSObject* currentScope = *iter;
         if (!currentScope->isVariableObject())
@@ -1235,6 +1256,9 @@ RegisterID* BytecodeGenerator::emitGetById(RegisterID* dst, RegisterID* base, co
 #else
     m_codeBlock->addPropertyAccessInstruction(instructions().size());
 #endif
+#if ENABLE(VALUE_PROFILER)
+    m_codeBlock->addValueProfile(instructions().size(), op_get_by_id);
+#endif
 
     emitOpcode(op_get_by_id);
     instructions().append(dst->index());
@@ -1329,6 +1353,9 @@ RegisterID* BytecodeGenerator::emitGetByVal(RegisterID* dst, RegisterID* base, R
             return dst;
         }
     }
+#if ENABLE(VALUE_PROFILER)
+    m_codeBlock->addValueProfile(instructions().size(), op_get_by_val);
+#endif
     emitOpcode(op_get_by_val);
     instructions().append(dst->index());
     instructions().append(base->index());
@@ -1486,6 +1513,9 @@ RegisterID* BytecodeGenerator::emitCall(OpcodeID opcodeID, RegisterID* dst, Regi
 #endif
 
     // Emit call.
+#if ENABLE(VALUE_PROFILER)
+    m_codeBlock->addValueProfile(instructions().size(), opcodeID);
+#endif
     emitOpcode(opcodeID);
     instructions().append(dst->index()); // dst
     instructions().append(func->index()); // func
@@ -1531,6 +1561,9 @@ RegisterID* BytecodeGenerator::emitCallVarargs(RegisterID* dst, RegisterID* func
     emitExpressionInfo(divot, startOffset, endOffset);
     
     // Emit call.
+#if ENABLE(VALUE_PROFILER)
+    m_codeBlock->addValueProfile(instructions().size(), op_call_varargs);
+#endif
     emitOpcode(op_call_varargs);
     instructions().append(dst->index()); // dst
     instructions().append(func->index()); // func
@@ -68,6 +68,18 @@ namespace JSC {
         RefPtr<RegisterID> propertyRegister;
     };
 
+    // What a search of the scope chain found out about a property. Unlike the rest
+    // of the bytecode, this depends on the scope chain the code is compiled in.
+    struct ScopedPropertyLookup {
+        Identifier property;
+        bool forWriting;
+        bool found;
+        int index;
+        size_t depth;
+        bool requiresDynamicChecks;
+        bool foundGlobalObject;
+    };
+
     class BytecodeGenerator : public FastAllocBase {
     public:
         typedef DeclarationStacks::VarStack VarStack;
@@ -107,6 +119,10 @@ namespace JSC {
         // NB: depth does _not_ include the local scope.  eg. a depth of 0 refers
         // to the scope containing this codeblock.
         bool findScopedProperty(const Identifier&, int& index, size_t& depth, bool forWriting, bool& includesDynamicScopes, JSObject*& globalObject);
+        static bool lookUpScopedProperty(const ScopeChain&, const Identifier&, int& index, size_t& depth, bool forWriting, bool& includesDynamicScopes, JSObject*& globalObject);
+
+        // Records every search of the scope chain findScopedProperty makes from now on.
+        void recordScopedPropertyLookups(Vector<ScopedPropertyLookup>* lookups) { m_scopedPropertyLookups = lookups; }
 
         // Returns the register storing "this"
         RegisterID* thisRegister() { return &m_thisRegister; }
@@ -523,6 +539,7 @@ namespace JSC {
 
         bool m_regeneratingForExceptionInfo;
         CodeBlock* m_codeBlockBeingRegeneratedFrom;
+        Vector<ScopedPropertyLookup>* m_scopedPropertyLookups;
 
         static const unsigned s_maxEmitNodeDepth = 3000;
 
@@ -87,6 +87,50 @@ namespace JSC {
     }
 #endif
 
+// Each entry into JavaScript starts a new chain of frames. This saves the
+// running frame of the chain it interrupts and restores it on the way out.
+class TopCallFrameScope : public Noncopyable {
+public:
+    TopCallFrameScope(RegisterFile& registerFile)
+        : m_registerFile(registerFile)
+    {
+        m_registerFile.saveTopCallFrame();
+    }
+
+    ~TopCallFrameScope()
+    {
+        m_registerFile.restoreTopCallFrame();
+    }
+
+private:
+    RegisterFile& m_registerFile;
+};
+
+#if ENABLE(INTERPRETER)
+// The interpreter caches property accesses by rewriting instructions. Code the
+// JIT may yet compile has to keep the instructions the bytecode generator
+// emitted, and a CodeBlock built for the JIT would never release the Structures
+// such caches hold, so code runs uncached in the interpreter while the JIT is on.
+static inline bool canCacheInInstructions(CallFrame* callFrame)
+{
+#if ENABLE(INTERPRETER_OSR)
+    return !callFrame->globalData().canUseJIT();
+#else
+    UNUSED_PARAM(callFrame);
+    return true;
+#endif
+}
+#endif
+
+#if ENABLE(INTERPRETER_OSR)
+// Counts a call made from the interpreter or the host while the JIT is on, and
+// says whether the callee should run in JIT code, compiling it if need be.
+static inline bool shouldCallInJITCode(FunctionExecutable* functionExecutable, CodeBlock* codeBlock)
+{
+    return functionExecutable->hasJITCode() || codeBlock->checkIfJITThresholdReachedOnCall();
+}
+#endif
+
 // Returns the depth of the scope chain within a given call frame.
 static int depth(CodeBlock* codeBlock, ScopeChain& sc)
 {
@@ -181,7 +225,7 @@ NEVER_INLINE bool Interpreter::resolveGlobal(CallFrame* callFrame, Instruction*
     PropertySlot slot(globalObject);
     if (globalObject->getPropertySlot(callFrame, ident, slot)) {
         JSValue result = slot.getValue(callFrame, ident);
-        if (slot.isCacheableValue() && !globalObject->structure()->isUncacheableDictionary() && slot.slotBase() == globalObject) {
+        if (slot.isCacheableValue() && !globalObject->structure()->isUncacheableDictionary() && slot.slotBase() == globalObject && canCacheInInstructions(callFrame)) {
             if (vPC[4].u.structure)
                 vPC[4].u.structure->deref();
             globalObject->structure()->ref();
@@ -251,7 +295,7 @@ NEVER_INLINE bool Interpreter::resolveGlobalDynamic(CallFrame* callFrame, Instru
     PropertySlot slot(globalObject);
     if (globalObject->getPropertySlot(callFrame, ident, slot)) {
         JSValue result = slot.getValue(callFrame, ident);
-        if (slot.isCacheableValue() && !globalObject->structure()->isUncacheableDictionary() && slot.slotBase() == globalObject) {
+        if (slot.isCacheableValue() && !globalObject->structure()->isUncacheableDictionary() && slot.slotBase() == globalObject && canCacheInInstructions(callFrame)) {
             if (vPC[4].u.structure)
                 vPC[4].u.structure->deref();
             globalObject->structure()->ref();
@@ -569,7 +613,7 @@ NEVER_INLINE bool Interpreter::unwindCallFrame(CallFrame*& callFrame, JSValue ex
     codeBlock = callerFrame->codeBlock();
 #if ENABLE(JIT)
 #if ENABLE(INTERPRETER)
-    if (callerFrame->globalData().canUseJIT())
+    if (callerFrame->globalData().canUseJIT() && !codeBlock->isInterpreterReturnAddress(callFrame->returnVPC()))
 #endif
         bytecodeOffset = bytecodeOffsetForPC(callerFrame, codeBlock, callFrame->returnPC());
 #if ENABLE(INTERPRETER)
@@ -690,6 +734,7 @@ JSValue Interpreter::execute(ProgramExecutable* program, CallFrame* callFrame, S
         }
     }
 
+    TopCallFrameScope topCallFrameScope(m_registerFile);
     CodeBlock* codeBlock = &program->bytecode(callFrame, scopeChain);
 
     Register* oldEnd = m_registerFile.end();
@@ -708,6 +753,7 @@ JSValue Interpreter::execute(ProgramExecutable* program, CallFrame* callFrame, S
     CallFrame* newCallFrame = CallFrame::create(oldEnd + codeBlock->m_numParameters + RegisterFile::CallFrameHeaderSize);
     newCallFrame->r(codeBlock->thisRegister()) = JSValue(thisObj);
     newCallFrame->init(codeBlock, 0, scopeChain, CallFrame::noCaller(), 0, 0, 0);
+    m_registerFile.setTopCallFrame(newCallFrame);
 
     if (codeBlock->needsFullScopeChain())
         scopeChain->ref();
@@ -722,6 +768,15 @@ JSValue Interpreter::execute(ProgramExecutable* program, CallFrame* callFrame, S
 
         m_reentryDepth++;  
 #if ENABLE(JIT)
+#if ENABLE(INTERPRETER_OSR)
+        // Global code mostly runs once, so it starts in the interpreter and is
+        // only compiled if one of its loops gets hot.
+        unsigned interpreterLoopThreshold = callFrame->globalData().interpreterLoopThreshold;
+        if (callFrame->globalData().canUseJIT() && interpreterLoopThreshold && !program->hasJITCode()) {
+            codeBlock->jitAfter(interpreterLoopThreshold);
+            result = privateExecute(Normal, &m_registerFile, newCallFrame, exception);
+        } else
+#endif
 #if ENABLE(INTERPRETER)
         if (callFrame->globalData().canUseJIT())
 #endif
@@ -759,6 +814,7 @@ JSValue Interpreter::execute(FunctionExecutable* functionExecutable, CallFrame*
         }
     }
 
+    TopCallFrameScope topCallFrameScope(m_registerFile);
     Register* oldEnd = m_registerFile.end();
     int argc = 1 + args.size(); // implicit "this" parameter
 
@@ -785,6 +841,7 @@ JSValue Interpreter::execute(FunctionExecutable* functionExecutable, CallFrame*
     }
     // a 0 codeBlock indicates a built-in caller
     newCallFrame->init(codeBlock, 0, scopeChain, callFrame->addHostCallFrameFlag(), 0, argc, function);
+    m_registerFile.setTopCallFrame(newCallFrame);
 
     Profiler** profiler = Profiler::enabledProfilerReference();
     if (*profiler)
@@ -796,6 +853,11 @@ JSValue Interpreter::execute(FunctionExecutable* functionExecutable, CallFrame*
 
         m_reentryDepth++;
 #if ENABLE(JIT)
+#if ENABLE(INTERPRETER_OSR)
+        if (scopeChain->globalData->canUseJIT() && !shouldCallInJITCode(functionExecutable, codeBlock))
+            result = privateExecute(Normal, &m_registerFile, newCallFrame, exception);
+        else
+#endif
 #if ENABLE(INTERPRETER)
         if (scopeChain->globalData->canUseJIT())
 #endif
@@ -862,7 +924,9 @@ CallFrameClosure Interpreter::prepareForRepeatCall(FunctionExecutable* FunctionE
 
 JSValue Interpreter::execute(CallFrameClosure& closure, JSValue* exception) 
 {
+    TopCallFrameScope topCallFrameScope(m_registerFile);
     closure.resetCallFrame();
+    m_registerFile.setTopCallFrame(closure.newCallFrame);
     Profiler** profiler = Profiler::enabledProfilerReference();
     if (*profiler)
         (*profiler)->willExecute(closure.oldCallFrame, closure.function);
@@ -913,6 +977,7 @@ JSValue Interpreter::execute(EvalExecutable* eval, CallFrame* callFrame, JSObjec
         }
     }
 
+    TopCallFrameScope topCallFrameScope(m_registerFile);
     DynamicGlobalObjectScope globalObjectScope(callFrame, scopeChain->globalObject);
 
     EvalCodeBlock* codeBlock = &eval->bytecode(callFrame, scopeChain);
@@ -959,6 +1024,7 @@ JSValue Interpreter::execute(EvalExecutable* eval, CallFrame* callFrame, JSObjec
     // a 0 codeBlock indicates a built-in caller
     newCallFrame->r(codeBlock->thisRegister()) = JSValue(thisObj);
     newCallFrame->init(codeBlock, 0, scopeChain, callFrame->addHostCallFrameFlag(), 0, 0, 0);
+    m_registerFile.setTopCallFrame(newCallFrame);
 
     if (codeBlock->needsFullScopeChain())
         scopeChain->ref();
@@ -1038,6 +1104,9 @@ NEVER_INLINE ScopeChainNode* Interpreter::createExceptionScope(CallFrame* callFr
 
 NEVER_INLINE void Interpreter::tryCachePutByID(CallFrame* callFrame, CodeBlock* codeBlock, Instruction* vPC, JSValue baseValue, const PutPropertySlot& slot)
 {
+    if (!canCacheInInstructions(callFrame))
+        return;
+
     // Recursive invocation may already have specialized this instruction.
     if (vPC[0].u.opcode != getOpcode(op_put_by_id))
         return;
@@ -1114,6 +1183,9 @@ NEVER_INLINE void Interpreter::uncachePutByID(CodeBlock* codeBlock, Instruction*
 
 NEVER_INLINE void Interpreter::tryCacheGetByID(CallFrame* callFrame, CodeBlock* codeBlock, Instruction* vPC, JSValue baseValue, const Identifier& propertyName, const PropertySlot& slot)
 {
+    if (!canCacheInInstructions(callFrame))
+        return;
+
     // Recursive invocation may already have specialized this instruction.
     if (vPC[0].u.opcode != getOpcode(op_get_by_id))
         return;
@@ -1259,6 +1331,96 @@ NEVER_INLINE void Interpreter::uncacheGetByID(CodeBlock* codeBlock, Instruction*
     vPC[4] = 0;
 }
 
+#if ENABLE(VALUE_PROFILER)
+static NEVER_INLINE void profileValue(CallFrame* callFrame, const Instruction* vPC, JSValue value)
+{
+    CodeBlock* codeBlock = callFrame->codeBlock();
+    if (ValueProfile* profile = codeBlock->valueProfileForBytecodeOffset(vPC - codeBlock->instructions().begin()))
+        profile->observe(value);
+}
+#endif
+
+#if ENABLE(INTERPRETER_OSR)
+// While the JIT is enabled, code the interpreter is running calls functions that
+// have been compiled in their JIT code. The callee's frame is marked as called
+// from the host, so that neither tier ever unwinds into, or looks for a return
+// address in, a frame the other one is running.
+NEVER_INLINE JSValue Interpreter::executeCallInJITCode(CallFrame* newCallFrame, FunctionExecutable* functionExecutable, ScopeChainNode* scopeChain, JSValue& exceptionValue)
+{
+    CallFrame* callerFrame = newCallFrame->callerFrame();
+    if (m_reentryDepth >= MaxSmallThreadReentryDepth && m_reentryDepth >= callerFrame->globalData().maxReentryDepth) {
+        exceptionValue = createStackOverflowError(callerFrame);
+        return jsNull();
+    }
+    newCallFrame->setCallerFrame(callerFrame->addHostCallFrameFlag());
+
+    TopCallFrameScope topCallFrameScope(m_registerFile);
+    m_registerFile.setTopCallFrame(newCallFrame);
+
+    JITCode& jitCode = functionExecutable->jitCode(newCallFrame, scopeChain);
+    exceptionValue = JSValue();
+    m_reentryDepth++;
+    JSValue result = jitCode.execute(&m_registerFile, newCallFrame, scopeChain->globalData, &exceptionValue);
+    m_reentryDepth--;
+    return result;
+}
+
+// Finally blocks keep the address they return to in a register: an Instruction*
+// in the interpreter, and machine code in the JIT. A frame cannot carry one
+// across, so code with finally blocks stays in the interpreter.
+bool Interpreter::hasFinallyBlocks(CodeBlock* codeBlock)
+{
+    Instruction* instructionsBegin = codeBlock->instructions().begin();
+    unsigned instructionCount = codeBlock->instructions().size();
+    for (unsigned bytecodeOffset = 0; bytecodeOffset < instructionCount; ) {
+        OpcodeID opcodeID = getOpcodeID(instructionsBegin[bytecodeOffset].u.opcode);
+        if (opcodeID == op_jsr)
+            return true;
+        bytecodeOffset += opcodeLengths[opcodeID];
+    }
+    return false;
+}
+
+// Called at a loop header once the frame's code has looped enough. Compiles the
+// code and returns the entry point for the loop, or 0 to go on interpreting.
+// Compiling global code throws its bytecode away, so once this has returned an
+// entry point the frame can only continue in JIT code.
+NEVER_INLINE void* Interpreter::prepareForOSREntry(CallFrame* callFrame, Instruction* vPC)
+{
+    CodeBlock* codeBlock = callFrame->codeBlock();
+    if (!callFrame->globalData().canUseJIT() || codeBlock->codeType() == EvalCode) {
+        codeBlock->jitNever();
+        return 0;
+    }
+    if (hasFinallyBlocks(codeBlock)) {
+        // A function can still be compiled, and entered at the start of its next call.
+        if (codeBlock->codeType() == FunctionCode)
+            codeBlock->jitAfter(0);
+        else
+            codeBlock->jitNever();
+        return 0;
+    }
+
+    unsigned bytecodeOffset = vPC - codeBlock->instructions().begin();
+    if (codeBlock->codeType() == GlobalCode)
+        static_cast<ProgramExecutable*>(codeBlock->ownerExecutable())->jitCode(callFrame, callFrame->scopeChain());
+    else
+        static_cast<FunctionExecutable*>(codeBlock->ownerExecutable())->jitCode(callFrame, callFrame->scopeChain());
+    OSRPoint* loopEntryPoint = codeBlock->loopEntryPointForBytecodeIndex(bytecodeOffset);
+    ASSERT(loopEntryPoint);
+    return loopEntryPoint->machineCode.executableAddress();
+}
+
+// Runs the rest of the frame in JIT code, which returns from op_end the way it
+// would to JITCode::execute.
+static JSValue executeFromLoopEntryPoint(void* loopEntryPoint, RegisterFile* registerFile, CallFrame* callFrame, JSValue* exception)
+{
+    JSGlobalData* globalData = &callFrame->globalData();
+    JSValue result = JSValue::decode(ctiTrampoline(loopEntryPoint, registerFile, callFrame, exception, Profiler::enabledProfilerReference(), globalData));
+    return globalData->exception ? jsNull() : result;
+}
+#endif
+
 #endif // ENABLE(INTERPRETER)
 
 JSValue Interpreter::privateExecute(ExecutionFlag flag, RegisterFile* registerFile, CallFrame* callFrame, JSValue* exception)
@@ -1276,7 +1438,7 @@ JSValue Interpreter::privateExecute(ExecutionFlag flag, RegisterFile* registerFi
         return JSValue();
     }
     
-#if ENABLE(JIT)
+#if ENABLE(JIT) && !ENABLE(INTERPRETER_OSR)
 #if ENABLE(INTERPRETER)
     // Mixing Interpreter + JIT is not supported.
     if (callFrame->globalData().canUseJIT())
@@ -1320,6 +1482,20 @@ JSValue Interpreter::privateExecute(ExecutionFlag flag, RegisterFile* registerFi
         tickCount = globalData->timeoutChecker.ticksUntilNextCheck(); \
     }
     
+#if ENABLE(INTERPRETER_OSR)
+    #define CHECK_FOR_OSR_ENTRY() \
+        if (UNLIKELY(callFrame->codeBlock()->checkIfJITThresholdReached())) \
+            goto vm_osr_entry;
+#else
+    #define CHECK_FOR_OSR_ENTRY()
+#endif
+
+#if ENABLE(VALUE_PROFILER)
+    #define PROFILE_RESULT(dst) profileValue(callFrame, vPC, callFrame->r(dst).jsValue())
+#else
+    #define PROFILE_RESULT(dst)
+#endif
+
 #if ENABLE(OPCODE_SAMPLING)
     #define SAMPLE(codeBlock, vPC) m_sampler->sample(codeBlock, vPC)
 #else
@@ -1691,6 +1867,7 @@ JSValue Interpreter::privateExecute(ExecutionFlag flag, RegisterFile* registerFi
             CHECK_FOR_EXCEPTION();
             callFrame->r(dst) = result;
         }
+        PROFILE_RESULT(dst);
         vPC += OPCODE_LENGTH(op_add);
         NEXT_INSTRUCTION();
     }
@@ -1710,6 +1887,7 @@ JSValue Interpreter::privateExecute(ExecutionFlag flag, RegisterFile* registerFi
             CHECK_FOR_EXCEPTION();
             callFrame->r(dst) = result;
         }
+        PROFILE_RESULT(dst);
 
         vPC += OPCODE_LENGTH(op_mul);
         NEXT_INSTRUCTION();
@@ -1728,6 +1906,7 @@ JSValue Interpreter::privateExecute(ExecutionFlag flag, RegisterFile* registerFi
         JSValue result = jsNumber(callFrame, dividend.toNumber(callFrame) / divisor.toNumber(callFrame));
         CHECK_FOR_EXCEPTION();
         callFrame->r(dst) = result;
+        PROFILE_RESULT(dst);
 
         vPC += OPCODE_LENGTH(op_div);
         NEXT_INSTRUCTION();
@@ -1747,6 +1926,7 @@ JSValue Interpreter::privateExecute(ExecutionFlag flag, RegisterFile* registerFi
             JSValue result = jsNumber(callFrame, dividend.asInt32() % divisor.asInt32());
             ASSERT(result);
             callFrame->r(dst) = result;
+            PROFILE_RESULT(dst);
             vPC += OPCODE_LENGTH(op_mod);
             NEXT_INSTRUCTION();
         }
@@ -1758,6 +1938,7 @@ JSValue Interpreter::privateExecute(ExecutionFlag flag, RegisterFile* registerFi
         JSValue result = jsNumber(callFrame, fmod(d1, d2));
         CHECK_FOR_EXCEPTION();
         callFrame->r(dst) = result;
+        PROFILE_RESULT(dst);
         vPC += OPCODE_LENGTH(op_mod);
         NEXT_INSTRUCTION();
     }
@@ -1778,6 +1959,7 @@ JSValue Interpreter::privateExecute(ExecutionFlag flag, RegisterFile* registerFi
             CHECK_FOR_EXCEPTION();
             callFrame->r(dst) = result;
         }
+        PROFILE_RESULT(dst);
         vPC += OPCODE_LENGTH(op_sub);
         NEXT_INSTRUCTION();
     }
@@ -2188,6 +2370,7 @@ JSValue Interpreter::privateExecute(ExecutionFlag flag, RegisterFile* registerFi
         int value = vPC[3].u.operand;
         
         scope->registerAt(index) = JSValue(callFrame->r(value).jsValue());
+        Heap::writeBarrier(scope, callFrame->r(value).jsValue());
         vPC += OPCODE_LENGTH(op_put_global_var);
         NEXT_INSTRUCTION();
     }
@@ -2235,6 +2418,7 @@ JSValue Interpreter::privateExecute(ExecutionFlag flag, RegisterFile* registerFi
         ASSERT((*iter)->isVariableObject());
         JSVariableObject* scope = static_cast<JSVariableObject*>(*iter);
         scope->registerAt(index) = JSValue(callFrame->r(value).jsValue());
+        Heap::writeBarrier(scope, callFrame->r(value).jsValue());
         vPC += OPCODE_LENGTH(op_put_scoped_var);
         NEXT_INSTRUCTION();
     }
@@ -2289,6 +2473,7 @@ JSValue Interpreter::privateExecute(ExecutionFlag flag, RegisterFile* registerFi
         tryCacheGetByID(callFrame, codeBlock, vPC, baseValue, ident, slot);
 
         callFrame->r(dst) = result;
+        PROFILE_RESULT(dst);
         vPC += OPCODE_LENGTH(op_get_by_id);
         NEXT_INSTRUCTION();
     }
@@ -2314,6 +2499,7 @@ JSValue Interpreter::privateExecute(ExecutionFlag flag, RegisterFile* registerFi
 
                 ASSERT(baseObject->get(callFrame, callFrame->codeBlock()->identifier(vPC[3].u.operand)) == baseObject->getDirectOffset(offset));
                 callFrame->r(dst) = JSValue(baseObject->getDirectOffset(offset));
+                PROFILE_RESULT(dst);
 
                 vPC += OPCODE_LENGTH(op_get_by_id_self);
                 NEXT_INSTRUCTION();
@@ -2349,6 +2535,7 @@ JSValue Interpreter::privateExecute(ExecutionFlag flag, RegisterFile* registerFi
                     ASSERT(protoObject->get(callFrame, callFrame->codeBlock()->identifier(vPC[3].u.operand)) == protoObject->getDirectOffset(offset));
                     ASSERT(baseValue.get(callFrame, callFrame->codeBlock()->identifier(vPC[3].u.operand)) == protoObject->getDirectOffset(offset));
                     callFrame->r(dst) = JSValue(protoObject->getDirectOffset(offset));
+                    PROFILE_RESULT(dst);
 
                     vPC += OPCODE_LENGTH(op_get_by_id_proto);
                     NEXT_INSTRUCTION();
@@ -2393,6 +2580,7 @@ JSValue Interpreter::privateExecute(ExecutionFlag flag, RegisterFile* registerFi
                         callFrame->r(dst) = result;
                     } else
                         callFrame->r(dst) = jsUndefined();
+                    PROFILE_RESULT(dst);
                     vPC += OPCODE_LENGTH(op_get_by_id_getter_proto);
                     NEXT_INSTRUCTION();
                 }
@@ -2435,6 +2623,7 @@ JSValue Interpreter::privateExecute(ExecutionFlag flag, RegisterFile* registerFi
                     JSValue result = getter(callFrame, protoObject, ident);
                     CHECK_FOR_EXCEPTION();
                     callFrame->r(dst) = result;
+                    PROFILE_RESULT(dst);
                     vPC += OPCODE_LENGTH(op_get_by_id_custom_proto);
                     NEXT_INSTRUCTION();
                 }
@@ -2520,6 +2709,7 @@ JSValue Interpreter::privateExecute(ExecutionFlag flag, RegisterFile* registerFi
                         ASSERT(baseObject->get(callFrame, callFrame->codeBlock()->identifier(vPC[3].u.operand)) == baseObject->getDirectOffset(offset));
                         ASSERT(baseValue.get(callFrame, callFrame->codeBlock()->identifier(vPC[3].u.operand)) == baseObject->getDirectOffset(offset));
                         callFrame->r(dst) = JSValue(baseObject->getDirectOffset(offset));
+                        PROFILE_RESULT(dst);
 
                         vPC += OPCODE_LENGTH(op_get_by_id_chain);
                         NEXT_INSTRUCTION();
@@ -2566,6 +2756,7 @@ JSValue Interpreter::privateExecute(ExecutionFlag flag, RegisterFile* registerFi
                     callFrame->r(dst) = result;
                 } else
                     callFrame->r(dst) = jsUndefined();
+                PROFILE_RESULT(dst);
 
                 vPC += OPCODE_LENGTH(op_get_by_id_getter_self);
                 NEXT_INSTRUCTION();
@@ -2604,6 +2795,7 @@ JSValue Interpreter::privateExecute(ExecutionFlag flag, RegisterFile* registerFi
                 JSValue result = getter(callFrame, baseValue, ident);
                 CHECK_FOR_EXCEPTION();
                 callFrame->r(dst) = result;
+                PROFILE_RESULT(dst);
                 vPC += OPCODE_LENGTH(op_get_by_id_custom_self);
                 NEXT_INSTRUCTION();
             }
@@ -2626,11 +2818,16 @@ skip_id_custom_self:
 
         Identifier& ident = callFrame->codeBlock()->identifier(property);
         JSValue baseValue = callFrame->r(base).jsValue();
-        PropertySlot slot(baseValue);
-        JSValue result = baseValue.get(callFrame, ident, slot);
-        CHECK_FOR_EXCEPTION();
+        JSValue result;
+        if (!baseValue.isCell() || !globalData->megamorphicCache.get(asCell(baseValue), ident, result)) {
+            PropertySlot slot(baseValue);
+            result = baseValue.get(callFrame, ident, slot);
+            CHECK_FOR_EXCEPTION();
+            globalData->megamorphicCache.add(baseValue, ident, slot);
+        }
 
         callFrame->r(dst) = result;
+        PROFILE_RESULT(dst);
         vPC += OPCODE_LENGTH(op_get_by_id_generic);
         NEXT_INSTRUCTION();
     }
@@ -2674,6 +2871,7 @@ skip_id_custom_self:
                             callFrame->r(dst) = result;
                         } else
                             callFrame->r(dst) = jsUndefined();
+                        PROFILE_RESULT(dst);
                         vPC += OPCODE_LENGTH(op_get_by_id_getter_chain);
                         NEXT_INSTRUCTION();
                     }
@@ -2726,6 +2924,7 @@ skip_id_custom_self:
                         JSValue result = getter(callFrame, baseObject, ident);
                         CHECK_FOR_EXCEPTION();
                         callFrame->r(dst) = result;
+                        PROFILE_RESULT(dst);
                         vPC += OPCODE_LENGTH(op_get_by_id_custom_chain);
                         NEXT_INSTRUCTION();
                     }
@@ -2754,6 +2953,7 @@ skip_id_custom_self:
         if (LIKELY(isJSArray(globalData, baseValue))) {
             int dst = vPC[1].u.operand;
             callFrame->r(dst) = jsNumber(callFrame, asArray(baseValue)->length());
+            PROFILE_RESULT(dst);
             vPC += OPCODE_LENGTH(op_get_array_length);
             NEXT_INSTRUCTION();
         }
@@ -2774,6 +2974,7 @@ skip_id_custom_self:
         if (LIKELY(isJSString(globalData, baseValue))) {
             int dst = vPC[1].u.operand;
             callFrame->r(dst) = jsNumber(callFrame, asString(baseValue)->length());
+            PROFILE_RESULT(dst);
             vPC += OPCODE_LENGTH(op_get_string_length);
             NEXT_INSTRUCTION();
         }
@@ -2998,7 +3199,7 @@ skip_id_custom_self:
             if (isJSArray(globalData, baseValue)) {
                 JSArray* jsArray = asArray(baseValue);
                 if (jsArray->canGetIndex(i))
-                    result = jsArray->getIndex(i);
+                    result = jsArray->getIndex(callFrame, i);
                 else
                     result = jsArray->JSArray::get(callFrame, i);
             } else if (isJSString(globalData, baseValue) && asString(baseValue)->canGetIndex(i))
@@ -3014,6 +3215,7 @@ skip_id_custom_self:
 
         CHECK_FOR_EXCEPTION();
         callFrame->r(dst) = result;
+        PROFILE_RESULT(dst);
         vPC += OPCODE_LENGTH(op_get_by_val);
         NEXT_INSTRUCTION();
     }
@@ -3134,6 +3336,7 @@ skip_id_custom_self:
         int target = vPC[1].u.operand;
         CHECK_FOR_TIMEOUT();
         vPC += target;
+        CHECK_FOR_OSR_ENTRY();
         NEXT_INSTRUCTION();
     }
     DEFINE_OPCODE(op_jmp) {
@@ -3164,6 +3367,7 @@ skip_id_custom_self:
         if (callFrame->r(cond).jsValue().toBoolean(callFrame)) {
             vPC += target;
             CHECK_FOR_TIMEOUT();
+            CHECK_FOR_OSR_ENTRY();
             NEXT_INSTRUCTION();
         }
         
@@ -3184,6 +3388,7 @@ skip_id_custom_self:
         if (!callFrame->r(cond).jsValue().toBoolean(callFrame)) {
             vPC += target;
             CHECK_FOR_TIMEOUT();
+            CHECK_FOR_OSR_ENTRY();
             NEXT_INSTRUCTION();
         }
         
@@ -3297,6 +3502,7 @@ skip_id_custom_self:
         if (result) {
             vPC += target;
             CHECK_FOR_TIMEOUT();
+            CHECK_FOR_OSR_ENTRY();
             NEXT_INSTRUCTION();
         }
         
@@ -3324,6 +3530,7 @@ skip_id_custom_self:
         if (result) {
             vPC += target;
             CHECK_FOR_TIMEOUT();
+            CHECK_FOR_OSR_ENTRY();
             NEXT_INSTRUCTION();
         }
         
@@ -3563,6 +3770,7 @@ skip_id_custom_self:
             if (exceptionValue)
                 goto vm_throw;
             callFrame->r(dst) = result;
+            PROFILE_RESULT(dst);
 
             vPC += OPCODE_LENGTH(op_call_eval);
             NEXT_INSTRUCTION();
@@ -3607,6 +3815,19 @@ skip_id_custom_self:
             }
 
             callFrame->init(newCodeBlock, vPC + 5, callDataScopeChain, previousCallFrame, dst, argCount, asFunction(v));
+#if ENABLE(INTERPRETER_OSR)
+            if (globalData->canUseJIT() && shouldCallInJITCode(callData.js.functionExecutable, newCodeBlock)) {
+                JSValue returnValue = executeCallInJITCode(callFrame, callData.js.functionExecutable, callDataScopeChain, exceptionValue);
+                callFrame = previousCallFrame;
+                if (exceptionValue)
+                    goto vm_throw;
+                callFrame->r(dst) = returnValue;
+                PROFILE_RESULT(dst);
+                vPC += OPCODE_LENGTH(op_call);
+                NEXT_INSTRUCTION();
+            }
+#endif
+            registerFile->setTopCallFrame(callFrame);
             vPC = newCodeBlock->instructions().begin();
 
 #if ENABLE(OPCODE_STATS)
@@ -3637,6 +3858,7 @@ skip_id_custom_self:
             CHECK_FOR_EXCEPTION();
 
             callFrame->r(dst) = returnValue;
+            PROFILE_RESULT(dst);
 
             vPC += OPCODE_LENGTH(op_call);
             NEXT_INSTRUCTION();
@@ -3669,11 +3891,12 @@ skip_id_custom_self:
             Register* argStore = callFrame->registers() + argsOffset;
 
             // First step is to copy the "expected" parameters from their normal location relative to the callframe
+            // (the offsets are negative, so they are computed as ints rather than wrapping as unsigneds)
             for (; i < inplaceArgs; i++)
-                argStore[i] = callFrame->registers()[i - RegisterFile::CallFrameHeaderSize - expectedParams];
+                argStore[i] = callFrame->registers()[static_cast<int>(i) - RegisterFile::CallFrameHeaderSize - static_cast<int>(expectedParams)];
             // Then we copy any additional arguments that may be further up the stack ('-1' to account for 'this')
             for (; i < argCount; i++)
-                argStore[i] = callFrame->registers()[i - RegisterFile::CallFrameHeaderSize - expectedParams - argCount - 1];
+                argStore[i] = callFrame->registers()[static_cast<int>(i) - RegisterFile::CallFrameHeaderSize - static_cast<int>(expectedParams) - static_cast<int>(argCount) - 1];
         } else if (!arguments.isUndefinedOrNull()) {
             if (!arguments.isObject()) {
                 exceptionValue = createInvalidParamError(callFrame, "Function.prototype.apply", arguments, vPC - callFrame->codeBlock()->instructions().begin(), callFrame->codeBlock());
@@ -3763,6 +3986,19 @@ skip_id_custom_self:
             }
             
             callFrame->init(newCodeBlock, vPC + 5, callDataScopeChain, previousCallFrame, dst, argCount, asFunction(v));
+#if ENABLE(INTERPRETER_OSR)
+            if (globalData->canUseJIT() && shouldCallInJITCode(callData.js.functionExecutable, newCodeBlock)) {
+                JSValue returnValue = executeCallInJITCode(callFrame, callData.js.functionExecutable, callDataScopeChain, exceptionValue);
+                callFrame = previousCallFrame;
+                if (exceptionValue)
+                    goto vm_throw;
+                callFrame->r(dst) = returnValue;
+                PROFILE_RESULT(dst);
+                vPC += OPCODE_LENGTH(op_call_varargs);
+                NEXT_INSTRUCTION();
+            }
+#endif
+            registerFile->setTopCallFrame(callFrame);
             vPC = newCodeBlock->instructions().begin();
             
 #if ENABLE(OPCODE_STATS)
@@ -3793,6 +4029,7 @@ skip_id_custom_self:
             CHECK_FOR_EXCEPTION();
             
             callFrame->r(dst) = returnValue;
+            PROFILE_RESULT(dst);
             
             vPC += OPCODE_LENGTH(op_call_varargs);
             NEXT_INSTRUCTION();
@@ -3869,7 +4106,12 @@ skip_id_custom_self:
         if (callFrame->hasHostCallFrameFlag())
             return returnValue;
 
+        registerFile->setTopCallFrame(callFrame);
         callFrame->r(dst) = returnValue;
+#if ENABLE(VALUE_PROFILER)
+        // All the profiled calls are as long as op_call; op_construct is not profiled.
+        profileValue(callFrame, vPC - OPCODE_LENGTH(op_call), returnValue);
+#endif
 
         NEXT_INSTRUCTION();
     }
@@ -4004,10 +4246,10 @@ skip_id_custom_self:
             Structure* structure;
             JSValue prototype = callFrame->r(proto).jsValue();
             if (prototype.isObject())
-                structure = asObject(prototype)->inheritorID();
+                structure = asObject(prototype)->inheritorIDForConstruction();
             else
                 structure = callDataScopeChain->globalObject->emptyObjectStructure();
-            JSObject* newObject = new (globalData) JSObject(structure);
+            JSObject* newObject = constructObject(globalData, structure);
 
             callFrame->r(thisRegister) = JSValue(newObject); // "this" value
 
@@ -4021,6 +4263,18 @@ skip_id_custom_self:
             }
 
             callFrame->init(newCodeBlock, vPC + 7, callDataScopeChain, previousCallFrame, dst, argCount, asFunction(v));
+#if ENABLE(INTERPRETER_OSR)
+            if (globalData->canUseJIT() && shouldCallInJITCode(constructData.js.functionExecutable, newCodeBlock)) {
+                JSValue returnValue = executeCallInJITCode(callFrame, constructData.js.functionExecutable, callDataScopeChain, exceptionValue);
+                callFrame = previousCallFrame;
+                if (exceptionValue)
+                    goto vm_throw;
+                callFrame->r(dst) = returnValue;
+                vPC += OPCODE_LENGTH(op_construct);
+                NEXT_INSTRUCTION();
+            }
+#endif
+            registerFile->setTopCallFrame(callFrame);
             vPC = newCodeBlock->instructions().begin();
 #if ENABLE(OPCODE_STATS)
             OpcodeStats::resetLastInstruction();
@@ -4175,6 +4429,7 @@ skip_id_custom_self:
                 CHECK_FOR_TIMEOUT();
                 callFrame->r(dst) = key;
                 vPC += target;
+                CHECK_FOR_OSR_ENTRY();
                 NEXT_INSTRUCTION();
             }
         }
@@ -4423,9 +4678,43 @@ skip_id_custom_self:
             return jsNull();
         }
 
+        registerFile->setTopCallFrame(callFrame);
         vPC = callFrame->codeBlock()->instructions().begin() + handler->target;
         NEXT_INSTRUCTION();
     }
+#if ENABLE(INTERPRETER_OSR)
+    vm_osr_entry: {
+        void* loopEntryPoint = prepareForOSREntry(callFrame, vPC);
+        if (!loopEntryPoint) {
+            NEXT_INSTRUCTION();
+        }
+
+        CallFrame* callerFrame = callFrame->callerFrame();
+        if (callerFrame->hasHostCallFrameFlag())
+            return executeFromLoopEntryPoint(loopEntryPoint, registerFile, callFrame, exception);
+
+        // The frame was called from the interpreter. The JIT code runs it as though
+        // the host had called it, and the caller then carries on the way it would
+        // after op_ret, or after a callee throwing.
+        vPC = callFrame->returnVPC();
+        int dst = callFrame->returnValueRegister();
+        callFrame->setCallerFrame(callerFrame->addHostCallFrameFlag());
+        exceptionValue = JSValue();
+        m_reentryDepth++;
+        JSValue returnValue = executeFromLoopEntryPoint(loopEntryPoint, registerFile, callFrame, &exceptionValue);
+        m_reentryDepth--;
+        callFrame = callerFrame;
+        registerFile->setTopCallFrame(callFrame);
+        if (exceptionValue)
+            goto vm_throw;
+
+        callFrame->r(dst) = returnValue;
+#if ENABLE(VALUE_PROFILER)
+        profileValue(callFrame, vPC - OPCODE_LENGTH(op_call), returnValue);
+#endif
+        NEXT_INSTRUCTION();
+    }
+#endif
     }
 #if !ENABLE(COMPUTED_GOTO_INTERPRETER)
     } // iterator loop ends
@@ -4434,6 +4723,8 @@ skip_id_custom_self:
     #undef DEFINE_OPCODE
     #undef CHECK_FOR_EXCEPTION
     #undef CHECK_FOR_TIMEOUT
+    #undef CHECK_FOR_OSR_ENTRY
+    #undef PROFILE_RESULT
 #endif // ENABLE(INTERPRETER)
 }
 
@@ -4498,7 +4789,7 @@ void Interpreter::retrieveLastCaller(CallFrame* callFrame, int& lineNumber, intp
         return;
     unsigned bytecodeOffset = 0;
 #if ENABLE(INTERPRETER)
-    if (!callerFrame->globalData().canUseJIT())
+    if (!callerFrame->globalData().canUseJIT() || callerCodeBlock->isInterpreterReturnAddress(callFrame->returnVPC()))
         bytecodeOffset = bytecodeOffsetForPC(callerFrame, callerCodeBlock, callFrame->returnVPC());
 #if ENABLE(JIT)
     else
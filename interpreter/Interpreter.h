@@ -138,6 +138,12 @@ namespace JSC {
         void uncacheGetByID(CodeBlock*, Instruction* vPC);
         void tryCachePutByID(CallFrame*, CodeBlock*, Instruction*, JSValue baseValue, const PutPropertySlot&);
         void uncachePutByID(CodeBlock*, Instruction* vPC);        
+
+#if ENABLE(INTERPRETER_OSR)
+        NEVER_INLINE JSValue executeCallInJITCode(CallFrame*, FunctionExecutable*, ScopeChainNode*, JSValue& exceptionValue);
+        bool hasFinallyBlocks(CodeBlock*);
+        NEVER_INLINE void* prepareForOSREntry(CallFrame*, Instruction* vPC);
+#endif
 #endif // ENABLE(INTERPRETER)
 
         NEVER_INLINE bool unwindCallFrame(CallFrame*&, JSValue, unsigned& bytecodeOffset, CodeBlock*&);
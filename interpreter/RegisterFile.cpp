@@ -29,8 +29,16 @@
 #include "config.h"
 #include "RegisterFile.h"
 
+#include "CallFrame.h"
+#include "CodeBlock.h"
+#include "JSFunction.h"
 #include "JSGlobalObject.h"
 
+// Overwrites the temporaries of suspended frames that liveness says are dead,
+// so that a missing entry in a liveness map fails loudly rather than as a rare
+// use-after-free.
+#define CLOBBER_DEAD_TEMPORARIES 0
+
 namespace JSC {
 
 RegisterFile::~RegisterFile()
@@ -73,4 +81,104 @@ JSGlobalObject* RegisterFile::globalObject()
     return m_globalObject.get();
 }
 
+static inline bool isHostCallFrame(CallFrame* callFrame)
+{
+    // Frames the JIT sets up for host functions leave the CodeBlock slot stale,
+    // but do set the callee.
+    if (JSFunction* callee = callFrame->callee())
+        return callee->isHostFunction();
+    return !callFrame->codeBlock();
+}
+
+// The lowest register of a frame: its arguments, including any left below
+// the copied parameters when it was called with too many.
+static inline Register* firstRegister(CallFrame* callFrame)
+{
+    int argumentCount = callFrame->argumentCount();
+    if (isHostCallFrame(callFrame))
+        return callFrame->registers() - RegisterFile::CallFrameHeaderSize - argumentCount;
+    int numParameters = callFrame->codeBlock()->m_numParameters;
+    return callFrame->registers() - RegisterFile::CallFrameHeaderSize - numParameters - (argumentCount > numParameters ? argumentCount : 0);
+}
+
+void RegisterFile::markCallFrames(MarkStack& markStack, Heap* heap)
+{
+    markCallFrameChain(markStack, heap, m_topCallFrame, m_end);
+    for (size_t i = 0; i < m_savedTopCallFrames.size(); ++i)
+        markCallFrameChain(markStack, heap, m_savedTopCallFrames[i].callFrame, m_savedTopCallFrames[i].end);
+}
+
+void RegisterFile::markCallFrameChain(MarkStack& markStack, Heap* heap, CallFrame* topCallFrame, Register* end)
+{
+    if (!topCallFrame) {
+        heap->markConservatively(markStack, m_start, end);
+        return;
+    }
+
+    // Anything above the running frame belongs to it: arguments it is pushing,
+    // host calls it made, and frames it has only started to set up.
+    Register* start = firstRegister(topCallFrame);
+    if (start < end)
+        heap->markConservatively(markStack, start, end);
+
+    CallFrame* callee = topCallFrame;
+    for (CallFrame* callFrame = callee->callerFrame(); !callFrame->hasHostCallFrameFlag(); callFrame = callFrame->callerFrame()) {
+        markSuspendedCallFrame(markStack, heap, callFrame, callee);
+        callee = callFrame;
+    }
+}
+
+void RegisterFile::markSuspendedCallFrame(MarkStack& markStack, Heap* heap, CallFrame* callFrame, CallFrame* callee)
+{
+    JSC::CodeBlock* codeBlock = callFrame->codeBlock();
+    Register* registers = callFrame->registers();
+
+    unsigned bytecodeOffset;
+#if ENABLE(JIT)
+#if ENABLE(INTERPRETER)
+    if (callFrame->globalData().canUseJIT() && !codeBlock->isInterpreterReturnAddress(callee->returnVPC())) {
+#endif
+        if (!codeBlock->bytecodeOffsetForCallReturn(callee->returnPC(), bytecodeOffset))
+            bytecodeOffset = 0;
+#if ENABLE(INTERPRETER)
+    } else
+#endif
+#endif
+#if ENABLE(INTERPRETER)
+        bytecodeOffset = callee->returnVPC() - codeBlock->instructions().begin();
+#endif
+
+    // Call sites are never at offset 0, so that doubles as "not found".
+    const uint32_t* liveTemporaries = bytecodeOffset ? codeBlock->liveTemporariesAtCallReturn(bytecodeOffset) : 0;
+    if (!liveTemporaries) {
+        heap->markConservatively(markStack, firstRegister(callFrame), registers + codeBlock->m_numCalleeRegisters);
+        return;
+    }
+
+    // Arguments, the header and variables are always live.
+    heap->markConservatively(markStack, firstRegister(callFrame), registers + codeBlock->m_numVars);
+
+    int numTemporaries = codeBlock->m_numCalleeRegisters - codeBlock->m_numVars;
+    Register* temporaries = registers + codeBlock->m_numVars;
+    for (int i = 0; i < numTemporaries; ) {
+        if (!(liveTemporaries[i / 32] & (1u << (i % 32)))) {
+#if CLOBBER_DEAD_TEMPORARIES
+            // The callee's arguments are dead here but not to the callee.
+            if (temporaries + i < firstRegister(callee))
+                temporaries[i] = jsUndefined();
+#endif
+            ++i;
+            continue;
+        }
+        int runStart = i;
+        while (i < numTemporaries && (liveTemporaries[i / 32] & (1u << (i % 32))))
+            ++i;
+        heap->markConservatively(markStack, temporaries + runStart, temporaries + i);
+    }
+
+    // A dead temporary may be all that held an object pushed by with or catch.
+    for (ScopeChainNode* node = callFrame->scopeChain(); node; node = node->next)
+        markStack.append(node->object);
+}
+
 } // namespace JSC
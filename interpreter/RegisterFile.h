@@ -35,6 +35,7 @@
 #include "WeakGCPtr.h"
 #include <stdio.h>
 #include <wtf/Noncopyable.h>
+#include <wtf/Vector.h>
 #include <wtf/VMTags.h>
 
 #if HAVE(MMAP)
@@ -139,10 +140,26 @@ namespace JSC {
         Register* lastGlobal() const { return m_start - m_numGlobals; }
         
         void markGlobals(MarkStack& markStack, Heap* heap) { heap->markConservatively(markStack, lastGlobal(), m_start); }
-        void markCallFrames(MarkStack& markStack, Heap* heap) { heap->markConservatively(markStack, m_start, m_end); }
+        void markCallFrames(MarkStack&, Heap*);
+
+        // The frame that is currently running, or the caller of a frame still
+        // being set up. Each entry into JavaScript through Interpreter::execute()
+        // starts a new chain of frames; the running frame of the chain it
+        // interrupted is saved until it returns.
+        CallFrame* topCallFrame() const { return m_topCallFrame; }
+        void setTopCallFrame(CallFrame* callFrame) { m_topCallFrame = callFrame; }
+        void saveTopCallFrame();
+        void restoreTopCallFrame();
 
     private:
+        struct SavedTopCallFrame {
+            CallFrame* callFrame;
+            Register* end; // The end of the register file when the next chain began.
+        };
+
         void releaseExcessCapacity();
+        void markCallFrameChain(MarkStack&, Heap*, CallFrame* topCallFrame, Register* end);
+        void markSuspendedCallFrame(MarkStack&, Heap*, CallFrame*, CallFrame* callee);
         size_t m_numGlobals;
         const size_t m_maxGlobals;
         Register* m_start;
@@ -150,6 +167,8 @@ namespace JSC {
         Register* m_max;
         Register* m_buffer;
         Register* m_maxUsed;
+        CallFrame* m_topCallFrame;
+        Vector<SavedTopCallFrame, 16> m_savedTopCallFrames;
 
 #if HAVE(VIRTUALALLOC)
         Register* m_commitEnd;
@@ -168,6 +187,7 @@ namespace JSC {
         , m_end(0)
         , m_max(0)
         , m_buffer(0)
+        , m_topCallFrame(0)
     {
         // Verify that our values will play nice with mmap and VirtualAlloc.
         ASSERT(isPageAligned(maxGlobals));
@@ -231,6 +251,18 @@ namespace JSC {
             releaseExcessCapacity();
     }
 
+    inline void RegisterFile::saveTopCallFrame()
+    {
+        SavedTopCallFrame saved = { m_topCallFrame, m_end };
+        m_savedTopCallFrames.append(saved);
+    }
+
+    inline void RegisterFile::restoreTopCallFrame()
+    {
+        m_topCallFrame = m_savedTopCallFrames.last().callFrame;
+        m_savedTopCallFrames.removeLast();
+    }
+
     inline bool RegisterFile::grow(Register* newEnd)
     {
         if (newEnd < m_end)
@@ -71,7 +71,7 @@ void ctiPatchCallByReturnAddress(CodeBlock* codeblock, ReturnAddressPtr returnAd
     repatchBuffer.relinkCallerToFunction(returnAddress, newCalleeFunction);
 }
 
-JIT::JIT(JSGlobalData* globalData, CodeBlock* codeBlock, void* linkerOffset)
+JIT::JIT(JSGlobalData* globalData, CodeBlock* codeBlock, void* linkerOffset, CodeBlock* baselineCodeBlock)
     : m_interpreter(globalData->interpreter)
     , m_globalData(globalData)
     , m_codeBlock(codeBlock)
@@ -90,7 +90,19 @@ JIT::JIT(JSGlobalData* globalData, CodeBlock* codeBlock, void* linkerOffset)
     , m_jumpTargetsPosition(0)
 #endif
     , m_linkerOffset(linkerOffset)
+#if ENABLE(JIT_OPTIMIZING_TIER)
+    , m_baselineCodeBlock(baselineCodeBlock)
+    , m_hasSpeculativeInstructions(false)
+    , m_speculativeUseCount(0)
+    , m_reservedSpeculativeRegisters(0)
+    , m_reservedSpeculativeFPRegisters(0)
+    , m_currentRegisterLoop(0)
+    , m_nextRegisterLoop(0)
+#endif
 {
+#if !ENABLE(JIT_OPTIMIZING_TIER)
+    UNUSED_PARAM(baselineCodeBlock);
+#endif
 }
 
 #if USE(JSVALUE32_64)
@@ -177,6 +189,14 @@ void JIT::privateCompileMainPass()
     m_globalResolveInfoIndex = 0;
     m_callLinkInfoIndex = 0;
 
+#if ENABLE(JIT_OPTIMIZING_TIER) || ENABLE(INTERPRETER_OSR)
+    findLoopHeaders();
+#endif
+#if ENABLE(JIT_OPTIMIZING_TIER)
+    if (isOptimizing())
+        findRegisterLoops();
+#endif
+
     for (m_bytecodeIndex = 0; m_bytecodeIndex < instructionCount; ) {
         Instruction* currentInstruction = instructionsBegin + m_bytecodeIndex;
         ASSERT_WITH_MESSAGE(m_interpreter->isOpcode(currentInstruction->u.opcode), "privateCompileMainPass gone bad @ %d", m_bytecodeIndex);
@@ -191,9 +211,56 @@ void JIT::privateCompileMainPass()
             killLastResultRegister();
 #endif
 
+        OpcodeID opcodeID = m_interpreter->getOpcodeID(currentInstruction->u.opcode);
+
+#if ENABLE(JIT_OPTIMIZING_TIER)
+        if (isOptimizing()) {
+            if (m_currentRegisterLoop && m_bytecodeIndex == m_currentRegisterLoop->end)
+                leaveRegisterLoop();
+            // Values may only live in machine registers along straight-line code;
+            // every jump into an instruction finds them in the register file,
+            // except for those a register loop pins.
+            if (isJumpTarget(m_bytecodeIndex)) {
+                flushSpeculativeValues();
+                forgetSpeculativeValues();
+            }
+            m_labels[m_bytecodeIndex] = label();
+            if (isLoopHeader(m_bytecodeIndex))
+                addOSRPoint(std::numeric_limits<int>::max());
+            if (m_nextRegisterLoop < m_registerLoops.size() && m_registerLoops[m_nextRegisterLoop].header == m_bytecodeIndex)
+                enterRegisterLoop();
+            if (emitSpeculativeInstruction(opcodeID, currentInstruction)) {
+                m_bytecodeIndex += opcodeLengths[opcodeID];
+                continue;
+            }
+            // A template instruction would clobber the pinned registers.
+            ASSERT(!m_currentRegisterLoop);
+            flushSpeculativeValues();
+            forgetSpeculativeValues();
+        }
+#endif
+
         m_labels[m_bytecodeIndex] = label();
 
-        switch (m_interpreter->getOpcodeID(currentInstruction->u.opcode)) {
+#if ENABLE(JIT_OPTIMIZING_TIER)
+        if (emitsOptimizationCounter()) {
+            // Failed speculations in the optimized code resume here, with regT0
+            // reloaded if this code expects it to hold the last result. Register
+            // loops may also resume wherever they can be jumped into.
+            if (isSpeculativeOpcode(opcodeID) || isJumpTarget(m_bytecodeIndex)) {
+                bool resultIsCached = m_lastResultBytecodeRegister != std::numeric_limits<int>::max() && m_codeBlock->isTemporaryRegisterIndex(m_lastResultBytecodeRegister) && !isJumpTarget(m_bytecodeIndex);
+                addOSRPoint(resultIsCached ? m_lastResultBytecodeRegister : std::numeric_limits<int>::max());
+            }
+            if (isLoopHeader(m_bytecodeIndex))
+                emitOptimizationCheck();
+        }
+#endif
+
+#if ENABLE(VALUE_PROFILER)
+        ValueProfile* valueProfile = valueProfileFor(opcodeID, currentInstruction);
+#endif
+
+        switch (opcodeID) {
         DEFINE_BINARY_OP(op_del_by_val)
 #if USE(JSVALUE32)
         DEFINE_BINARY_OP(op_div)
@@ -341,6 +408,11 @@ void JIT::privateCompileMainPass()
         case op_put_by_id_transition:
             ASSERT_NOT_REACHED();
         }
+
+#if ENABLE(VALUE_PROFILER)
+        if (valueProfile)
+            emitValueProfilingSite(valueProfile);
+#endif
     }
 
     ASSERT(m_propertyAccessInstructionIndex == m_codeBlock->numberOfStructureStubInfos());
@@ -379,8 +451,12 @@ void JIT::privateCompileSlowCases()
         unsigned firstTo = m_bytecodeIndex;
 #endif
         Instruction* currentInstruction = instructionsBegin + m_bytecodeIndex;
+        OpcodeID opcodeID = m_interpreter->getOpcodeID(currentInstruction->u.opcode);
+#if ENABLE(VALUE_PROFILER)
+        ValueProfile* valueProfile = valueProfileFor(opcodeID, currentInstruction);
+#endif
 
-        switch (m_interpreter->getOpcodeID(currentInstruction->u.opcode)) {
+        switch (opcodeID) {
         DEFINE_SLOWCASE_OP(op_add)
         DEFINE_SLOWCASE_OP(op_bitand)
         DEFINE_SLOWCASE_OP(op_bitnot)
@@ -441,6 +517,10 @@ void JIT::privateCompileSlowCases()
         ASSERT_WITH_MESSAGE(iter == m_slowCases.end() || firstTo != iter->to,"Not enough jumps linked in slow case codegen.");
         ASSERT_WITH_MESSAGE(firstTo == (iter - 1)->to, "Too many jumps linked in slow case codegen.");
 
+#if ENABLE(VALUE_PROFILER)
+        if (valueProfile)
+            emitValueProfilingSite(valueProfile);
+#endif
         emitJumpSlowToHot(jump(), 0);
     }
 
@@ -480,8 +560,17 @@ JITCode JIT::privateCompile()
     }
 
     privateCompileMainPass();
+#if ENABLE(JIT_OPTIMIZING_TIER)
+    emitRegisterLoopEntries();
+#endif
     privateCompileLinkPass();
     privateCompileSlowCases();
+#if ENABLE(JIT_OPTIMIZING_TIER)
+    emitSpeculationExits();
+#endif
+#if ENABLE(INTERPRETER_OSR)
+    emitLoopEntryPoints();
+#endif
 
     if (m_codeBlock->codeType() == FunctionCode) {
         slowRegisterFileCheck.link(this);
@@ -544,6 +633,14 @@ JITCode JIT::privateCompile()
             m_codeBlock->callReturnIndexVector().append(CallReturnOffsetToBytecodeIndex(patchBuffer.returnAddressOffset(iter->from), iter->bytecodeIndex));
     }
 
+    // Callees return into these; the collector maps their return addresses back
+    // to the call site's liveness.
+    for (Vector<CallRecord>::iterator iter = m_calls.begin(); iter != m_calls.end(); ++iter) {
+        OpcodeID opcodeID = m_interpreter->getOpcodeID(m_codeBlock->instructions()[iter->bytecodeIndex].u.opcode);
+        if (opcodeID == op_call || opcodeID == op_call_eval || opcodeID == op_call_varargs || opcodeID == op_construct)
+            m_codeBlock->addCallSiteReturnOffset(patchBuffer.returnAddressOffset(iter->from), iter->bytecodeIndex + opcodeLengths[opcodeID]);
+    }
+
     // Link absolute addresses for jsr
     for (Vector<JSRInfo>::iterator iter = m_jsrSites.begin(); iter != m_jsrSites.end(); ++iter)
         patchBuffer.patch(iter->storeLocation, patchBuffer.locationOf(iter->target).executableAddress());
@@ -572,6 +669,15 @@ JITCode JIT::privateCompile()
         info.callReturnLocation = m_codeBlock->structureStubInfo(m_methodCallCompilationInfo[i].propertyAccessIndex).callReturnLocation;
     }
 
+#if ENABLE(JIT_OPTIMIZING_TIER)
+    for (Vector<OSRPointRecord>::iterator iter = m_osrPoints.begin(); iter != m_osrPoints.end(); ++iter)
+        m_codeBlock->addOSRPoint(OSRPoint(iter->bytecodeIndex, patchBuffer.locationOf(iter->label), iter->cachedResultRegister));
+#endif
+#if ENABLE(INTERPRETER_OSR)
+    for (Vector<OSRPointRecord>::iterator iter = m_loopEntryPoints.begin(); iter != m_loopEntryPoints.end(); ++iter)
+        m_codeBlock->addLoopEntryPoint(OSRPoint(iter->bytecodeIndex, patchBuffer.locationOf(iter->label), iter->cachedResultRegister));
+#endif
+
     return patchBuffer.finalizeCode();
 }
 
@@ -626,6 +732,897 @@ void JIT::linkCall(JSFunction* callee, CodeBlock* callerCodeBlock, CodeBlock* ca
 }
 #endif // ENABLE(JIT_OPTIMIZE_CALL)
 
+#if ENABLE(VALUE_PROFILER)
+ValueProfile* JIT::valueProfileFor(OpcodeID opcodeID, Instruction* currentInstruction)
+{
+#if ENABLE(JIT_OPTIMIZING_TIER)
+    if (isOptimizing())
+        return 0;
+#endif
+#if ENABLE(JIT_OPTIMIZE_METHOD_CALLS)
+    // The get_by_id that follows is compiled as part of the method check.
+    if (opcodeID == op_method_check)
+        currentInstruction += OPCODE_LENGTH(op_method_check);
+#else
+    UNUSED_PARAM(opcodeID);
+#endif
+    return m_codeBlock->valueProfileForBytecodeOffset(currentInstruction - m_codeBlock->instructions().begin());
+}
+
+// Emitted where every path through the instruction, fast or slow, has stored its
+// result; counts the kind of value stored.
+void JIT::emitValueProfilingSite(ValueProfile* profile)
+{
+    unsigned nextBytecodeIndex = m_bytecodeIndex;
+    m_bytecodeIndex = profile->bytecodeOffset;
+    unsigned dst = m_codeBlock->instructions()[m_bytecodeIndex + 1].u.operand;
+
+    // The result is usually still in regT0, but loading it must not disturb the
+    // jump target bookkeeping emitGetVirtualRegister does.
+    if (m_lastResultBytecodeRegister != static_cast<int>(dst)) {
+        loadPtr(Address(callFrameRegister, dst * sizeof(Register)), regT0);
+        m_lastResultBytecodeRegister = dst;
+    }
+
+    JumpList done;
+    Jump notInt32 = branchPtr(Below, regT0, tagTypeNumberRegister);
+    add32(Imm32(1), AbsoluteAddress(&profile->counts[ValueProfile::Int32Value]));
+    done.append(jump());
+
+    notInt32.link(this);
+    Jump notDouble = branchTestPtr(Zero, regT0, tagTypeNumberRegister);
+    add32(Imm32(1), AbsoluteAddress(&profile->counts[ValueProfile::DoubleValue]));
+    done.append(jump());
+
+    notDouble.link(this);
+    Jump notCell = emitJumpIfNotJSCell(regT0);
+    Jump notString = branchPtr(NotEqual, Address(regT0), ImmPtr(m_globalData->jsStringVPtr));
+    add32(Imm32(1), AbsoluteAddress(&profile->counts[ValueProfile::StringValue]));
+    done.append(jump());
+
+    notString.link(this);
+    loadPtr(Address(regT0, OBJECT_OFFSETOF(JSCell, m_structure)), regT1);
+    Jump otherStructure = branchPtr(NotEqual, AbsoluteAddress(&profile->structures[0]), regT1);
+    add32(Imm32(1), AbsoluteAddress(&profile->counts[ValueProfile::CellValue]));
+    add32(Imm32(1), AbsoluteAddress(&profile->structureCounts[0]));
+    done.append(jump());
+
+    otherStructure.link(this);
+    JITStubCall stubCall(this, cti_vm_profile_cell);
+    stubCall.addArgument(ImmPtr(profile));
+    stubCall.addArgument(regT0);
+    stubCall.call();
+    loadPtr(Address(callFrameRegister, dst * sizeof(Register)), regT0);
+    done.append(jump());
+
+    notCell.link(this);
+    add32(Imm32(1), AbsoluteAddress(&profile->counts[ValueProfile::OtherValue]));
+
+    done.link(this);
+    m_lastResultBytecodeRegister = dst;
+    m_bytecodeIndex = nextBytecodeIndex;
+}
+#endif
+
+#if ENABLE(JIT_OPTIMIZING_TIER) || ENABLE(INTERPRETER_OSR)
+void JIT::findLoopHeaders()
+{
+    Instruction* instructionsBegin = m_codeBlock->instructions().begin();
+    unsigned instructionCount = m_codeBlock->instructions().size();
+
+    for (unsigned bytecodeIndex = 0; bytecodeIndex < instructionCount; ) {
+        Instruction* instruction = instructionsBegin + bytecodeIndex;
+        OpcodeID opcodeID = m_interpreter->getOpcodeID(instruction->u.opcode);
+        switch (opcodeID) {
+        case op_loop:
+            m_loopHeaders.append(bytecodeIndex + instruction[1].u.operand);
+            break;
+        case op_loop_if_true:
+        case op_loop_if_false:
+            m_loopHeaders.append(bytecodeIndex + instruction[2].u.operand);
+            break;
+        case op_loop_if_less:
+        case op_loop_if_lesseq:
+            m_loopHeaders.append(bytecodeIndex + instruction[3].u.operand);
+            break;
+        case op_next_pname:
+            m_loopHeaders.append(bytecodeIndex + instruction[6].u.operand);
+            break;
+        default:
+            break;
+        }
+#if ENABLE(JIT_OPTIMIZING_TIER)
+        if (isSpeculativeOpcode(opcodeID))
+            m_hasSpeculativeInstructions = true;
+#endif
+        bytecodeIndex += opcodeLengths[opcodeID];
+    }
+
+    std::sort(m_loopHeaders.begin(), m_loopHeaders.end());
+}
+
+bool JIT::isLoopHeader(unsigned bytecodeIndex)
+{
+    return std::binary_search(m_loopHeaders.begin(), m_loopHeaders.end(), bytecodeIndex);
+}
+#endif
+
+#if ENABLE(INTERPRETER_OSR)
+// Global and function code run in the interpreter until one of their loops gets
+// hot, and then enter here. The interpreter has already done everything up to the
+// loop header, so all this has to do is what the prologue would have done to the
+// frame, which is to record where op_end or op_ret should return to.
+void JIT::emitLoopEntryPoints()
+{
+#if ENABLE(JIT_OPTIMIZING_TIER)
+    if (isOptimizing())
+        return;
+#endif
+    if (m_codeBlock->codeType() == EvalCode)
+        return;
+
+    for (size_t i = 0; i < m_loopHeaders.size(); ++i) {
+        unsigned bytecodeIndex = m_loopHeaders[i];
+        if (i && bytecodeIndex == m_loopHeaders[i - 1])
+            continue;
+
+        m_loopEntryPoints.append(OSRPointRecord(bytecodeIndex, label(), std::numeric_limits<int>::max()));
+        preserveReturnAddressAfterCall(regT2);
+        emitPutToCallFrameHeader(regT2, RegisterFile::ReturnPC);
+        jump().linkTo(m_labels[bytecodeIndex], this);
+    }
+}
+#endif
+
+#if ENABLE(JIT_OPTIMIZING_TIER)
+
+// Registers the optimizing tier may keep virtual registers in. Everything else is
+// either pinned (call frame, tags, timeout count) or the macro assembler's scratch.
+static const X86Registers::RegisterID speculativeRegisters[] = {
+    X86Registers::eax, X86Registers::edx, X86Registers::ecx, X86Registers::ebx, X86Registers::esi,
+    X86Registers::edi, X86Registers::r8, X86Registers::r9, X86Registers::r10
+};
+static const unsigned numberOfSpeculativeRegisters = sizeof(speculativeRegisters) / sizeof(speculativeRegisters[0]);
+
+// Registers unboxed doubles are kept in; no template code expects any of them to survive.
+static const X86Registers::XMMRegisterID speculativeFPRegisters[] = {
+    X86Registers::xmm0, X86Registers::xmm1, X86Registers::xmm2, X86Registers::xmm3,
+    X86Registers::xmm4, X86Registers::xmm5, X86Registers::xmm6, X86Registers::xmm7
+};
+static const unsigned numberOfSpeculativeFPRegisters = sizeof(speculativeFPRegisters) / sizeof(speculativeFPRegisters[0]);
+
+// A register loop pins locals to the last of these, leaving enough for the
+// operands, result and scratch register of any one instruction.
+static const unsigned maximumRegisterLoopValues = numberOfSpeculativeRegisters - 4;
+
+bool JIT::isSpeculativeOpcode(OpcodeID opcodeID)
+{
+    switch (opcodeID) {
+    case op_add:
+    case op_sub:
+    case op_mul:
+    case op_div:
+    case op_bitand:
+    case op_bitor:
+    case op_bitxor:
+    case op_lshift:
+    case op_rshift:
+    case op_urshift:
+    case op_pre_inc:
+    case op_pre_dec:
+    case op_post_inc:
+    case op_post_dec:
+    case op_jless:
+    case op_jnless:
+    case op_jlesseq:
+    case op_jnlesseq:
+    case op_loop_if_less:
+    case op_loop_if_lesseq:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool JIT::isJumpTarget(unsigned bytecodeIndex)
+{
+    int low = 0;
+    int high = m_codeBlock->numberOfJumpTargets();
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (m_codeBlock->jumpTarget(mid) < bytecodeIndex)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low < static_cast<int>(m_codeBlock->numberOfJumpTargets()) && m_codeBlock->jumpTarget(low) == bytecodeIndex;
+}
+
+// Only function code is counted: program and eval code runs once, and optimizing
+// a CodeBlock with nothing to speculate on would buy nothing.
+bool JIT::emitsOptimizationCounter()
+{
+    return !isOptimizing() && m_codeBlock->codeType() == FunctionCode && m_hasSpeculativeInstructions;
+}
+
+void JIT::addOSRPoint(int cachedResultRegister)
+{
+    m_osrPoints.append(OSRPointRecord(m_bytecodeIndex, m_labels[m_bytecodeIndex], cachedResultRegister));
+}
+
+void JIT::emitOptimizationCheck()
+{
+    Jump skipOptimize = branchAdd32(NonZero, Imm32(1), AbsoluteAddress(m_codeBlock->addressOfOptimizationCounter()));
+    JITStubCall stubCall(this, cti_vm_optimize);
+    stubCall.addArgument(Imm32(m_bytecodeIndex));
+    stubCall.call();
+    if (m_bytecodeIndex) {
+        // On-stack replacement: continue this frame in the optimized code.
+        Jump stayInBaseline = branchTestPtr(Zero, returnValueRegister);
+        jump(returnValueRegister);
+        stayInBaseline.link(this);
+    }
+    skipOptimize.link(this);
+}
+
+void JIT::emitSpeculationFailureCheck()
+{
+    Jump keepOptimizedCode = branch32(Below, AbsoluteAddress(m_baselineCodeBlock->addressOfSpeculationFailures()), Imm32(m_globalData->speculationFailureLimit));
+    JITStubCall(this, cti_vm_deoptimize).call();
+    keepOptimizedCode.link(this);
+}
+
+JIT::SpeculativeValue* JIT::findSpeculativeValue(int virtualRegister)
+{
+    for (unsigned i = 0; i < m_speculativeValues.size(); ++i) {
+        if (m_speculativeValues[i].virtualRegister == virtualRegister)
+            return &m_speculativeValues[i];
+    }
+    return 0;
+}
+
+bool JIT::getSpeculativeConstant(int virtualRegister, JSValue& value)
+{
+    if (m_codeBlock->isConstantRegisterIndex(virtualRegister)) {
+        value = m_codeBlock->getConstant(virtualRegister);
+        return true;
+    }
+    SpeculativeValue* speculativeValue = findSpeculativeValue(virtualRegister);
+    if (!speculativeValue || !speculativeValue->isConstant)
+        return false;
+    value = JSValue::decode(speculativeValue->constant);
+    return true;
+}
+
+bool JIT::getSpeculativeConstantInt32(int virtualRegister, int32_t& value)
+{
+    JSValue constant;
+    if (!getSpeculativeConstant(virtualRegister, constant) || !constant.isInt32())
+        return false;
+    value = constant.asInt32();
+    return true;
+}
+
+void JIT::beginSpeculativeInstruction()
+{
+    for (unsigned i = 0; i < m_speculativeValues.size(); ++i)
+        m_speculativeValues[i].isLocked = false;
+    m_reservedSpeculativeRegisters = 0;
+    m_reservedSpeculativeFPRegisters = 0;
+
+    // Pick up the result the preceding template instruction left in regT0.
+    int lastResult = m_lastResultBytecodeRegister;
+    killLastResultRegister();
+    if (lastResult == std::numeric_limits<int>::max() || !m_codeBlock->isTemporaryRegisterIndex(lastResult) || isJumpTarget(m_bytecodeIndex))
+        return;
+    if (findSpeculativeValue(lastResult) || isSpeculativeRegisterInUse(regT0))
+        return;
+    makeRoomForSpeculativeValue();
+    SpeculativeValue value = { lastResult, regT0, fpRegT0, 0, ++m_speculativeUseCount, false, false, false, false, false, false };
+    m_speculativeValues.append(value);
+}
+
+bool JIT::isSpeculativeRegisterInUse(RegisterID reg)
+{
+    if (m_reservedSpeculativeRegisters & (1u << reg))
+        return true;
+    for (unsigned i = 0; i < m_speculativeValues.size(); ++i) {
+        if (!m_speculativeValues[i].isConstant && !m_speculativeValues[i].isDouble && m_speculativeValues[i].reg == reg)
+            return true;
+    }
+    return false;
+}
+
+void JIT::makeRoomForSpeculativeValue()
+{
+    if (m_speculativeValues.size() < maximumSpeculativeValues)
+        return;
+
+    unsigned victim = m_speculativeValues.size();
+    for (unsigned i = 0; i < m_speculativeValues.size(); ++i) {
+        if (!m_speculativeValues[i].isLocked && !m_speculativeValues[i].isPinned && (victim == m_speculativeValues.size() || m_speculativeValues[i].lastUse < m_speculativeValues[victim].lastUse))
+            victim = i;
+    }
+    ASSERT(victim < m_speculativeValues.size());
+    if (m_speculativeValues[victim].isDirty)
+        spillSpeculativeValue(m_speculativeValues[victim]);
+    m_speculativeValues.remove(victim);
+}
+
+JIT::RegisterID JIT::allocateSpeculativeRegister()
+{
+    for (unsigned i = 0; i < numberOfSpeculativeRegisters; ++i) {
+        if (!isSpeculativeRegisterInUse(speculativeRegisters[i])) {
+            m_reservedSpeculativeRegisters |= 1u << speculativeRegisters[i];
+            return speculativeRegisters[i];
+        }
+    }
+
+    // Evict the least recently used value that the current instruction is not using.
+    unsigned victim = m_speculativeValues.size();
+    for (unsigned i = 0; i < m_speculativeValues.size(); ++i) {
+        SpeculativeValue& value = m_speculativeValues[i];
+        if (value.isConstant || value.isDouble || value.isLocked || value.isPinned)
+            continue;
+        if (victim == m_speculativeValues.size() || value.lastUse < m_speculativeValues[victim].lastUse)
+            victim = i;
+    }
+    ASSERT(victim < m_speculativeValues.size());
+    RegisterID reg = m_speculativeValues[victim].reg;
+    if (m_speculativeValues[victim].isDirty)
+        spillSpeculativeValue(m_speculativeValues[victim]);
+    m_speculativeValues.remove(victim);
+    m_reservedSpeculativeRegisters |= 1u << reg;
+    return reg;
+}
+
+bool JIT::isSpeculativeFPRegisterInUse(FPRegisterID fpReg)
+{
+    if (m_reservedSpeculativeFPRegisters & (1u << fpReg))
+        return true;
+    for (unsigned i = 0; i < m_speculativeValues.size(); ++i) {
+        if (m_speculativeValues[i].isDouble && m_speculativeValues[i].fpReg == fpReg)
+            return true;
+    }
+    return false;
+}
+
+JIT::FPRegisterID JIT::allocateSpeculativeFPRegister()
+{
+    for (unsigned i = 0; i < numberOfSpeculativeFPRegisters; ++i) {
+        if (!isSpeculativeFPRegisterInUse(speculativeFPRegisters[i])) {
+            m_reservedSpeculativeFPRegisters |= 1u << speculativeFPRegisters[i];
+            return speculativeFPRegisters[i];
+        }
+    }
+
+    unsigned victim = m_speculativeValues.size();
+    for (unsigned i = 0; i < m_speculativeValues.size(); ++i) {
+        SpeculativeValue& value = m_speculativeValues[i];
+        if (!value.isDouble || value.isLocked)
+            continue;
+        if (victim == m_speculativeValues.size() || value.lastUse < m_speculativeValues[victim].lastUse)
+            victim = i;
+    }
+    ASSERT(victim < m_speculativeValues.size());
+    FPRegisterID fpReg = m_speculativeValues[victim].fpReg;
+    if (m_speculativeValues[victim].isDirty)
+        spillSpeculativeValue(m_speculativeValues[victim]);
+    m_speculativeValues.remove(victim);
+    m_reservedSpeculativeFPRegisters |= 1u << fpReg;
+    return fpReg;
+}
+
+JIT::RegisterID JIT::speculativeGet(int virtualRegister)
+{
+    ASSERT(!m_codeBlock->isConstantRegisterIndex(virtualRegister));
+
+    SpeculativeValue* value = findSpeculativeValue(virtualRegister);
+    if (value && value->isDouble) {
+        // Integer operations take an unboxed double only if it holds an int32,
+        // boxed into a register of the instruction's own.
+        value->lastUse = ++m_speculativeUseCount;
+        value->isLocked = true;
+        FPRegisterID fpReg = value->fpReg;
+        RegisterID reg = allocateSpeculativeRegister();
+        JumpList notInt32;
+        branchConvertDoubleToInt32(fpReg, reg, notInt32, allocateSpeculativeFPRegister());
+        const JumpList::JumpVector& jumps = notInt32.jumps();
+        for (unsigned i = 0; i < jumps.size(); ++i)
+            addSpeculationExit(jumps[i]);
+        orPtr(tagTypeNumberRegister, reg);
+        return reg;
+    }
+    if (value && !value->isConstant) {
+        value->lastUse = ++m_speculativeUseCount;
+        value->isLocked = true;
+        return value->reg;
+    }
+
+    RegisterID reg = allocateSpeculativeRegister();
+    m_reservedSpeculativeRegisters &= ~(1u << reg);
+
+    // Allocation may have evicted other values, so look the register up again.
+    value = findSpeculativeValue(virtualRegister);
+    if (value) {
+        move(ImmPtr(value->constant), reg);
+        value->isConstant = false;
+        value->reg = reg;
+        value->lastUse = ++m_speculativeUseCount;
+        value->isLocked = true;
+        return reg;
+    }
+
+    loadPtr(Address(callFrameRegister, virtualRegister * sizeof(Register)), reg);
+    makeRoomForSpeculativeValue();
+    SpeculativeValue newValue = { virtualRegister, reg, fpRegT0, 0, ++m_speculativeUseCount, false, false, false, false, true, false };
+    m_speculativeValues.append(newValue);
+    return reg;
+}
+
+JIT::FPRegisterID JIT::speculativeGetDouble(int virtualRegister)
+{
+    JSValue constant;
+    if (getSpeculativeConstant(virtualRegister, constant)) {
+        ASSERT(constant.isNumber());
+        FPRegisterID fpReg = allocateSpeculativeFPRegister();
+        RegisterID scratch = allocateSpeculativeRegister();
+        if (constant.isInt32()) {
+            move(Imm32(constant.asInt32()), scratch);
+            convertInt32ToDouble(scratch, fpReg);
+        } else {
+            move(ImmPtr(JSValue::encode(constant)), scratch);
+            addPtr(tagTypeNumberRegister, scratch);
+            movePtrToDouble(scratch, fpReg);
+        }
+        m_reservedSpeculativeRegisters &= ~(1u << scratch);
+        return fpReg;
+    }
+
+    SpeculativeValue* value = findSpeculativeValue(virtualRegister);
+    if (value && value->isDouble) {
+        value->lastUse = ++m_speculativeUseCount;
+        value->isLocked = true;
+        return value->fpReg;
+    }
+
+    // Anything else is converted into a register of the instruction's own, leaving
+    // the boxed value where it is.
+    RegisterID reg = speculativeGet(virtualRegister);
+    FPRegisterID fpReg = allocateSpeculativeFPRegister();
+    if (findSpeculativeValue(virtualRegister)->isInt32) {
+        convertInt32ToDouble(reg, fpReg);
+        return fpReg;
+    }
+    Jump isInt32 = branchPtr(AboveOrEqual, reg, tagTypeNumberRegister);
+    addSpeculationExit(branchTestPtr(Zero, reg, tagTypeNumberRegister));
+    addPtr(tagTypeNumberRegister, reg);
+    movePtrToDouble(reg, fpReg);
+    subPtr(tagTypeNumberRegister, reg);
+    Jump done = jump();
+    isInt32.link(this);
+    convertInt32ToDouble(reg, fpReg);
+    done.link(this);
+    return fpReg;
+}
+
+void JIT::speculateInt32(int virtualRegister)
+{
+    SpeculativeValue* value = findSpeculativeValue(virtualRegister);
+    ASSERT(value && !value->isConstant);
+    if (value->isInt32 || value->isDouble)
+        return;
+    addSpeculationExit(branchPtr(Below, value->reg, tagTypeNumberRegister));
+    value->isInt32 = true;
+}
+
+void JIT::removeSpeculativeValue(int virtualRegister)
+{
+    for (unsigned i = 0; i < m_speculativeValues.size(); ++i) {
+        if (m_speculativeValues[i].virtualRegister == virtualRegister) {
+            m_speculativeValues.remove(i);
+            return;
+        }
+    }
+}
+
+void JIT::setSpeculativeResult(int virtualRegister, RegisterID reg, bool isInt32)
+{
+    SpeculativeValue* pinnedValue = findSpeculativeValue(virtualRegister);
+    if (pinnedValue && pinnedValue->isPinned) {
+        ASSERT(isInt32);
+        move(reg, pinnedValue->reg);
+        pinnedValue->lastUse = ++m_speculativeUseCount;
+        m_reservedSpeculativeRegisters &= ~(1u << reg);
+        return;
+    }
+
+    removeSpeculativeValue(virtualRegister);
+    makeRoomForSpeculativeValue();
+    m_reservedSpeculativeRegisters &= ~(1u << reg);
+    SpeculativeValue value = { virtualRegister, reg, fpRegT0, 0, ++m_speculativeUseCount, false, true, isInt32, false, true, false };
+    m_speculativeValues.append(value);
+}
+
+void JIT::setSpeculativeDoubleResult(int virtualRegister, FPRegisterID fpReg)
+{
+    removeSpeculativeValue(virtualRegister);
+    makeRoomForSpeculativeValue();
+    m_reservedSpeculativeFPRegisters &= ~(1u << fpReg);
+    SpeculativeValue value = { virtualRegister, regT0, fpReg, 0, ++m_speculativeUseCount, false, true, false, true, true, false };
+    m_speculativeValues.append(value);
+}
+
+void JIT::setSpeculativeConstantResult(int virtualRegister, JSValue constant)
+{
+    SpeculativeValue* pinnedValue = findSpeculativeValue(virtualRegister);
+    if (pinnedValue && pinnedValue->isPinned) {
+        ASSERT(constant.isInt32());
+        move(ImmPtr(JSValue::encode(constant)), pinnedValue->reg);
+        pinnedValue->lastUse = ++m_speculativeUseCount;
+        return;
+    }
+
+    removeSpeculativeValue(virtualRegister);
+    makeRoomForSpeculativeValue();
+    SpeculativeValue value = { virtualRegister, regT0, fpRegT0, JSValue::encode(constant), ++m_speculativeUseCount, true, true, constant.isInt32(), false, false, false };
+    m_speculativeValues.append(value);
+}
+
+void JIT::spillSpeculativeValue(const SpeculativeValue& value)
+{
+    Address address(callFrameRegister, value.virtualRegister * sizeof(Register));
+    if (value.isConstant)
+        storePtr(ImmPtr(value.constant), address);
+    else if (value.isDouble) {
+        // Boxed in the macro assembler's scratch register, which no speculative value is kept in.
+        moveDoubleToPtr(value.fpReg, scratchRegister);
+        subPtr(tagTypeNumberRegister, scratchRegister);
+        storePtr(scratchRegister, address);
+    } else
+        storePtr(value.reg, address);
+}
+
+// Pinned values stay dirty: every branch that keeps them in registers stays in their loop.
+void JIT::flushSpeculativeValues()
+{
+    for (unsigned i = 0; i < m_speculativeValues.size(); ++i) {
+        if (m_speculativeValues[i].isDirty && !m_speculativeValues[i].isPinned) {
+            spillSpeculativeValue(m_speculativeValues[i]);
+            m_speculativeValues[i].isDirty = false;
+        }
+    }
+}
+
+void JIT::forgetSpeculativeValues()
+{
+    for (unsigned i = m_speculativeValues.size(); i--; ) {
+        if (!m_speculativeValues[i].isPinned)
+            m_speculativeValues.remove(i);
+    }
+    m_reservedSpeculativeRegisters = 0;
+    m_reservedSpeculativeFPRegisters = 0;
+}
+
+void JIT::addSpeculationExit(Jump from)
+{
+    m_speculationExits.append(SpeculationExit(from, m_bytecodeIndex));
+    Vector<SpeculativeValue>& dirtyValues = m_speculationExits.last().dirtyValues;
+    for (unsigned i = 0; i < m_speculativeValues.size(); ++i) {
+        if (m_speculativeValues[i].isDirty)
+            dirtyValues.append(m_speculativeValues[i]);
+    }
+}
+
+void JIT::addSpeculativeJump(Jump jump, int relativeOffset)
+{
+    if (m_currentRegisterLoop)
+        m_currentRegisterLoop->jumps.append(JumpTable(jump, m_bytecodeIndex + relativeOffset));
+    else
+        addJump(jump, relativeOffset);
+}
+
+// A failed speculation writes back what only lived in registers and resumes the
+// same instruction in the baseline code, which redoes it without assumptions.
+void JIT::emitSpeculationExits()
+{
+    for (Vector<SpeculationExit>::iterator iter = m_speculationExits.begin(); iter != m_speculationExits.end(); ++iter) {
+        OSRPoint* osrPoint = m_baselineCodeBlock->osrPointForBytecodeIndex(iter->bytecodeIndex);
+        ASSERT(osrPoint);
+
+        iter->from.link(this);
+        for (unsigned i = 0; i < iter->dirtyValues.size(); ++i)
+            spillSpeculativeValue(iter->dirtyValues[i]);
+        emitPutImmediateToCallFrameHeader(m_baselineCodeBlock, RegisterFile::CodeBlock);
+        if (osrPoint->cachedResultRegister != std::numeric_limits<int>::max())
+            loadPtr(Address(callFrameRegister, osrPoint->cachedResultRegister * sizeof(Register)), cachedResultRegister);
+        add32(Imm32(1), AbsoluteAddress(m_baselineCodeBlock->addressOfSpeculationFailures()));
+        move(ImmPtr(osrPoint->machineCode.executableAddress()), regT1);
+        jump(regT1);
+    }
+}
+
+// Register loops are innermost loops, closed by op_loop_if_less or op_loop_if_lesseq,
+// whose every instruction the optimizing tier is sure to speculate. Their most used
+// int32 locals live in machine registers from the loop header to the back edge, and
+// are only written to the register file on the way out.
+void JIT::findRegisterLoops()
+{
+    Instruction* instructionsBegin = m_codeBlock->instructions().begin();
+    unsigned instructionCount = m_codeBlock->instructions().size();
+
+    for (unsigned bytecodeIndex = 0; bytecodeIndex < instructionCount; ) {
+        Instruction* instruction = instructionsBegin + bytecodeIndex;
+        OpcodeID opcodeID = m_interpreter->getOpcodeID(instruction->u.opcode);
+        if ((opcodeID == op_loop_if_less || opcodeID == op_loop_if_lesseq) && instruction[3].u.operand < 0)
+            addRegisterLoop(bytecodeIndex + instruction[3].u.operand, bytecodeIndex);
+        bytecodeIndex += opcodeLengths[opcodeID];
+    }
+}
+
+void JIT::addRegisterLoop(unsigned header, unsigned backEdge)
+{
+    Instruction* instructionsBegin = m_codeBlock->instructions().begin();
+    if (!isJumpTarget(header))
+        return;
+
+    RegisterLoop loop;
+    loop.header = header;
+    loop.end = backEdge + OPCODE_LENGTH(op_loop_if_less);
+
+    Vector<unsigned> useCounts;
+    useCounts.fill(0, m_codeBlock->m_numVars);
+    Vector<unsigned> moves;
+    for (unsigned bytecodeIndex = header; bytecodeIndex < loop.end; ) {
+        Instruction* instruction = instructionsBegin + bytecodeIndex;
+        OpcodeID opcodeID = m_interpreter->getOpcodeID(instruction->u.opcode);
+        if (!canSpeculateInRegisterLoop(bytecodeIndex))
+            return;
+        if (bytecodeIndex != header && isLoopHeader(bytecodeIndex))
+            return;
+
+        // Every way in must have somewhere to resume the baseline code, should a
+        // local turn out not to be an int32, and branches must stay in the loop.
+        if ((bytecodeIndex == header || isJumpTarget(bytecodeIndex)) && !m_baselineCodeBlock->osrPointForBytecodeIndex(bytecodeIndex))
+            return;
+        unsigned registerOperands;
+        switch (opcodeID) {
+        case op_mov:
+            moves.append(bytecodeIndex);
+            registerOperands = 0;
+            break;
+        case op_jmp: {
+            unsigned target = bytecodeIndex + instruction[1].u.operand;
+            if (target < header || target > backEdge)
+                return;
+            registerOperands = 0;
+            break;
+        }
+        case op_pre_inc:
+        case op_pre_dec:
+            registerOperands = 1;
+            break;
+        case op_post_inc:
+        case op_post_dec:
+            registerOperands = 2;
+            break;
+        case op_loop_if_less:
+        case op_loop_if_lesseq:
+            if (bytecodeIndex != backEdge)
+                return;
+            registerOperands = 2;
+            break;
+        case op_jless:
+        case op_jnless:
+        case op_jlesseq:
+        case op_jnlesseq: {
+            unsigned target = bytecodeIndex + instruction[3].u.operand;
+            if (target < header || target > backEdge)
+                return;
+            registerOperands = 2;
+            break;
+        }
+        default:
+            registerOperands = 3;
+            break;
+        }
+
+        for (unsigned i = 1; i <= registerOperands; ++i) {
+            int virtualRegister = instruction[i].u.operand;
+            if (virtualRegister >= 0 && !m_codeBlock->isTemporaryRegisterIndex(virtualRegister))
+                ++useCounts[virtualRegister];
+        }
+        bytecodeIndex += opcodeLengths[opcodeID];
+    }
+
+    while (loop.virtualRegisters.size() < maximumRegisterLoopValues) {
+        int mostUsed = -1;
+        for (int virtualRegister = 0; virtualRegister < m_codeBlock->m_numVars; ++virtualRegister) {
+            if (useCounts[virtualRegister] && (mostUsed == -1 || useCounts[virtualRegister] > useCounts[mostUsed]))
+                mostUsed = virtualRegister;
+        }
+        if (mostUsed == -1)
+            break;
+        loop.virtualRegisters.append(mostUsed);
+        useCounts[mostUsed] = 0;
+    }
+
+    // Arithmetic only ever leaves int32s in a pinned local, but a copy of anything
+    // other than an int32 constant or another pinned local might not.
+    for (bool changed = true; changed; ) {
+        changed = false;
+        for (size_t i = 0; i < moves.size(); ++i) {
+            Instruction* instruction = instructionsBegin + moves[i];
+            size_t index = loop.virtualRegisters.find(instruction[1].u.operand);
+            int src = instruction[2].u.operand;
+            if (index == notFound || m_codeBlock->isConstantRegisterIndex(src) || loop.virtualRegisters.find(src) != notFound)
+                continue;
+            loop.virtualRegisters.remove(index);
+            changed = true;
+        }
+    }
+    if (loop.virtualRegisters.isEmpty())
+        return;
+
+    for (size_t i = 0; i < loop.virtualRegisters.size(); ++i)
+        loop.registers.append(speculativeRegisters[numberOfSpeculativeRegisters - 1 - i]);
+    m_registerLoops.append(loop);
+}
+
+// Whether emitSpeculativeInstruction is sure to speculate the instruction, whatever
+// constants it comes to know of by then; a template would clobber the pinned registers.
+bool JIT::canSpeculateInRegisterLoop(unsigned bytecodeIndex)
+{
+    Instruction* instruction = m_codeBlock->instructions().begin() + bytecodeIndex;
+    OpcodeID opcodeID = m_interpreter->getOpcodeID(instruction->u.opcode);
+
+    // Instructions reading a known constant only speculate if it is an int32.
+    if (opcodeID == op_mov) {
+        int src = instruction[2].u.operand;
+        return !m_codeBlock->isConstantRegisterIndex(src) || m_codeBlock->getConstant(src).isInt32();
+    }
+    if (opcodeID == op_jmp)
+        return true;
+    // Division is always done in doubles, which the pinned registers cannot hold.
+    if (opcodeID == op_div)
+        return false;
+
+    if (!isSpeculativeOpcode(opcodeID) || !m_baselineCodeBlock->osrPointForBytecodeIndex(bytecodeIndex))
+        return false;
+#if ENABLE(VALUE_PROFILER)
+    if (ValueProfile* profile = m_baselineCodeBlock->valueProfileForBytecodeOffset(bytecodeIndex)) {
+        if (!profile->hasOnlyInt32Samples())
+            return false;
+    }
+#endif
+
+    int op1;
+    int op2;
+    switch (opcodeID) {
+    case op_add:
+    case op_sub:
+    case op_mul:
+    case op_bitand:
+    case op_bitor:
+    case op_bitxor: {
+        OperandTypes types = OperandTypes::fromInt(instruction[4].u.operand);
+        if (!types.first().mightBeNumber() || !types.second().mightBeNumber())
+            return false;
+        op1 = instruction[2].u.operand;
+        op2 = instruction[3].u.operand;
+        break;
+    }
+    case op_lshift:
+    case op_rshift:
+    case op_urshift: {
+        // Only shifts by a constant are speculated.
+        int shift = instruction[3].u.operand;
+        if (!m_codeBlock->isConstantRegisterIndex(shift) || !m_codeBlock->getConstant(shift).isInt32())
+            return false;
+        op1 = instruction[2].u.operand;
+        return !m_codeBlock->isConstantRegisterIndex(op1) || m_codeBlock->getConstant(op1).isInt32();
+    }
+    case op_pre_inc:
+    case op_pre_dec:
+        return true;
+    case op_post_inc:
+    case op_post_dec:
+        return instruction[1].u.operand != instruction[2].u.operand;
+    default:
+        op1 = instruction[1].u.operand;
+        op2 = instruction[2].u.operand;
+        break;
+    }
+
+    // Two literals are left to the template, rather than folded or compared in registers.
+    bool op1IsConstant = m_codeBlock->isConstantRegisterIndex(op1);
+    bool op2IsConstant = m_codeBlock->isConstantRegisterIndex(op2);
+    if (op1IsConstant && op2IsConstant)
+        return false;
+    return (!op1IsConstant || m_codeBlock->getConstant(op1).isInt32()) && (!op2IsConstant || m_codeBlock->getConstant(op2).isInt32());
+}
+
+void JIT::enterRegisterLoop()
+{
+    ASSERT(!m_currentRegisterLoop);
+    ASSERT(m_speculativeValues.isEmpty());
+
+    m_currentRegisterLoop = &m_registerLoops[m_nextRegisterLoop++];
+    loadRegisterLoopValues(*m_currentRegisterLoop, m_bytecodeIndex);
+    for (size_t i = 0; i < m_currentRegisterLoop->virtualRegisters.size(); ++i) {
+        SpeculativeValue value = { m_currentRegisterLoop->virtualRegisters[i], m_currentRegisterLoop->registers[i], fpRegT0, 0, ++m_speculativeUseCount, false, true, true, false, false, true };
+        m_speculativeValues.append(value);
+    }
+    m_currentRegisterLoop->body = label();
+}
+
+// Falling out of the back edge is the only way out of a register loop other than a
+// failed speculation, which writes the pinned values back itself.
+void JIT::leaveRegisterLoop()
+{
+    for (unsigned i = m_speculativeValues.size(); i--; ) {
+        if (m_speculativeValues[i].isPinned) {
+            spillSpeculativeValue(m_speculativeValues[i]);
+            m_speculativeValues.remove(i);
+        }
+    }
+    m_currentRegisterLoop = 0;
+}
+
+// Coming from outside the loop, nothing is dirty yet, so a local that is not an
+// int32 just resumes the instruction in the baseline code.
+void JIT::loadRegisterLoopValues(const RegisterLoop& loop, unsigned bytecodeIndex)
+{
+    for (size_t i = 0; i < loop.virtualRegisters.size(); ++i) {
+        loadPtr(Address(callFrameRegister, loop.virtualRegisters[i] * sizeof(Register)), loop.registers[i]);
+        m_speculationExits.append(SpeculationExit(branchPtr(Below, loop.registers[i], tagTypeNumberRegister), bytecodeIndex));
+    }
+}
+
+// The timeout check calls out, which clobbers every register a value may be pinned to.
+void JIT::emitRegisterLoopTimeoutCheck()
+{
+    const RegisterLoop& loop = *m_currentRegisterLoop;
+
+    Jump skipTimeout = branchSub32(NonZero, Imm32(1), timeoutCheckRegister);
+    for (size_t i = 0; i < loop.virtualRegisters.size(); ++i)
+        storePtr(loop.registers[i], Address(callFrameRegister, loop.virtualRegisters[i] * sizeof(Register)));
+    JITStubCall(this, cti_timeout_check).call(timeoutCheckRegister);
+    for (size_t i = 0; i < loop.virtualRegisters.size(); ++i)
+        loadPtr(Address(callFrameRegister, loop.virtualRegisters[i] * sizeof(Register)), loop.registers[i]);
+    skipTimeout.link(this);
+
+    killLastResultRegister();
+}
+
+// Branches within a register loop go straight to code that expects the pinned values
+// in registers. Every other way in - a jump from outside, OSR entry, or falling into
+// the header - goes through code that loads them first.
+void JIT::emitRegisterLoopEntries()
+{
+    for (size_t i = 0; i < m_registerLoops.size(); ++i) {
+        RegisterLoop& loop = m_registerLoops[i];
+        for (size_t j = 0; j < loop.jumps.size(); ++j) {
+            unsigned target = loop.jumps[j].toBytecodeIndex;
+            loop.jumps[j].from.linkTo(target == loop.header ? loop.body : m_labels[target], this);
+        }
+
+        Instruction* instructionsBegin = m_codeBlock->instructions().begin();
+        unsigned bytecodeIndex = loop.header + opcodeLengths[m_interpreter->getOpcodeID(instructionsBegin[loop.header].u.opcode)];
+        while (bytecodeIndex < loop.end) {
+            if (isJumpTarget(bytecodeIndex)) {
+                Label entry = label();
+                loadRegisterLoopValues(loop, bytecodeIndex);
+                jump().linkTo(m_labels[bytecodeIndex], this);
+                m_labels[bytecodeIndex] = entry;
+            }
+            bytecodeIndex += opcodeLengths[m_interpreter->getOpcodeID(instructionsBegin[bytecodeIndex].u.opcode)];
+        }
+    }
+}
+
+#endif // ENABLE(JIT_OPTIMIZING_TIER)
+
 } // namespace JSC
 
 #endif // ENABLE(JIT)
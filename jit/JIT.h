@@ -183,6 +183,15 @@ namespace JSC {
             return JIT(globalData, codeBlock, offsetBase).privateCompile();
         }
 
+#if ENABLE(JIT_OPTIMIZING_TIER)
+        // Compiles codeBlock, a copy of baselineCodeBlock's bytecode, with the optimizing
+        // tier. Failed speculations resume in baselineCodeBlock's machine code.
+        static JITCode compileOptimized(JSGlobalData* globalData, CodeBlock* codeBlock, CodeBlock* baselineCodeBlock)
+        {
+            return JIT(globalData, codeBlock, 0, baselineCodeBlock).privateCompile();
+        }
+#endif
+
         static void compileGetByIdProto(JSGlobalData* globalData, CallFrame* callFrame, CodeBlock* codeBlock, StructureStubInfo* stubInfo, Structure* structure, Structure* prototypeStructure, const Identifier& ident, const PropertySlot& slot, size_t cachedOffset, ReturnAddressPtr returnAddress)
         {
             JIT jit(globalData, codeBlock);
@@ -216,6 +225,13 @@ namespace JSC {
             JIT jit(globalData, codeBlock);
             jit.privateCompilePutByIdTransition(stubInfo, oldStructure, newStructure, cachedOffset, chain, returnAddress, direct);
         }
+#if !USE(JSVALUE32_64)
+        static void compilePutByIdList(JSGlobalData* globalData, CodeBlock* codeBlock, StructureStubInfo* stubInfo, PolymorphicPutByIdList* polymorphicStructures, int currentIndex, Structure* oldStructure, Structure* newStructure, size_t cachedOffset, StructureChain* chain, ReturnAddressPtr returnAddress, bool direct)
+        {
+            JIT jit(globalData, codeBlock);
+            jit.privateCompilePutByIdList(stubInfo, polymorphicStructures, currentIndex, oldStructure, newStructure, cachedOffset, chain, returnAddress, direct);
+        }
+#endif
 
         static void compileCTIMachineTrampolines(JSGlobalData* globalData, RefPtr<ExecutablePool>* executablePool, TrampolineStructure *trampolines)
         {
@@ -250,7 +266,65 @@ namespace JSC {
             }
         };
 
-        JIT(JSGlobalData*, CodeBlock* = 0, void* = 0);
+#if ENABLE(JIT_OPTIMIZING_TIER) || ENABLE(INTERPRETER_OSR)
+        struct OSRPointRecord {
+            unsigned bytecodeIndex;
+            Label label;
+            int cachedResultRegister;
+
+            OSRPointRecord(unsigned bytecodeIndex, Label label, int cachedResultRegister)
+                : bytecodeIndex(bytecodeIndex)
+                , label(label)
+                , cachedResultRegister(cachedResultRegister)
+            {
+            }
+        };
+#endif
+
+#if ENABLE(JIT_OPTIMIZING_TIER)
+        // A virtual register whose current value the optimizing tier holds in a
+        // machine register or knows to be a constant, rather than in the register file.
+        struct SpeculativeValue {
+            int virtualRegister;
+            RegisterID reg;
+            FPRegisterID fpReg; // Instead of reg, for a double left unboxed.
+            EncodedJSValue constant;
+            unsigned lastUse;
+            bool isConstant : 1;
+            bool isDirty : 1;
+            bool isInt32 : 1;
+            bool isDouble : 1;
+            bool isLocked : 1;
+            bool isPinned : 1; // Stays in reg, and is stale in the register file, for the whole register loop.
+        };
+
+        struct SpeculationExit {
+            Jump from;
+            unsigned bytecodeIndex;
+            Vector<SpeculativeValue> dirtyValues;
+
+            SpeculationExit(Jump from, unsigned bytecodeIndex)
+                : from(from)
+                , bytecodeIndex(bytecodeIndex)
+            {
+            }
+        };
+
+        // An innermost loop whose every instruction is speculated, so that int32 locals
+        // can live in machine registers from the loop header to the back edge.
+        struct RegisterLoop {
+            unsigned header;
+            unsigned end; // The instruction after the back edge.
+            Vector<int, 8> virtualRegisters;
+            Vector<RegisterID, 8> registers;
+            Vector<JumpTable> jumps; // Branches within the loop, which keep the pinned values in registers.
+            Label body; // Where the header's code starts, once the pinned values are loaded.
+        };
+
+        static const unsigned maximumSpeculativeValues = 16;
+#endif
+
+        JIT(JSGlobalData*, CodeBlock* = 0, void* = 0, CodeBlock* baselineCodeBlock = 0);
 
         void privateCompileMainPass();
         void privateCompileLinkPass();
@@ -262,6 +336,10 @@ namespace JSC {
         void privateCompileGetByIdChainList(StructureStubInfo*, PolymorphicAccessStructureList*, int, Structure*, StructureChain* chain, size_t count, const Identifier&, const PropertySlot&, size_t cachedOffset, CallFrame* callFrame);
         void privateCompileGetByIdChain(StructureStubInfo*, Structure*, StructureChain*, size_t count, const Identifier&, const PropertySlot&, size_t cachedOffset, ReturnAddressPtr returnAddress, CallFrame* callFrame);
         void privateCompilePutByIdTransition(StructureStubInfo*, Structure*, Structure*, size_t cachedOffset, StructureChain*, ReturnAddressPtr returnAddress, bool direct);
+#if !USE(JSVALUE32_64)
+        void privateCompilePutByIdList(StructureStubInfo*, PolymorphicPutByIdList*, int, Structure* oldStructure, Structure* newStructure, size_t cachedOffset, StructureChain*, ReturnAddressPtr returnAddress, bool direct);
+        bool compilePutByIdTransitionStore(JumpList& failureCases, Structure* oldStructure, Structure* newStructure, size_t cachedOffset, StructureChain*, bool direct);
+#endif
 
         void privateCompileCTIMachineTrampolines(RefPtr<ExecutablePool>* executablePool, JSGlobalData* data, TrampolineStructure *trampolines);
         void privateCompilePatchGetArrayLength(ReturnAddressPtr returnAddress);
@@ -278,6 +356,9 @@ namespace JSC {
         void compileOpCallVarargsSetupArgs(Instruction*);
         void compileOpCallSlowCase(Instruction* instruction, Vector<SlowCaseEntry>::iterator& iter, unsigned callLinkInfoIndex, OpcodeID opcodeID);
         void compileOpCallVarargsSlowCase(Instruction* instruction, Vector<SlowCaseEntry>::iterator& iter);
+#if ENABLE(JIT_OPTIMIZING_TIER)
+        bool compileInlinedCall(Instruction*, unsigned callLinkInfoIndex, Jump& inlinedCallDone);
+#endif
         void compileOpConstructSetupArgs(Instruction*);
 
         enum CompileOpStrictEqType { OpStrictEq, OpNStrictEq };
@@ -289,6 +370,9 @@ namespace JSC {
 
         void testPrototype(Structure*, JumpList& failureCases);
 
+        void emitWriteBarrier(RegisterID owner, RegisterID scratch1, RegisterID scratch2);
+        void emitWriteBarrier(JSCell* owner);
+
 #if USE(JSVALUE32_64)
         bool getOperandConstantImmediateInt(unsigned op1, unsigned op2, unsigned& op, int32_t& constant);
 
@@ -838,6 +922,71 @@ namespace JSC {
         void emitRightShift(Instruction*, bool isUnsigned);
         void emitRightShiftSlowCase(Instruction*, Vector<SlowCaseEntry>::iterator&, bool isUnsigned);
 
+#if ENABLE(VALUE_PROFILER)
+        ValueProfile* valueProfileFor(OpcodeID, Instruction*);
+        void emitValueProfilingSite(ValueProfile*);
+#endif
+
+#if ENABLE(JIT_OPTIMIZING_TIER) || ENABLE(INTERPRETER_OSR)
+        void findLoopHeaders();
+        bool isLoopHeader(unsigned bytecodeIndex);
+#endif
+#if ENABLE(INTERPRETER_OSR)
+        void emitLoopEntryPoints();
+#endif
+
+#if ENABLE(JIT_OPTIMIZING_TIER)
+        bool isOptimizing() const { return m_baselineCodeBlock; }
+        bool isJumpTarget(unsigned bytecodeIndex);
+        static bool isSpeculativeOpcode(OpcodeID);
+        bool emitsOptimizationCounter();
+        void emitOptimizationCheck();
+        void emitSpeculationFailureCheck();
+        void addOSRPoint(int cachedResultRegister);
+
+        bool emitSpeculativeInstruction(OpcodeID, Instruction*);
+        bool emitSpeculative_op_mov(Instruction*);
+        bool emitSpeculative_op_jmp(Instruction*);
+        bool emitSpeculativeBinaryOp(OpcodeID, Instruction*);
+        bool emitSpeculativeShift(OpcodeID, Instruction*);
+        bool emitSpeculativeIncOrDec(OpcodeID, Instruction*);
+        bool emitSpeculativeCompareAndJump(OpcodeID, Instruction*);
+        bool emitSpeculativeDoubleArith(OpcodeID, Instruction*);
+
+        SpeculativeValue* findSpeculativeValue(int virtualRegister);
+        bool getSpeculativeConstant(int virtualRegister, JSValue&);
+        bool getSpeculativeConstantInt32(int virtualRegister, int32_t&);
+        bool canSpeculateInt32(int virtualRegister);
+        void beginSpeculativeInstruction();
+        RegisterID speculativeGet(int virtualRegister);
+        FPRegisterID speculativeGetDouble(int virtualRegister);
+        RegisterID allocateSpeculativeRegister();
+        FPRegisterID allocateSpeculativeFPRegister();
+        void makeRoomForSpeculativeValue();
+        bool isSpeculativeRegisterInUse(RegisterID);
+        bool isSpeculativeFPRegisterInUse(FPRegisterID);
+        void speculateInt32(int virtualRegister);
+        void setSpeculativeResult(int virtualRegister, RegisterID, bool isInt32);
+        void setSpeculativeDoubleResult(int virtualRegister, FPRegisterID);
+        void setSpeculativeConstantResult(int virtualRegister, JSValue);
+        void removeSpeculativeValue(int virtualRegister);
+        void spillSpeculativeValue(const SpeculativeValue&);
+        void flushSpeculativeValues();
+        void forgetSpeculativeValues();
+        void addSpeculationExit(Jump);
+        void addSpeculativeJump(Jump, int relativeOffset);
+        void emitSpeculationExits();
+
+        void findRegisterLoops();
+        void addRegisterLoop(unsigned header, unsigned backEdge);
+        bool canSpeculateInRegisterLoop(unsigned bytecodeIndex);
+        void enterRegisterLoop();
+        void leaveRegisterLoop();
+        void loadRegisterLoopValues(const RegisterLoop&, unsigned bytecodeIndex);
+        void emitRegisterLoopTimeoutCheck();
+        void emitRegisterLoopEntries();
+#endif
+
         /* These functions are deprecated: Please use JITStubCall instead. */
         void emitPutJITStubArg(RegisterID src, unsigned argumentNumber);
 #if USE(JSVALUE32_64)
@@ -948,6 +1097,26 @@ namespace JSC {
 #endif
 #endif
         void* m_linkerOffset;
+
+#if ENABLE(JIT_OPTIMIZING_TIER) || ENABLE(INTERPRETER_OSR)
+        Vector<unsigned> m_loopHeaders;
+#endif
+#if ENABLE(INTERPRETER_OSR)
+        Vector<OSRPointRecord> m_loopEntryPoints;
+#endif
+#if ENABLE(JIT_OPTIMIZING_TIER)
+        CodeBlock* m_baselineCodeBlock;
+        bool m_hasSpeculativeInstructions;
+        Vector<OSRPointRecord> m_osrPoints;
+        Vector<SpeculativeValue, maximumSpeculativeValues> m_speculativeValues;
+        unsigned m_speculativeUseCount;
+        unsigned m_reservedSpeculativeRegisters;
+        unsigned m_reservedSpeculativeFPRegisters;
+        Vector<SpeculationExit> m_speculationExits;
+        Vector<RegisterLoop> m_registerLoops;
+        RegisterLoop* m_currentRegisterLoop;
+        unsigned m_nextRegisterLoop;
+#endif
         static PassRefPtr<NativeExecutable> stringGetByValStubGenerator(JSGlobalData* globalData, ExecutablePool* pool);
     } JIT_CLASS_ALIGNMENT;
 
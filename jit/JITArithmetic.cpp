@@ -1834,6 +1834,490 @@ void JIT::emitSlow_op_sub(Instruction* currentInstruction, Vector<SlowCaseEntry>
 
 /* ------------------------------ END: OP_ADD, OP_SUB, OP_MUL ------------------------------ */
 
+#if ENABLE(JIT_OPTIMIZING_TIER)
+
+/* ------------------------------ BEGIN: Optimizing tier ------------------------------ */
+
+// Each of these either emits nothing and returns false, leaving the instruction to
+// its baseline template, or speculates that its operands are int32 and returns true.
+// Operands and results stay in machine registers between speculated instructions;
+// arithmetic on doubles keeps its results unboxed in FP registers.
+
+bool JIT::emitSpeculativeInstruction(OpcodeID opcodeID, Instruction* currentInstruction)
+{
+    if (opcodeID == op_mov)
+        return emitSpeculative_op_mov(currentInstruction);
+    if (opcodeID == op_jmp)
+        return emitSpeculative_op_jmp(currentInstruction);
+
+    // A failed speculation resumes the instruction in the baseline code.
+    if (!isSpeculativeOpcode(opcodeID) || !m_baselineCodeBlock->osrPointForBytecodeIndex(m_bytecodeIndex))
+        return false;
+
+#if ENABLE(VALUE_PROFILER)
+    // Don't speculate on arithmetic the baseline code has seen produce anything but
+    // int32s, unless it has only seen numbers, which are then computed as doubles.
+    if (ValueProfile* profile = m_baselineCodeBlock->valueProfileForBytecodeOffset(m_bytecodeIndex)) {
+        if (!profile->hasOnlyInt32Samples()) {
+            if ((opcodeID == op_add || opcodeID == op_sub || opcodeID == op_mul || opcodeID == op_div) && profile->hasOnlyNumberSamples())
+                return emitSpeculativeDoubleArith(opcodeID, currentInstruction);
+            return false;
+        }
+    }
+#endif
+
+    switch (opcodeID) {
+    case op_div:
+        return emitSpeculativeDoubleArith(opcodeID, currentInstruction);
+    case op_add:
+    case op_sub:
+    case op_mul:
+    case op_bitand:
+    case op_bitor:
+    case op_bitxor:
+        return emitSpeculativeBinaryOp(opcodeID, currentInstruction);
+    case op_lshift:
+    case op_rshift:
+    case op_urshift:
+        return emitSpeculativeShift(opcodeID, currentInstruction);
+    case op_pre_inc:
+    case op_pre_dec:
+    case op_post_inc:
+    case op_post_dec:
+        return emitSpeculativeIncOrDec(opcodeID, currentInstruction);
+    case op_jless:
+    case op_jnless:
+    case op_jlesseq:
+    case op_jnlesseq:
+    case op_loop_if_less:
+    case op_loop_if_lesseq:
+        return emitSpeculativeCompareAndJump(opcodeID, currentInstruction);
+    default:
+        return false;
+    }
+}
+
+bool JIT::canSpeculateInt32(int virtualRegister)
+{
+    JSValue constant;
+    if (getSpeculativeConstant(virtualRegister, constant))
+        return constant.isInt32();
+    return true;
+}
+
+bool JIT::emitSpeculative_op_mov(Instruction* currentInstruction)
+{
+    int dst = currentInstruction[1].u.operand;
+    int src = currentInstruction[2].u.operand;
+
+    beginSpeculativeInstruction();
+
+    JSValue constant;
+    if (getSpeculativeConstant(src, constant)) {
+        setSpeculativeConstantResult(dst, constant);
+        return true;
+    }
+
+    SpeculativeValue* srcValue = findSpeculativeValue(src);
+    SpeculativeValue* dstValue = findSpeculativeValue(dst);
+    if (srcValue && srcValue->isDouble && !(dstValue && dstValue->isPinned)) {
+        FPRegisterID value = speculativeGetDouble(src);
+        FPRegisterID result = allocateSpeculativeFPRegister();
+        moveDouble(value, result);
+        setSpeculativeDoubleResult(dst, result);
+        return true;
+    }
+
+    RegisterID value = speculativeGet(src);
+    bool isInt32 = findSpeculativeValue(src)->isInt32;
+    RegisterID result = allocateSpeculativeRegister();
+    move(value, result);
+    setSpeculativeResult(dst, result, isInt32);
+    return true;
+}
+
+// Arithmetic the baseline code has seen produce doubles. Its result stays unboxed
+// for the instructions after it, and is only boxed once it has to go to memory.
+bool JIT::emitSpeculativeDoubleArith(OpcodeID opcodeID, Instruction* currentInstruction)
+{
+    int dst = currentInstruction[1].u.operand;
+    int op1 = currentInstruction[2].u.operand;
+    int op2 = currentInstruction[3].u.operand;
+    OperandTypes types = OperandTypes::fromInt(currentInstruction[4].u.operand);
+
+    if (!types.first().mightBeNumber() || !types.second().mightBeNumber())
+        return false;
+    JSValue constant;
+    if ((getSpeculativeConstant(op1, constant) && !constant.isNumber()) || (getSpeculativeConstant(op2, constant) && !constant.isNumber()))
+        return false;
+
+    beginSpeculativeInstruction();
+
+    FPRegisterID left = speculativeGetDouble(op1);
+    FPRegisterID right = speculativeGetDouble(op2);
+    FPRegisterID result = allocateSpeculativeFPRegister();
+    moveDouble(left, result);
+    switch (opcodeID) {
+    case op_add:
+        addDouble(right, result);
+        break;
+    case op_sub:
+        subDouble(right, result);
+        break;
+    case op_mul:
+        mulDouble(right, result);
+        break;
+    case op_div:
+        divDouble(right, result);
+        break;
+    default:
+        ASSERT_NOT_REACHED();
+    }
+    setSpeculativeDoubleResult(dst, result);
+    return true;
+}
+
+bool JIT::emitSpeculative_op_jmp(Instruction* currentInstruction)
+{
+    unsigned target = currentInstruction[1].u.operand;
+
+    beginSpeculativeInstruction();
+    flushSpeculativeValues();
+    addSpeculativeJump(jump(), target);
+    m_labels[m_bytecodeIndex + target].used();
+    return true;
+}
+
+static bool foldSpeculativeBinaryOp(OpcodeID opcodeID, int32_t left, int32_t right, int32_t& result)
+{
+    int64_t wideResult;
+    switch (opcodeID) {
+    case op_add:
+        wideResult = static_cast<int64_t>(left) + right;
+        break;
+    case op_sub:
+        wideResult = static_cast<int64_t>(left) - right;
+        break;
+    case op_mul:
+        wideResult = static_cast<int64_t>(left) * right;
+        // -0 is not an int32.
+        if (!wideResult && (left < 0 || right < 0))
+            return false;
+        break;
+    case op_bitand:
+        wideResult = left & right;
+        break;
+    case op_bitor:
+        wideResult = left | right;
+        break;
+    case op_bitxor:
+        wideResult = left ^ right;
+        break;
+    default:
+        ASSERT_NOT_REACHED();
+        return false;
+    }
+    if (wideResult != static_cast<int32_t>(wideResult))
+        return false;
+    result = static_cast<int32_t>(wideResult);
+    return true;
+}
+
+bool JIT::emitSpeculativeBinaryOp(OpcodeID opcodeID, Instruction* currentInstruction)
+{
+    int dst = currentInstruction[1].u.operand;
+    int op1 = currentInstruction[2].u.operand;
+    int op2 = currentInstruction[3].u.operand;
+    OperandTypes types = OperandTypes::fromInt(currentInstruction[4].u.operand);
+
+    if (!types.first().mightBeNumber() || !types.second().mightBeNumber())
+        return false;
+    if (!canSpeculateInt32(op1) || !canSpeculateInt32(op2))
+        return false;
+
+    int32_t constant1 = 0;
+    int32_t constant2 = 0;
+    bool op1IsConstant = getSpeculativeConstantInt32(op1, constant1);
+    bool op2IsConstant = getSpeculativeConstantInt32(op2, constant2);
+    if (op1IsConstant && op2IsConstant) {
+        int32_t result;
+        if (foldSpeculativeBinaryOp(opcodeID, constant1, constant2, result)) {
+            beginSpeculativeInstruction();
+            setSpeculativeConstantResult(dst, jsNumber(m_globalData, result));
+            return true;
+        }
+        // Compute what does not fold in registers, and let the checks bail out;
+        // only two literals are left to the template.
+        if (m_codeBlock->isConstantRegisterIndex(op1) && m_codeBlock->isConstantRegisterIndex(op2))
+            return false;
+        if (m_codeBlock->isConstantRegisterIndex(op1))
+            op2IsConstant = false;
+        else
+            op1IsConstant = false;
+    }
+
+    // Only subtraction cares which side a constant is on.
+    if (op1IsConstant && opcodeID != op_sub) {
+        std::swap(op1, op2);
+        std::swap(constant1, constant2);
+        std::swap(op1IsConstant, op2IsConstant);
+    }
+
+    beginSpeculativeInstruction();
+
+    RegisterID left = regT0;
+    RegisterID right = regT0;
+    if (!op1IsConstant) {
+        left = speculativeGet(op1);
+        speculateInt32(op1);
+    }
+    if (!op2IsConstant) {
+        right = speculativeGet(op2);
+        speculateInt32(op2);
+    }
+    RegisterID result = allocateSpeculativeRegister();
+    RegisterID scratch = (opcodeID == op_mul && !op2IsConstant) ? allocateSpeculativeRegister() : result;
+
+    if (op1IsConstant)
+        move(Imm32(constant1), result);
+    else if (opcodeID != op_mul || !op2IsConstant)
+        move(left, result);
+
+    switch (opcodeID) {
+    case op_add:
+        addSpeculationExit(op2IsConstant ? branchAdd32(Overflow, Imm32(constant2), result) : branchAdd32(Overflow, right, result));
+        break;
+    case op_sub:
+        addSpeculationExit(op2IsConstant ? branchSub32(Overflow, Imm32(constant2), result) : branchSub32(Overflow, right, result));
+        break;
+    case op_mul:
+        // A zero product is -0 if either factor was negative.
+        if (op2IsConstant) {
+            addSpeculationExit(branchMul32(Overflow, Imm32(constant2), left, result));
+            if (constant2 < 0)
+                addSpeculationExit(branchTest32(Zero, result));
+            else if (!constant2)
+                addSpeculationExit(branch32(LessThan, left, Imm32(0)));
+        } else {
+            addSpeculationExit(branchMul32(Overflow, right, result));
+            Jump nonZero = branchTest32(NonZero, result);
+            move(left, scratch);
+            or32(right, scratch);
+            addSpeculationExit(branch32(LessThan, scratch, Imm32(0)));
+            nonZero.link(this);
+        }
+        break;
+    case op_bitand:
+        if (op2IsConstant)
+            and32(Imm32(constant2), result);
+        else
+            and32(right, result);
+        break;
+    case op_bitor:
+        if (op2IsConstant)
+            or32(Imm32(constant2), result);
+        else
+            or32(right, result);
+        break;
+    case op_bitxor:
+        if (op2IsConstant)
+            xor32(Imm32(constant2), result);
+        else
+            xor32(right, result);
+        break;
+    default:
+        ASSERT_NOT_REACHED();
+    }
+
+    orPtr(tagTypeNumberRegister, result);
+    setSpeculativeResult(dst, result, true);
+    return true;
+}
+
+bool JIT::emitSpeculativeShift(OpcodeID opcodeID, Instruction* currentInstruction)
+{
+    int dst = currentInstruction[1].u.operand;
+    int op1 = currentInstruction[2].u.operand;
+    int op2 = currentInstruction[3].u.operand;
+
+    int32_t shift;
+    if (!getSpeculativeConstantInt32(op2, shift) || !canSpeculateInt32(op1))
+        return false;
+    shift &= 0x1f;
+
+    int32_t constant;
+    if (getSpeculativeConstantInt32(op1, constant)) {
+        beginSpeculativeInstruction();
+        if (opcodeID == op_lshift)
+            setSpeculativeConstantResult(dst, jsNumber(m_globalData, constant << shift));
+        else if (opcodeID == op_rshift)
+            setSpeculativeConstantResult(dst, jsNumber(m_globalData, constant >> shift));
+        else
+            setSpeculativeConstantResult(dst, jsNumber(m_globalData, static_cast<uint32_t>(constant) >> shift));
+        return true;
+    }
+
+    beginSpeculativeInstruction();
+
+    RegisterID value = speculativeGet(op1);
+    speculateInt32(op1);
+    RegisterID result = allocateSpeculativeRegister();
+    move(value, result);
+    if (opcodeID == op_lshift)
+        lshift32(Imm32(shift), result);
+    else if (opcodeID == op_rshift)
+        rshift32(Imm32(shift), result);
+    else {
+        urshift32(Imm32(shift), result);
+        // Only a shift by zero can leave a result that does not fit in an int32.
+        if (!shift)
+            addSpeculationExit(branch32(LessThan, result, Imm32(0)));
+    }
+    orPtr(tagTypeNumberRegister, result);
+    setSpeculativeResult(dst, result, true);
+    return true;
+}
+
+bool JIT::emitSpeculativeIncOrDec(OpcodeID opcodeID, Instruction* currentInstruction)
+{
+    bool isPostfix = opcodeID == op_post_inc || opcodeID == op_post_dec;
+    bool isIncrement = opcodeID == op_pre_inc || opcodeID == op_post_inc;
+    int srcDst = currentInstruction[isPostfix ? 2 : 1].u.operand;
+    int dst = isPostfix ? currentInstruction[1].u.operand : srcDst;
+
+    if ((isPostfix && dst == srcDst) || !canSpeculateInt32(srcDst))
+        return false;
+
+    // A constant that would overflow is computed in registers, and bails out.
+    int32_t constant;
+    if (getSpeculativeConstantInt32(srcDst, constant) && constant != (isIncrement ? std::numeric_limits<int32_t>::max() : std::numeric_limits<int32_t>::min())) {
+        beginSpeculativeInstruction();
+        if (isPostfix)
+            setSpeculativeConstantResult(dst, jsNumber(m_globalData, constant));
+        setSpeculativeConstantResult(srcDst, jsNumber(m_globalData, isIncrement ? constant + 1 : constant - 1));
+        return true;
+    }
+
+    beginSpeculativeInstruction();
+
+    RegisterID value = speculativeGet(srcDst);
+    speculateInt32(srcDst);
+    RegisterID result = allocateSpeculativeRegister();
+    RegisterID oldValue = isPostfix ? allocateSpeculativeRegister() : result;
+    move(value, result);
+    addSpeculationExit(isIncrement ? branchAdd32(Overflow, Imm32(1), result) : branchSub32(Overflow, Imm32(1), result));
+    orPtr(tagTypeNumberRegister, result);
+    if (isPostfix) {
+        move(value, oldValue);
+        setSpeculativeResult(dst, oldValue, true);
+    }
+    setSpeculativeResult(srcDst, result, true);
+    return true;
+}
+
+static MacroAssembler::Condition commute(MacroAssembler::Condition condition)
+{
+    switch (condition) {
+    case MacroAssembler::LessThan:
+        return MacroAssembler::GreaterThan;
+    case MacroAssembler::LessThanOrEqual:
+        return MacroAssembler::GreaterThanOrEqual;
+    case MacroAssembler::GreaterThan:
+        return MacroAssembler::LessThan;
+    case MacroAssembler::GreaterThanOrEqual:
+        return MacroAssembler::LessThanOrEqual;
+    default:
+        ASSERT_NOT_REACHED();
+        return condition;
+    }
+}
+
+bool JIT::emitSpeculativeCompareAndJump(OpcodeID opcodeID, Instruction* currentInstruction)
+{
+    int op1 = currentInstruction[1].u.operand;
+    int op2 = currentInstruction[2].u.operand;
+    unsigned target = currentInstruction[3].u.operand;
+
+    if (!canSpeculateInt32(op1) || !canSpeculateInt32(op2))
+        return false;
+    int32_t constant1 = 0;
+    int32_t constant2 = 0;
+    bool op1IsConstant = getSpeculativeConstantInt32(op1, constant1);
+    bool op2IsConstant = getSpeculativeConstantInt32(op2, constant2);
+    if (op1IsConstant && op2IsConstant) {
+        // Only two literals are left to the template; a known constant is compared in a register.
+        if (m_codeBlock->isConstantRegisterIndex(op1) && m_codeBlock->isConstantRegisterIndex(op2))
+            return false;
+        if (m_codeBlock->isConstantRegisterIndex(op1))
+            op2IsConstant = false;
+        else
+            op1IsConstant = false;
+    }
+
+    Condition condition;
+    bool isLoop = false;
+    switch (opcodeID) {
+    case op_loop_if_less:
+        isLoop = true;
+    case op_jless:
+        condition = LessThan;
+        break;
+    case op_loop_if_lesseq:
+        isLoop = true;
+    case op_jlesseq:
+        condition = LessThanOrEqual;
+        break;
+    case op_jnless:
+        condition = GreaterThanOrEqual;
+        break;
+    case op_jnlesseq:
+        condition = GreaterThan;
+        break;
+    default:
+        ASSERT_NOT_REACHED();
+        return false;
+    }
+
+    beginSpeculativeInstruction();
+
+    // The branch target expects every value in the register file, but for those
+    // a register loop pins. A backward branch also checks for timeout, which
+    // clobbers the registers.
+    if (isLoop) {
+        flushSpeculativeValues();
+        forgetSpeculativeValues();
+        if (m_currentRegisterLoop)
+            emitRegisterLoopTimeoutCheck();
+        else
+            emitTimeoutCheck();
+    }
+
+    RegisterID left = regT0;
+    RegisterID right = regT0;
+    if (!op1IsConstant) {
+        left = speculativeGet(op1);
+        speculateInt32(op1);
+    }
+    if (!op2IsConstant) {
+        right = speculativeGet(op2);
+        speculateInt32(op2);
+    }
+    if (!isLoop)
+        flushSpeculativeValues();
+
+    if (op2IsConstant)
+        addSpeculativeJump(branch32(condition, left, Imm32(constant2)), target);
+    else if (op1IsConstant)
+        addSpeculativeJump(branch32(commute(condition), right, Imm32(constant1)), target);
+    else
+        addSpeculativeJump(branch32(condition, left, right), target);
+    return true;
+}
+
+/* ------------------------------ END: Optimizing tier ------------------------------ */
+
+#endif // ENABLE(JIT_OPTIMIZING_TIER)
+
 #endif // !USE(JSVALUE32_64)
 
 } // namespace JSC
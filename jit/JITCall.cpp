@@ -29,6 +29,7 @@
 #if ENABLE(JIT)
 
 #include "CodeBlock.h"
+#include "Executable.h"
 #include "JITInlineMethods.h"
 #include "JITStubCall.h"
 #include "JSArray.h"
@@ -696,6 +697,10 @@ void JIT::compileOpCallSlowCase(Instruction* instruction, Vector<SlowCaseEntry>:
     // Put the return value in dst.
     emitPutVirtualRegister(dst);
     sampleCodeBlock(m_codeBlock);
+#if ENABLE(VALUE_PROFILER)
+    if (ValueProfile* valueProfile = valueProfileFor(opcodeID, instruction))
+        emitValueProfilingSite(valueProfile);
+#endif
 
     // If not, we need an extra case in the if below!
     ASSERT(OPCODE_LENGTH(op_call) == OPCODE_LENGTH(op_call_eval));
@@ -715,6 +720,104 @@ void JIT::compileOpCallSlowCase(Instruction* instruction, Vector<SlowCaseEntry>:
     sampleCodeBlock(m_codeBlock);
 }
 
+#if ENABLE(JIT_OPTIMIZING_TIER)
+
+// The optimizing tier inlines a call that the baseline code has linked to a
+// function, when that function is one of a few tiny shapes that touch neither
+// its scope chain nor its call frame:
+//
+//     function() { return this.property; }
+//     function(a, b) { return b; }
+//     function() { return 42; }
+//
+// Closures share their function's bytecode, so the inlined body is guarded on
+// the callee's executable rather than on the callee itself. When a guard fails,
+// the call falls through to the normal call sequence, which the caller plants
+// next; the inlined body jumps over it through inlinedCallDone.
+bool JIT::compileInlinedCall(Instruction* instruction, unsigned callLinkInfoIndex, Jump& inlinedCallDone)
+{
+    int dst = instruction[1].u.operand;
+    int callee = instruction[2].u.operand;
+    int argCount = instruction[3].u.operand;
+    int registerOffset = instruction[4].u.operand;
+
+    CallLinkInfo& callLinkInfo = m_baselineCodeBlock->callLinkInfo(callLinkInfoIndex);
+    if (!callLinkInfo.isLinked() || callLinkInfo.callee->codeType() != FunctionCode)
+        return false;
+    FunctionExecutable* executable = static_cast<FunctionExecutable*>(callLinkInfo.callee->ownerExecutable());
+    CodeBlock* calleeCodeBlock = &executable->generatedBytecode();
+    if (calleeCodeBlock->m_numParameters != argCount || calleeCodeBlock->needsFullScopeChain() || calleeCodeBlock->usesArguments() || calleeCodeBlock->numberOfExceptionHandlers())
+        return false;
+
+    // The bytecode is gone if the callee skipped warming up in the interpreter.
+    // Nothing after the first op_ret is reachable.
+    Instruction* vPC = calleeCodeBlock->instructions().begin();
+    Instruction* end = calleeCodeBlock->instructions().end();
+    if (vPC == end || m_interpreter->getOpcodeID(vPC->u.opcode) != op_enter)
+        return false;
+    vPC += OPCODE_LENGTH(op_enter);
+    if (vPC != end && m_interpreter->getOpcodeID(vPC->u.opcode) == op_convert_this)
+        vPC += OPCODE_LENGTH(op_convert_this);
+    Instruction* getByIdInstruction = 0;
+    if (vPC != end && m_interpreter->getOpcodeID(vPC->u.opcode) == op_get_by_id) {
+        getByIdInstruction = vPC;
+        vPC += OPCODE_LENGTH(op_get_by_id);
+    }
+    if (vPC == end || m_interpreter->getOpcodeID(vPC->u.opcode) != op_ret)
+        return false;
+    int result = vPC[1].u.operand;
+    int thisRegister = calleeCodeBlock->thisRegister();
+
+    Structure* structure = 0;
+    size_t cachedOffset = 0;
+    if (getByIdInstruction) {
+        // Take the structure the callee's own baseline code has seen.
+        if (getByIdInstruction[1].u.operand != result || getByIdInstruction[2].u.operand != thisRegister || !calleeCodeBlock->numberOfStructureStubInfos())
+            return false;
+        StructureStubInfo& stubInfo = calleeCodeBlock->structureStubInfo(0);
+        if (stubInfo.accessType != access_get_by_id_self)
+            return false;
+        structure = stubInfo.u.getByIdSelf.baseObjectStructure;
+        if (structure->isDictionary() || structure->typeInfo().needsThisConversion())
+            return false;
+        cachedOffset = structure->get(calleeCodeBlock->identifier(getByIdInstruction[3].u.operand));
+        if (cachedOffset == notFound)
+            return false;
+    } else if (calleeCodeBlock->isConstantRegisterIndex(result)) {
+        if (calleeCodeBlock->getConstant(result).isCell())
+            return false;
+    } else if (result <= thisRegister || result >= -RegisterFile::CallFrameHeaderSize)
+        return false;
+
+    m_codeBlock->addInlinedExecutable(executable);
+
+    JumpList notInlined;
+    emitGetVirtualRegister(callee, regT0);
+    notInlined.append(emitJumpIfNotJSCell(regT0));
+    notInlined.append(branchPtr(NotEqual, Address(regT0), ImmPtr(m_globalData->jsFunctionVPtr)));
+    notInlined.append(branchPtr(NotEqual, Address(regT0, OBJECT_OFFSETOF(JSFunction, m_executable)), ImmPtr(executable)));
+
+    // The callee's registers are the caller's, registerOffset further on.
+    if (structure) {
+        m_codeBlock->addInlinedStructure(structure);
+        emitGetVirtualRegister(registerOffset + thisRegister, regT0);
+        notInlined.append(emitJumpIfNotJSCell(regT0));
+        notInlined.append(branchPtr(NotEqual, Address(regT0, OBJECT_OFFSETOF(JSCell, m_structure)), ImmPtr(structure)));
+        compileGetDirectOffset(regT0, regT0, structure, cachedOffset);
+    } else if (calleeCodeBlock->isConstantRegisterIndex(result))
+        move(ImmPtr(JSValue::encode(calleeCodeBlock->getConstant(result))), regT0);
+    else
+        emitGetVirtualRegister(registerOffset + result, regT0);
+    emitPutVirtualRegister(dst);
+    inlinedCallDone = jump();
+
+    notInlined.link(this);
+    killLastResultRegister();
+    return true;
+}
+
+#endif // ENABLE(JIT_OPTIMIZING_TIER)
+
 /* ------------------------------ END: !ENABLE / ENABLE(JIT_OPTIMIZE_CALL) ------------------------------ */
 
 #endif // !ENABLE(JIT_OPTIMIZE_CALL)
@@ -272,6 +272,44 @@ ALWAYS_INLINE void JIT::emitJumpSlowToHot(Jump jump, int relativeOffset)
     jump.linkTo(m_labels[m_bytecodeIndex + relativeOffset], this);
 }
 
+// Equivalent to Heap::writeBarrier(owner); clobbers both scratch registers.
+ALWAYS_INLINE void JIT::emitWriteBarrier(RegisterID owner, RegisterID scratch1, RegisterID scratch2)
+{
+    // Load the word of the young bitmap holding the owner's bit, and skip the
+    // barrier if the bit is set.
+    move(owner, scratch1);
+    andPtr(Imm32(BLOCK_OFFSET_MASK), scratch1);
+    rshift32(Imm32(ATOM_SHIFT + 5), scratch1);
+    lshift32(Imm32(2), scratch1);
+    move(owner, scratch2);
+    andPtr(Imm32(static_cast<int32_t>(BLOCK_MASK)), scratch2);
+    addPtr(scratch1, scratch2);
+    load32(Address(scratch2, OBJECT_OFFSETOF(CollectorBlock, young)), scratch2);
+    move(owner, scratch1);
+    rshift32(Imm32(ATOM_SHIFT), scratch1);
+    and32(Imm32(0x1F), scratch1);
+    rshift32(scratch1, scratch2);
+    Jump ownerIsYoung = branchTest32(NonZero, scratch2, Imm32(1));
+
+    move(owner, scratch1);
+    andPtr(Imm32(BLOCK_OFFSET_MASK), scratch1);
+    rshift32(Imm32(CARD_SHIFT), scratch1);
+    lshift32(Imm32(2), scratch1);
+    move(owner, scratch2);
+    andPtr(Imm32(static_cast<int32_t>(BLOCK_MASK)), scratch2);
+    addPtr(scratch1, scratch2);
+    store32(Imm32(1), Address(scratch2, OBJECT_OFFSETOF(CollectorBlock, cards)));
+
+    ownerIsYoung.link(this);
+}
+
+ALWAYS_INLINE void JIT::emitWriteBarrier(JSCell* owner)
+{
+    // Only used for long-lived owners such as global objects, so the young
+    // check is not worth emitting.
+    store32(Imm32(1), Heap::addressOfCard(owner));
+}
+
 #if ENABLE(SAMPLING_FLAGS)
 ALWAYS_INLINE void JIT::setSamplingFlag(int32_t flag)
 {
@@ -147,6 +147,10 @@ void JIT::privateCompileCTIMachineTrampolines(RefPtr<ExecutablePool>* executable
     preserveReturnAddressAfterCall(regT0);
     emitPutToCallFrameHeader(regT0, RegisterFile::ReturnPC); // Push return address
 
+    // The host function may allocate, so the collector must see this frame as
+    // the running one (its caller stopped at a known call site).
+    storePtr(callFrameRegister, &globalData->interpreter->registerFile().m_topCallFrame);
+
     // Load caller frame's scope chain into this callframe so that whatever we call can
     // get to its global data.
     emitGetFromCallFrameHeaderPtr(RegisterFile::CallerFrame, regT1);
@@ -586,7 +590,15 @@ void JIT::emit_op_new_func(Instruction* currentInstruction)
 
 void JIT::emit_op_call(Instruction* currentInstruction)
 {
+#if ENABLE(JIT_OPTIMIZING_TIER)
+    Jump inlinedCallDone;
+    bool isInlined = isOptimizing() && compileInlinedCall(currentInstruction, m_callLinkInfoIndex, inlinedCallDone);
+#endif
     compileOpCall(op_call, currentInstruction, m_callLinkInfoIndex++);
+#if ENABLE(JIT_OPTIMIZING_TIER)
+    if (isInlined)
+        inlinedCallDone.link(this);
+#endif
 }
 
 void JIT::emit_op_call_eval(Instruction* currentInstruction)
@@ -629,6 +641,7 @@ void JIT::emit_op_put_global_var(Instruction* currentInstruction)
     emitGetVirtualRegister(currentInstruction[3].u.operand, regT1);
     JSVariableObject* globalObject = static_cast<JSVariableObject*>(currentInstruction[1].u.jsCell);
     move(ImmPtr(globalObject), regT0);
+    emitWriteBarrier(globalObject);
     emitPutVariableObjectRegister(regT1, regT0, currentInstruction[2].u.operand);
 }
 
@@ -655,6 +668,7 @@ void JIT::emit_op_put_scoped_var(Instruction* currentInstruction)
         loadPtr(Address(regT1, OBJECT_OFFSETOF(ScopeChainNode, next)), regT1);
 
     loadPtr(Address(regT1, OBJECT_OFFSETOF(ScopeChainNode, object)), regT1);
+    emitWriteBarrier(regT1, regT2, regT3);
     emitPutVariableObjectRegister(regT0, regT1, currentInstruction[1].u.operand);
 }
 
@@ -1316,6 +1330,12 @@ void JIT::emit_op_enter(Instruction*)
     for (size_t j = 0; j < count; ++j)
         emitInitRegister(j);
 
+#if ENABLE(JIT_OPTIMIZING_TIER)
+    if (isOptimizing())
+        emitSpeculationFailureCheck();
+    else if (emitsOptimizationCounter())
+        emitOptimizationCheck();
+#endif
 }
 
 void JIT::emit_op_enter_with_activation(Instruction* currentInstruction)
@@ -1328,6 +1348,13 @@ void JIT::emit_op_enter_with_activation(Instruction* currentInstruction)
         emitInitRegister(j);
 
     JITStubCall(this, cti_op_push_activation).call(currentInstruction[1].u.operand);
+
+#if ENABLE(JIT_OPTIMIZING_TIER)
+    if (isOptimizing())
+        emitSpeculationFailureCheck();
+    else if (emitsOptimizationCounter())
+        emitOptimizationCheck();
+#endif
 }
 
 void JIT::emit_op_create_arguments(Instruction*)
@@ -1439,6 +1466,11 @@ void JIT::emitSlow_op_put_by_val(Instruction* currentInstruction, Vector<SlowCas
     linkSlowCaseIfNotJSCell(iter, base); // base cell check
     linkSlowCase(iter); // base not array check
     linkSlowCase(iter); // in vector check
+    linkSlowCase(iter); // int32 array value check
+#if USE(JSVALUE64)
+    linkSlowCase(iter); // double array value check
+    linkSlowCase(iter); // double array hole value
+#endif
 
     JITStubCall stubPutByValCall(this, cti_op_put_by_val);
     stubPutByValCall.addArgument(regT0);
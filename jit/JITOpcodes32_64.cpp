@@ -145,6 +145,10 @@ void JIT::privateCompileCTIMachineTrampolines(RefPtr<ExecutablePool>* executable
     preserveReturnAddressAfterCall(regT0);
     emitPutToCallFrameHeader(regT0, RegisterFile::ReturnPC); // Push return address
 
+    // The host function may allocate, so the collector must see this frame as
+    // the running one (its caller stopped at a known call site).
+    storePtr(callFrameRegister, &globalData->interpreter->registerFile().m_topCallFrame);
+
     // Load caller frame's scope chain into this callframe so that whatever we call can
     // get to its global data.
     emitGetFromCallFrameHeaderPtr(RegisterFile::CallerFrame, regT1);
@@ -589,6 +593,7 @@ void JIT::emit_op_put_global_var(Instruction* currentInstruction)
 
     emitLoad(value, regT1, regT0);
 
+    emitWriteBarrier(globalObject);
     loadPtr(&globalObject->d()->registers, regT2);
     emitStore(index, regT1, regT0, regT2);
     map(m_bytecodeIndex + OPCODE_LENGTH(op_put_global_var), value, regT1, regT0);
@@ -619,13 +624,13 @@ void JIT::emit_op_put_scoped_var(Instruction* currentInstruction)
     int skip = currentInstruction[2].u.operand + m_codeBlock->needsFullScopeChain();
     int value = currentInstruction[3].u.operand;
 
-    emitLoad(value, regT1, regT0);
-
     emitGetFromCallFrameHeaderPtr(RegisterFile::ScopeChain, regT2);
     while (skip--)
         loadPtr(Address(regT2, OBJECT_OFFSETOF(ScopeChainNode, next)), regT2);
 
     loadPtr(Address(regT2, OBJECT_OFFSETOF(ScopeChainNode, object)), regT2);
+    emitWriteBarrier(regT2, regT0, regT1);
+    emitLoad(value, regT1, regT0);
     loadPtr(Address(regT2, OBJECT_OFFSETOF(JSVariableObject, d)), regT2);
     loadPtr(Address(regT2, OBJECT_OFFSETOF(JSVariableObject::JSVariableObjectData, registers)), regT2);
 
@@ -113,9 +113,26 @@ void JIT::emit_op_get_by_val(Instruction* currentInstruction)
     loadPtr(Address(regT0, OBJECT_OFFSETOF(JSArray, m_storage)), regT2);
     addSlowCase(branch32(AboveOrEqual, regT1, Address(regT0, OBJECT_OFFSETOF(JSArray, m_vectorLength))));
 
+#if USE(JSVALUE64)
+    loadPtr(Address(regT0, OBJECT_OFFSETOF(JSCell, m_structure)), regT3);
+    Jump isDoubleArray = branch8(Equal, Address(regT3, OBJECT_OFFSETOF(Structure, m_arrayElementKind)), Imm32(DoubleArrayElements));
+#endif
+
     loadPtr(BaseIndex(regT2, regT1, ScalePtr, OBJECT_OFFSETOF(ArrayStorage, m_vector[0])), regT0);
     addSlowCase(branchTestPtr(Zero, regT0));
 
+#if USE(JSVALUE64)
+    Jump done = jump();
+
+    // Box the unboxed double.
+    isDoubleArray.link(this);
+    loadPtr(BaseIndex(regT2, regT1, ScalePtr, OBJECT_OFFSETOF(ArrayStorage, m_vector[0])), regT0);
+    addSlowCase(branchPtr(Equal, regT0, ImmPtr(reinterpret_cast<void*>(arrayDoubleHoleBits))));
+    subPtr(tagTypeNumberRegister, regT0);
+
+    done.link(this);
+#endif
+
     emitPutVirtualRegister(dst);
 }
 
@@ -140,6 +157,9 @@ void JIT::emitSlow_op_get_by_val(Instruction* currentInstruction, Vector<SlowCas
     
     linkSlowCase(iter); // vector length check
     linkSlowCase(iter); // empty value
+#if USE(JSVALUE64)
+    linkSlowCase(iter); // double hole
+#endif
     
     JITStubCall stubCall(this, cti_op_get_by_val);
     stubCall.addArgument(base, regT2);
@@ -150,9 +170,10 @@ void JIT::emitSlow_op_get_by_val(Instruction* currentInstruction, Vector<SlowCas
 void JIT::compileGetDirectOffset(RegisterID base, RegisterID result, RegisterID structure, RegisterID offset, RegisterID scratch)
 {
     ASSERT(sizeof(((Structure*)0)->m_propertyStorageCapacity) == sizeof(int32_t));
-    ASSERT(sizeof(JSObject::inlineStorageCapacity) == sizeof(int32_t));
+    ASSERT(sizeof(((Structure*)0)->m_inlineStorageCapacity) == sizeof(int32_t));
 
-    Jump notUsingInlineStorage = branch32(NotEqual, Address(structure, OBJECT_OFFSETOF(Structure, m_propertyStorageCapacity)), Imm32(JSObject::inlineStorageCapacity));
+    load32(Address(structure, OBJECT_OFFSETOF(Structure, m_inlineStorageCapacity)), scratch);
+    Jump notUsingInlineStorage = branch32(NotEqual, Address(structure, OBJECT_OFFSETOF(Structure, m_propertyStorageCapacity)), scratch);
     loadPtr(BaseIndex(base, offset, ScalePtr, OBJECT_OFFSETOF(JSObject, m_inlineStorage)), result);
     Jump finishedLoad = jump();
     notUsingInlineStorage.link(this);
@@ -221,16 +242,56 @@ void JIT::emit_op_put_by_val(Instruction* currentInstruction)
     addSlowCase(branchPtr(NotEqual, Address(regT0), ImmPtr(m_globalData->jsArrayVPtr)));
     addSlowCase(branch32(AboveOrEqual, regT1, Address(regT0, OBJECT_OFFSETOF(JSArray, m_vectorLength))));
 
-    loadPtr(Address(regT0, OBJECT_OFFSETOF(JSArray, m_storage)), regT2);
+    // Values that do not fit the array's element kind are stored by the stub,
+    // which converts the array to a kind they do fit.
+    loadPtr(Address(regT0, OBJECT_OFFSETOF(JSCell, m_structure)), regT2);
+#if USE(JSVALUE64)
+    Jump isDoubleArray = branch8(Equal, Address(regT2, OBJECT_OFFSETOF(Structure, m_arrayElementKind)), Imm32(DoubleArrayElements));
+#endif
+    Jump isInt32Array = branch8(Equal, Address(regT2, OBJECT_OFFSETOF(Structure, m_arrayElementKind)), Imm32(Int32ArrayElements));
+
+    emitWriteBarrier(regT0, regT2, regT3);
+    emitGetVirtualRegister(value, regT3);
+    Jump isValue = jump();
 
+    // Numbers are never cells, so they need no write barrier.
+    isInt32Array.link(this);
+    emitGetVirtualRegister(value, regT3);
+    addSlowCase(emitJumpIfNotImmediateInteger(regT3));
+
+    isValue.link(this);
+    loadPtr(Address(regT0, OBJECT_OFFSETOF(JSArray, m_storage)), regT2);
     Jump empty = branchTestPtr(Zero, BaseIndex(regT2, regT1, ScalePtr, OBJECT_OFFSETOF(ArrayStorage, m_vector[0])));
+#if USE(JSVALUE64)
+    Jump notEmpty = jump();
+
+    isDoubleArray.link(this);
+    emitGetVirtualRegister(value, regT3);
+    Jump isInt32 = emitJumpIfImmediateInteger(regT3);
+    addSlowCase(emitJumpIfNotImmediateNumber(regT3));
+    addPtr(tagTypeNumberRegister, regT3);
+    addSlowCase(branchPtr(Equal, regT3, ImmPtr(reinterpret_cast<void*>(arrayDoubleHoleBits))));
+    Jump isDouble = jump();
+    isInt32.link(this);
+    convertInt32ToDouble(regT3, fpRegT0);
+    moveDoubleToPtr(fpRegT0, regT3);
+    isDouble.link(this);
+
+    loadPtr(Address(regT0, OBJECT_OFFSETOF(JSArray, m_storage)), regT2);
+    loadPtr(BaseIndex(regT2, regT1, ScalePtr, OBJECT_OFFSETOF(ArrayStorage, m_vector[0])), regT0);
+    Jump emptyDouble = branchPtr(Equal, regT0, ImmPtr(reinterpret_cast<void*>(arrayDoubleHoleBits)));
+
+    notEmpty.link(this);
+#endif
 
     Label storeResult(this);
-    emitGetVirtualRegister(value, regT0);
-    storePtr(regT0, BaseIndex(regT2, regT1, ScalePtr, OBJECT_OFFSETOF(ArrayStorage, m_vector[0])));
+    storePtr(regT3, BaseIndex(regT2, regT1, ScalePtr, OBJECT_OFFSETOF(ArrayStorage, m_vector[0])));
     Jump end = jump();
     
     empty.link(this);
+#if USE(JSVALUE64)
+    emptyDouble.link(this);
+#endif
     add32(Imm32(1), Address(regT2, OBJECT_OFFSETOF(ArrayStorage, m_numValuesInVector)));
     branch32(Below, regT1, Address(regT2, OBJECT_OFFSETOF(ArrayStorage, m_length))).linkTo(storeResult, this);
 
@@ -511,6 +572,10 @@ void JIT::emit_op_put_by_id(Instruction* currentInstruction)
     // Jump to a slow case if either the base object is an immediate, or if the Structure does not match.
     emitJumpSlowCaseIfNotJSCell(regT0, baseVReg);
 
+    // Marking the card before the Structure check keeps the patchable sequence unchanged; the
+    // slow case stores through the C++ barrier anyway.
+    emitWriteBarrier(regT0, regT2, regT3);
+
     BEGIN_UNINTERRUPTED_SEQUENCE(sequencePutById);
 
     Label hotPathBegin(this);
@@ -599,9 +664,12 @@ void JIT::testPrototype(Structure* structure, JumpList& failureCases)
     failureCases.append(branchPtr(NotEqual, Address(regT2), regT3));
 }
 
-void JIT::privateCompilePutByIdTransition(StructureStubInfo* stubInfo, Structure* oldStructure, Structure* newStructure, size_t cachedOffset, StructureChain* chain, ReturnAddressPtr returnAddress, bool direct)
+// Plants the body of a stub that adds a property, called from the slow case of
+// put_by_id with the base in regT0 and the value in regT1. Every check jumps to
+// failureCases before either register is touched. Returns whether the stub
+// calls out to grow the property storage.
+bool JIT::compilePutByIdTransitionStore(JumpList& failureCases, Structure* oldStructure, Structure* newStructure, size_t cachedOffset, StructureChain* chain, bool direct)
 {
-    JumpList failureCases;
     // Check eax is an object of the right Structure.
     failureCases.append(emitJumpIfNotJSCell(regT0));
     failureCases.append(branchPtr(NotEqual, Address(regT0, OBJECT_OFFSETOF(JSCell, m_structure)), ImmPtr(oldStructure)));
@@ -641,8 +709,17 @@ void JIT::privateCompilePutByIdTransition(StructureStubInfo* stubInfo, Structure
     storePtr(ImmPtr(newStructure), Address(regT0, OBJECT_OFFSETOF(JSCell, m_structure)));
 
     // write the value
+    emitWriteBarrier(regT0, regT2, regT3);
     compilePutDirectOffset(regT0, regT1, newStructure, cachedOffset);
 
+    return willNeedStorageRealloc;
+}
+
+void JIT::privateCompilePutByIdTransition(StructureStubInfo* stubInfo, Structure* oldStructure, Structure* newStructure, size_t cachedOffset, StructureChain* chain, ReturnAddressPtr returnAddress, bool direct)
+{
+    JumpList failureCases;
+    bool willNeedStorageRealloc = compilePutByIdTransitionStore(failureCases, oldStructure, newStructure, cachedOffset, chain, direct);
+
     ret();
     
     ASSERT(!failureCases.empty());
@@ -652,7 +729,8 @@ void JIT::privateCompilePutByIdTransition(StructureStubInfo* stubInfo, Structure
 
     LinkBuffer patchBuffer(this, m_codeBlock->executablePool(), 0);
 
-    patchBuffer.link(failureCall, FunctionPtr(direct ? cti_op_put_by_id_direct_fail : cti_op_put_by_id_fail));
+    // Other Structures reaching this stub get stubs of their own.
+    patchBuffer.link(failureCall, FunctionPtr(direct ? cti_op_put_by_id_direct_list : cti_op_put_by_id_list));
 
     if (willNeedStorageRealloc) {
         ASSERT(m_calls.size() == 1);
@@ -665,6 +743,60 @@ void JIT::privateCompilePutByIdTransition(StructureStubInfo* stubInfo, Structure
     repatchBuffer.relinkCallerToTrampoline(returnAddress, entryLabel);
 }
 
+// Stubs for a polymorphic put_by_id are chained the way get_by_id's are: the
+// slow case calls the newest one, and each falls through to the one before it,
+// the oldest to cti_op_put_by_id_list. newStructure is null for a replace.
+void JIT::privateCompilePutByIdList(StructureStubInfo* stubInfo, PolymorphicPutByIdList* polymorphicStructures, int currentIndex, Structure* oldStructure, Structure* newStructure, size_t cachedOffset, StructureChain* chain, ReturnAddressPtr returnAddress, bool direct)
+{
+    JumpList failureCases;
+    bool willNeedStorageRealloc = false;
+    if (newStructure)
+        willNeedStorageRealloc = compilePutByIdTransitionStore(failureCases, oldStructure, newStructure, cachedOffset, chain, direct);
+    else {
+        failureCases.append(emitJumpIfNotJSCell(regT0));
+        failureCases.append(branchPtr(NotEqual, Address(regT0, OBJECT_OFFSETOF(JSCell, m_structure)), ImmPtr(oldStructure)));
+        // The hot path has already marked the card.
+        compilePutDirectOffset(regT0, regT1, oldStructure, cachedOffset);
+    }
+
+    ret();
+
+    failureCases.link(this);
+    CodeLocationLabel lastStubBegin = polymorphicStructures->list[currentIndex - 1].stubRoutine;
+    Jump failureJump;
+    Call failureCall;
+    if (!lastStubBegin) {
+        restoreArgumentReferenceForTrampoline();
+        failureCall = tailRecursiveCall();
+    } else
+        failureJump = jump();
+
+    LinkBuffer patchBuffer(this, m_codeBlock->executablePool(), 0);
+
+    if (!lastStubBegin)
+        patchBuffer.link(failureCall, FunctionPtr(direct ? cti_op_put_by_id_direct_list : cti_op_put_by_id_list));
+    else
+        patchBuffer.link(failureJump, lastStubBegin);
+
+    if (willNeedStorageRealloc) {
+        ASSERT(m_calls.size() == 1);
+        patchBuffer.link(m_calls[0].from, FunctionPtr(cti_op_put_by_id_transition_realloc));
+    }
+
+    CodeLocationLabel entryLabel = patchBuffer.finalizeCodeAddendum();
+
+    oldStructure->ref();
+    if (newStructure) {
+        newStructure->ref();
+        chain->ref();
+        polymorphicStructures->list[currentIndex].set(entryLabel, oldStructure, newStructure, chain);
+    } else
+        polymorphicStructures->list[currentIndex].set(entryLabel, oldStructure);
+
+    RepatchBuffer repatchBuffer(m_codeBlock);
+    repatchBuffer.relinkCallerToTrampoline(returnAddress, entryLabel);
+}
+
 void JIT::patchGetByIdSelf(CodeBlock* codeBlock, StructureStubInfo* stubInfo, Structure* structure, size_t cachedOffset, ReturnAddressPtr returnAddress)
 {
     RepatchBuffer repatchBuffer(codeBlock);
@@ -709,9 +841,8 @@ void JIT::patchPutByIdReplace(CodeBlock* codeBlock, StructureStubInfo* stubInfo,
 {
     RepatchBuffer repatchBuffer(codeBlock);
 
-    // We don't want to patch more than once - in future go to cti_op_put_by_id_generic.
-    // Should probably go to cti_op_put_by_id_fail, but that doesn't do anything interesting right now.
-    repatchBuffer.relinkCallerToFunction(returnAddress, FunctionPtr(direct ? cti_op_put_by_id_direct_generic : cti_op_put_by_id_generic));
+    // We don't want to patch the hot path more than once; other Structures get stubs of their own.
+    repatchBuffer.relinkCallerToFunction(returnAddress, FunctionPtr(direct ? cti_op_put_by_id_direct_list : cti_op_put_by_id_list));
 
     int offset = sizeof(JSValue) * cachedOffset;
 
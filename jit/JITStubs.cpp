@@ -1021,13 +1021,13 @@ struct StackHack {
     ReturnAddressPtr savedReturnAddress;
 };
 
-#define STUB_INIT_STACK_FRAME(stackFrame) SETUP_VA_LISTL_ARGS; JITStackFrame& stackFrame = *reinterpret_cast<JITStackFrame*>(STUB_ARGS); StackHack stackHack(stackFrame)
+#define STUB_INIT_STACK_FRAME(stackFrame) SETUP_VA_LISTL_ARGS; JITStackFrame& stackFrame = *reinterpret_cast<JITStackFrame*>(STUB_ARGS); StackHack stackHack(stackFrame); stackFrame.registerFile->setTopCallFrame(stackFrame.callFrame)
 #define STUB_SET_RETURN_ADDRESS(returnAddress) stackHack.savedReturnAddress = ReturnAddressPtr(returnAddress)
 #define STUB_RETURN_ADDRESS stackHack.savedReturnAddress
 
 #else
 
-#define STUB_INIT_STACK_FRAME(stackFrame) SETUP_VA_LISTL_ARGS; JITStackFrame& stackFrame = *reinterpret_cast<JITStackFrame*>(STUB_ARGS)
+#define STUB_INIT_STACK_FRAME(stackFrame) SETUP_VA_LISTL_ARGS; JITStackFrame& stackFrame = *reinterpret_cast<JITStackFrame*>(STUB_ARGS); stackFrame.registerFile->setTopCallFrame(stackFrame.callFrame)
 #define STUB_SET_RETURN_ADDRESS(returnAddress) *stackFrame.returnAddressSlot() = ReturnAddressPtr(returnAddress)
 #define STUB_RETURN_ADDRESS *stackFrame.returnAddressSlot()
 
@@ -1279,6 +1279,58 @@ DEFINE_STUB_FUNCTION(int, timeout_check)
     return timeoutChecker.ticksUntilNextCheck();
 }
 
+#if ENABLE(JIT_OPTIMIZING_TIER)
+// Called from baseline code once its optimization counter overflows, either on
+// entry (bytecode index 0) or at a loop header. Returns the address to continue
+// at in the optimized code, or 0 to carry on in the baseline code.
+DEFINE_STUB_FUNCTION(void*, vm_optimize)
+{
+    STUB_INIT_STACK_FRAME(stackFrame);
+
+    CallFrame* callFrame = stackFrame.callFrame;
+    CodeBlock* codeBlock = callFrame->codeBlock();
+    unsigned bytecodeIndex = stackFrame.args[0].int32();
+    FunctionExecutable* executable = static_cast<FunctionExecutable*>(codeBlock->ownerExecutable());
+
+    CodeBlock* optimizedCodeBlock = executable->optimize(stackFrame.globalData, callFrame->callee()->scope().node());
+    if (!optimizedCodeBlock) {
+        codeBlock->optimizeNever();
+        return 0;
+    }
+    codeBlock->optimizeAfter(stackFrame.globalData->optimizationThreshold);
+
+    if (!bytecodeIndex)
+        return 0;
+    OSRPoint* osrPoint = optimizedCodeBlock->osrPointForBytecodeIndex(bytecodeIndex);
+    if (!osrPoint)
+        return 0;
+    callFrame->setCodeBlock(optimizedCodeBlock);
+    return osrPoint->machineCode.executableAddress();
+}
+
+// Called on entry to optimized code whose speculations have failed too often.
+DEFINE_STUB_FUNCTION(void, vm_deoptimize)
+{
+    STUB_INIT_STACK_FRAME(stackFrame);
+
+    FunctionExecutable* executable = static_cast<FunctionExecutable*>(stackFrame.callFrame->codeBlock()->ownerExecutable());
+    executable->jettisonOptimizedCode();
+    executable->generatedBytecode().optimizeNever();
+}
+#endif
+
+#if ENABLE(VALUE_PROFILER)
+// Called from a value profiling site for a non-string cell whose structure is not
+// the profile's first.
+DEFINE_STUB_FUNCTION(void, vm_profile_cell)
+{
+    STUB_INIT_STACK_FRAME(stackFrame);
+
+    ValueProfile* profile = static_cast<ValueProfile*>(stackFrame.args[0].asPointer);
+    profile->observeCell(stackFrame.args[1].jsValue().asCell());
+}
+#endif
+
 DEFINE_STUB_FUNCTION(void, register_file_check)
 {
     STUB_INIT_STACK_FRAME(stackFrame);
@@ -1339,8 +1391,13 @@ DEFINE_STUB_FUNCTION(EncodedJSValue, op_get_by_id_generic)
     Identifier& ident = stackFrame.args[1].identifier();
 
     JSValue baseValue = stackFrame.args[0].jsValue();
+    JSValue result;
+    if (baseValue.isCell() && stackFrame.globalData->megamorphicCache.get(asCell(baseValue), ident, result))
+        return JSValue::encode(result);
+
     PropertySlot slot(baseValue);
-    JSValue result = baseValue.get(callFrame, ident, slot);
+    result = baseValue.get(callFrame, ident, slot);
+    stackFrame.globalData->megamorphicCache.add(baseValue, ident, slot);
 
     CHECK_FOR_EXCEPTION_AT_END();
     return JSValue::encode(result);
@@ -1412,6 +1469,90 @@ DEFINE_STUB_FUNCTION(void, op_put_by_id_direct_fail)
     CHECK_FOR_EXCEPTION_AT_END();
 }
 
+#if !USE(JSVALUE32_64)
+
+// Reached by a put_by_id that has been cached for some Structure when it sees
+// another; adds a stub for the new one until the list is full.
+static void tryCachePutByIDList(CallFrame* callFrame, CodeBlock* codeBlock, ReturnAddressPtr returnAddress, JSValue baseValue, const PutPropertySlot& slot, bool direct)
+{
+    if (!baseValue.isCell() || !slot.isCacheable())
+        return;
+
+    JSCell* baseCell = asCell(baseValue);
+    Structure* structure = baseCell->structure();
+    if (structure->isUncacheableDictionary() || baseCell != slot.base())
+        return;
+    if (slot.type() == PutPropertySlot::NewProperty && structure->isDictionary())
+        return;
+
+    StructureStubInfo* stubInfo = &codeBlock->getStubInfo(returnAddress);
+    PolymorphicPutByIdList* polymorphicStructures;
+    int listIndex = 1;
+
+    switch (stubInfo->accessType) {
+    case access_put_by_id_replace:
+        polymorphicStructures = new PolymorphicPutByIdList(CodeLocationLabel(), stubInfo->u.putByIdReplace.baseObjectStructure);
+        stubInfo->initPutByIdList(polymorphicStructures, 1);
+        break;
+    case access_put_by_id_transition:
+        polymorphicStructures = new PolymorphicPutByIdList(stubInfo->stubRoutine, stubInfo->u.putByIdTransition.previousStructure, stubInfo->u.putByIdTransition.structure, stubInfo->u.putByIdTransition.chain);
+        stubInfo->stubRoutine = CodeLocationLabel();
+        stubInfo->initPutByIdList(polymorphicStructures, 1);
+        break;
+    case access_put_by_id_list:
+        polymorphicStructures = stubInfo->u.putByIdList.structureList;
+        listIndex = stubInfo->u.putByIdList.listSize;
+        break;
+    default:
+        ASSERT_NOT_REACHED();
+        return;
+    }
+
+    if (listIndex == POLYMORPHIC_PUT_LIST_CACHE_SIZE)
+        return;
+    stubInfo->u.putByIdList.listSize++;
+
+    JSGlobalData* globalData = callFrame->scopeChain()->globalData;
+    if (slot.type() == PutPropertySlot::NewProperty) {
+        // The stub checks the prototype chain for setters.
+        normalizePrototypeChain(callFrame, baseCell);
+
+        StructureChain* prototypeChain = structure->prototypeChain(callFrame);
+        JIT::compilePutByIdList(globalData, codeBlock, stubInfo, polymorphicStructures, listIndex, structure->previousID(), structure, slot.cachedOffset(), prototypeChain, returnAddress, direct);
+    } else
+        JIT::compilePutByIdList(globalData, codeBlock, stubInfo, polymorphicStructures, listIndex, structure, 0, slot.cachedOffset(), 0, returnAddress, direct);
+}
+
+DEFINE_STUB_FUNCTION(void, op_put_by_id_list)
+{
+    STUB_INIT_STACK_FRAME(stackFrame);
+
+    CallFrame* callFrame = stackFrame.callFrame;
+    Identifier& ident = stackFrame.args[1].identifier();
+
+    PutPropertySlot slot;
+    stackFrame.args[0].jsValue().put(callFrame, ident, stackFrame.args[2].jsValue(), slot);
+    CHECK_FOR_EXCEPTION_VOID();
+
+    tryCachePutByIDList(callFrame, callFrame->codeBlock(), STUB_RETURN_ADDRESS, stackFrame.args[0].jsValue(), slot, false);
+}
+
+DEFINE_STUB_FUNCTION(void, op_put_by_id_direct_list)
+{
+    STUB_INIT_STACK_FRAME(stackFrame);
+
+    CallFrame* callFrame = stackFrame.callFrame;
+    Identifier& ident = stackFrame.args[1].identifier();
+
+    PutPropertySlot slot;
+    stackFrame.args[0].jsValue().putDirect(callFrame, ident, stackFrame.args[2].jsValue(), slot);
+    CHECK_FOR_EXCEPTION_VOID();
+
+    tryCachePutByIDList(callFrame, callFrame->codeBlock(), STUB_RETURN_ADDRESS, stackFrame.args[0].jsValue(), slot, true);
+}
+
+#endif // !USE(JSVALUE32_64)
+
 DEFINE_STUB_FUNCTION(JSObject*, op_put_by_id_transition_realloc)
 {
     STUB_INIT_STACK_FRAME(stackFrame);
@@ -1826,6 +1967,9 @@ DEFINE_STUB_FUNCTION(JSObject*, op_new_func)
 DEFINE_STUB_FUNCTION(void*, op_call_JSFunction)
 {
     STUB_INIT_STACK_FRAME(stackFrame);
+    // The callee frame is only partly initialized, so its caller is the one
+    // the collector must treat as running.
+    stackFrame.registerFile->setTopCallFrame(stackFrame.callFrame->callerFrame());
 
 #if !ASSERT_DISABLED
     CallData callData;
@@ -1844,6 +1988,9 @@ DEFINE_STUB_FUNCTION(void*, op_call_JSFunction)
 DEFINE_STUB_FUNCTION(VoidPtrPair, op_call_arityCheck)
 {
     STUB_INIT_STACK_FRAME(stackFrame);
+    // The callee frame is only partly initialized, so its caller is the one
+    // the collector must treat as running.
+    stackFrame.registerFile->setTopCallFrame(stackFrame.callFrame->callerFrame());
 
     CallFrame* callFrame = stackFrame.callFrame;
     JSFunction* callee = asFunction(stackFrame.args[0].jsValue());
@@ -1901,13 +2048,16 @@ DEFINE_STUB_FUNCTION(VoidPtrPair, op_call_arityCheck)
 DEFINE_STUB_FUNCTION(void*, vm_lazyLinkCall)
 {
     STUB_INIT_STACK_FRAME(stackFrame);
+    // The callee frame is only partly initialized, so its caller is the one
+    // the collector must treat as running.
+    stackFrame.registerFile->setTopCallFrame(stackFrame.callFrame->callerFrame());
     JSFunction* callee = asFunction(stackFrame.args[0].jsValue());
     ExecutableBase* executable = callee->executable();
     JITCode& jitCode = executable->generatedJITCode();
     
     CodeBlock* codeBlock = 0;
     if (!executable->isHostFunction())
-        codeBlock = &static_cast<FunctionExecutable*>(executable)->bytecode(stackFrame.callFrame, callee->scope().node());
+        codeBlock = &static_cast<FunctionExecutable*>(executable)->generatedJITCodeBlock();
     CallLinkInfo* callLinkInfo = &stackFrame.callFrame->callerFrame()->codeBlock()->getCallLinkInfo(stackFrame.args[1].returnAddress());
 
     if (!callLinkInfo->seenOnce())
@@ -2092,10 +2242,10 @@ DEFINE_STUB_FUNCTION(JSObject*, op_construct_JSConstruct)
 
     Structure* structure;
     if (stackFrame.args[3].jsValue().isObject())
-        structure = asObject(stackFrame.args[3].jsValue())->inheritorID();
+        structure = asObject(stackFrame.args[3].jsValue())->inheritorIDForConstruction();
     else
         structure = constructor->scope().node()->globalObject->emptyObjectStructure();
-    return new (stackFrame.globalData) JSObject(structure);
+    return constructObject(stackFrame.globalData, structure);
 }
 
 DEFINE_STUB_FUNCTION(EncodedJSValue, op_construct_NotJSConstruct)
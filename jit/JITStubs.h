@@ -387,6 +387,10 @@ extern "C" {
     void JIT_STUB cti_op_put_by_id_direct(STUB_ARGS_DECLARATION);
     void JIT_STUB cti_op_put_by_id_direct_fail(STUB_ARGS_DECLARATION);
     void JIT_STUB cti_op_put_by_id_direct_generic(STUB_ARGS_DECLARATION);
+#if !USE(JSVALUE32_64)
+    void JIT_STUB cti_op_put_by_id_list(STUB_ARGS_DECLARATION);
+    void JIT_STUB cti_op_put_by_id_direct_list(STUB_ARGS_DECLARATION);
+#endif
     void JIT_STUB cti_op_put_by_index(STUB_ARGS_DECLARATION);
     void JIT_STUB cti_op_put_by_val(STUB_ARGS_DECLARATION);
     void JIT_STUB cti_op_put_by_val_byte_array(STUB_ARGS_DECLARATION);
@@ -401,6 +405,13 @@ extern "C" {
     void* JIT_STUB cti_op_switch_imm(STUB_ARGS_DECLARATION);
     void* JIT_STUB cti_op_switch_string(STUB_ARGS_DECLARATION);
     void* JIT_STUB cti_vm_lazyLinkCall(STUB_ARGS_DECLARATION);
+#if ENABLE(JIT_OPTIMIZING_TIER)
+    void JIT_STUB cti_vm_deoptimize(STUB_ARGS_DECLARATION);
+    void* JIT_STUB cti_vm_optimize(STUB_ARGS_DECLARATION);
+#endif
+#if ENABLE(VALUE_PROFILER)
+    void JIT_STUB cti_vm_profile_cell(STUB_ARGS_DECLARATION);
+#endif
 } // extern "C"
 
 } // namespace JSC
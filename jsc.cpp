@@ -22,9 +22,12 @@
 
 #include "config.h"
 
+#include "BytecodeCache.h"
 #include "BytecodeGenerator.h"
+#include "CodeBlock.h"
 #include "Completion.h"
 #include "CurrentTime.h"
+#include "Executable.h"
 #include "InitializeThreading.h"
 #include "JSArray.h"
 #include "JSFunction.h"
@@ -86,6 +89,10 @@ static JSValue JSC_HOST_CALL functionSetSamplingFlags(ExecState*, JSObject*, JSV
 static JSValue JSC_HOST_CALL functionClearSamplingFlags(ExecState*, JSObject*, JSValue, const ArgList&);
 #endif
 
+#if ENABLE(VALUE_PROFILER)
+static JSValue JSC_HOST_CALL functionDumpValueProfiles(ExecState*, JSObject*, JSValue, const ArgList&);
+#endif
+
 struct Script {
     bool isFile;
     char* argument;
@@ -101,11 +108,13 @@ struct Options {
     Options()
         : interactive(false)
         , dump(false)
+        , bytecodeCache(0)
     {
     }
 
     bool interactive;
     bool dump;
+    const char* bytecodeCache;
     Vector<Script> scripts;
     Vector<UString> arguments;
 };
@@ -165,6 +174,10 @@ GlobalObject::GlobalObject(const Vector<UString>& arguments)
     putDirectFunction(globalExec(), new (globalExec()) NativeFunctionWrapper(globalExec(), prototypeFunctionStructure(), 1, Identifier(globalExec(), "clearSamplingFlags"), functionClearSamplingFlags));
 #endif
 
+#if ENABLE(VALUE_PROFILER)
+    putDirectFunction(globalExec(), new (globalExec()) NativeFunctionWrapper(globalExec(), prototypeFunctionStructure(), 1, Identifier(globalExec(), "dumpValueProfiles"), functionDumpValueProfiles));
+#endif
+
     JSObject* array = constructEmptyArray(globalExec());
     for (size_t i = 0; i < arguments.size(); ++i)
         array->put(globalExec(), i, jsString(globalExec(), arguments[i]));
@@ -276,6 +289,22 @@ JSValue JSC_HOST_CALL functionClearSamplingFlags(ExecState* exec, JSObject*, JSV
 }
 #endif
 
+#if ENABLE(VALUE_PROFILER)
+// Prints what each profiled instruction of a function has produced so far.
+JSValue JSC_HOST_CALL functionDumpValueProfiles(ExecState*, JSObject*, JSValue, const ArgList& args)
+{
+    JSValue value = args.at(0);
+    if (!value.isObject() || !asObject(value)->inherits(&JSFunction::info) || asFunction(value)->isHostFunction())
+        return jsUndefined();
+
+    FunctionExecutable* executable = asFunction(value)->jsExecutable();
+    if (executable->isGenerated())
+        executable->generatedBytecode().dumpValueProfiles();
+    fflush(stdout);
+    return jsUndefined();
+}
+#endif
+
 JSValue JSC_HOST_CALL functionReadline(ExecState* exec, JSObject*, JSValue, const ArgList&)
 {
     Vector<char, 256> line;
@@ -455,6 +484,7 @@ static void runInteractive(GlobalObject* globalObject)
 static NO_RETURN void printUsageStatement(JSGlobalData* globalData, bool help = false)
 {
     fprintf(stderr, "Usage: jsc [options] [files] [-- arguments]\n");
+    fprintf(stderr, "  -c         Caches function bytecode in the given file across runs\n");
     fprintf(stderr, "  -d         Dumps bytecode (debug builds only)\n");
     fprintf(stderr, "  -e         Evaluate argument as script code\n");
     fprintf(stderr, "  -f         Specifies a source file (deprecated)\n");
@@ -485,6 +515,12 @@ static void parseArguments(int argc, char** argv, Options& options, JSGlobalData
             options.scripts.append(Script(false, argv[i]));
             continue;
         }
+        if (!strcmp(arg, "-c")) {
+            if (++i == argc)
+                printUsageStatement(globalData);
+            options.bytecodeCache = argv[i];
+            continue;
+        }
         if (!strcmp(arg, "-i")) {
             options.interactive = true;
             continue;
@@ -525,11 +561,17 @@ int jscmain(int argc, char** argv, JSGlobalData* globalData)
     Options options;
     parseArguments(argc, argv, options, globalData);
 
+    if (options.bytecodeCache)
+        globalData->bytecodeCache.set(new BytecodeCache(options.bytecodeCache));
+
     GlobalObject* globalObject = new (globalData) GlobalObject(options.arguments);
     bool success = runWithScripts(globalObject, options.scripts, options.dump);
     if (options.interactive && success)
         runInteractive(globalObject);
 
+    if (options.bytecodeCache && !globalData->bytecodeCache->save())
+        fprintf(stderr, "Could not write bytecode cache: %s\n", options.bytecodeCache);
+
     return success ? 0 : 3;
 }
 
@@ -224,6 +224,9 @@ void Arguments::put(ExecState* exec, unsigned i, JSValue value, PutPropertySlot&
             d->registers[d->firstParameterIndex + i] = JSValue(value);
         else
             d->extraArguments[i - d->numParameters] = JSValue(value);
+        Heap::writeBarrier(this, value);
+        if (d->activation)
+            Heap::writeBarrier(d->activation, value); // The registers belong to the activation once it is torn off.
         return;
     }
 
@@ -239,6 +242,9 @@ void Arguments::put(ExecState* exec, const Identifier& propertyName, JSValue val
             d->registers[d->firstParameterIndex + i] = JSValue(value);
         else
             d->extraArguments[i - d->numParameters] = JSValue(value);
+        Heap::writeBarrier(this, value);
+        if (d->activation)
+            Heap::writeBarrier(d->activation, value); // The registers belong to the activation once it is torn off.
         return;
     }
 
@@ -85,6 +85,7 @@ namespace JSC {
         {
             d->activation = activation;
             d->registers = &activation->registerAt(0);
+            Heap::writeBarrier(this);
         }
 
         static PassRefPtr<Structure> createStructure(JSValue prototype) 
@@ -217,6 +218,7 @@ namespace JSC {
         memcpy(registerArray, d->registers - registerOffset, registerArraySize * sizeof(Register));
         d->registerArray.set(registerArray);
         d->registers = registerArray + registerOffset;
+        Heap::writeBarrier(this);
     }
 
     // This JSActivation function is defined here so it can get at Arguments::setRegisters.
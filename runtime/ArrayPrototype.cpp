@@ -73,7 +73,7 @@ static inline bool isNumericCompareFunction(ExecState* exec, CallType callType,
     if (callType != CallTypeJS)
         return false;
 
-#if ENABLE(JIT)
+#if ENABLE(JIT) && !ENABLE(INTERPRETER_OSR)
     // If the JIT is enabled then we need to preserve the invariant that every
     // function with a CodeBlock also has JIT code.
     CodeBlock* codeBlock = 0;
@@ -179,7 +179,7 @@ JSValue JSC_HOST_CALL arrayProtoFuncToString(ExecState* exec, JSObject*, JSValue
     for (unsigned k = 0; k < length; k++) {
         JSValue element;
         if (isRealArray && thisObj->canGetIndex(k))
-            element = thisObj->getIndex(k);
+            element = thisObj->getIndex(exec, k);
         else
             element = thisObj->get(exec, k);
         
@@ -288,7 +288,7 @@ JSValue JSC_HOST_CALL arrayProtoFuncJoin(ExecState* exec, JSObject*, JSValue thi
                 else
                     strBuffer.append(separator);
             }
-            JSValue element = array->getIndex(k);
+            JSValue element = array->getIndex(exec, k);
             if (!element.isUndefinedOrNull())
                 strBuffer.append(element.toString(exec));
         }
@@ -341,7 +341,7 @@ JSValue JSC_HOST_CALL arrayProtoFuncConcat(ExecState* exec, JSObject*, JSValue t
 JSValue JSC_HOST_CALL arrayProtoFuncPop(ExecState* exec, JSObject*, JSValue thisValue, const ArgList&)
 {
     if (isJSArray(&exec->globalData(), thisValue))
-        return asArray(thisValue)->pop();
+        return asArray(thisValue)->pop(exec);
 
     JSObject* thisObj = thisValue.toThisObject(exec);
     JSValue result;
@@ -629,7 +629,7 @@ JSValue JSC_HOST_CALL arrayProtoFuncFilter(ExecState* exec, JSObject*, JSValue t
         for (; k < length && !exec->hadException(); ++k) {
             if (!array->canGetIndex(k))
                 break;
-            JSValue v = array->getIndex(k);
+            JSValue v = array->getIndex(exec, k);
             cachedCall.setThis(applyThis);
             cachedCall.setArgument(0, v);
             cachedCall.setArgument(1, jsNumber(exec, k));
@@ -689,7 +689,7 @@ JSValue JSC_HOST_CALL arrayProtoFuncMap(ExecState* exec, JSObject*, JSValue this
                 break;
 
             cachedCall.setThis(applyThis);
-            cachedCall.setArgument(0, array->getIndex(k));
+            cachedCall.setArgument(0, array->getIndex(exec, k));
             cachedCall.setArgument(1, jsNumber(exec, k));
             cachedCall.setArgument(2, thisObj);
 
@@ -746,7 +746,7 @@ JSValue JSC_HOST_CALL arrayProtoFuncEvery(ExecState* exec, JSObject*, JSValue th
                 break;
             
             cachedCall.setThis(applyThis);
-            cachedCall.setArgument(0, array->getIndex(k));
+            cachedCall.setArgument(0, array->getIndex(exec, k));
             cachedCall.setArgument(1, jsNumber(exec, k));
             cachedCall.setArgument(2, thisObj);
             JSValue result = cachedCall.call();
@@ -800,7 +800,7 @@ JSValue JSC_HOST_CALL arrayProtoFuncForEach(ExecState* exec, JSObject*, JSValue
                 break;
 
             cachedCall.setThis(applyThis);
-            cachedCall.setArgument(0, array->getIndex(k));
+            cachedCall.setArgument(0, array->getIndex(exec, k));
             cachedCall.setArgument(1, jsNumber(exec, k));
             cachedCall.setArgument(2, thisObj);
 
@@ -847,7 +847,7 @@ JSValue JSC_HOST_CALL arrayProtoFuncSome(ExecState* exec, JSObject*, JSValue thi
                 break;
             
             cachedCall.setThis(applyThis);
-            cachedCall.setArgument(0, array->getIndex(k));
+            cachedCall.setArgument(0, array->getIndex(exec, k));
             cachedCall.setArgument(1, jsNumber(exec, k));
             cachedCall.setArgument(2, thisObj);
             JSValue result = cachedCall.call();
@@ -897,7 +897,7 @@ JSValue JSC_HOST_CALL arrayProtoFuncReduce(ExecState* exec, JSObject*, JSValue t
     if (args.size() >= 2)
         rv = args.at(1);
     else if (array && array->canGetIndex(0)){
-        rv = array->getIndex(0);
+        rv = array->getIndex(exec, 0);
         i = 1;
     } else {
         for (i = 0; i < length; i++) {
@@ -917,7 +917,7 @@ JSValue JSC_HOST_CALL arrayProtoFuncReduce(ExecState* exec, JSObject*, JSValue t
             cachedCall.setArgument(0, rv);
             JSValue v;
             if (LIKELY(array->canGetIndex(i)))
-                v = array->getIndex(i);
+                v = array->getIndex(exec, i);
             else
                 break; // length has been made unsafe while we enumerate fallback to slow path
             cachedCall.setArgument(1, v);
@@ -967,7 +967,7 @@ JSValue JSC_HOST_CALL arrayProtoFuncReduceRight(ExecState* exec, JSObject*, JSVa
     if (args.size() >= 2)
         rv = args.at(1);
     else if (array && array->canGetIndex(length - 1)){
-        rv = array->getIndex(length - 1);
+        rv = array->getIndex(exec, length - 1);
         i = 1;
     } else {
         for (i = 0; i < length; i++) {
@@ -988,7 +988,7 @@ JSValue JSC_HOST_CALL arrayProtoFuncReduceRight(ExecState* exec, JSObject*, JSVa
             cachedCall.setArgument(0, rv);
             if (UNLIKELY(!array->canGetIndex(idx)))
                 break; // length has been made unsafe while we enumerate fallback to slow path
-            cachedCall.setArgument(1, array->getIndex(idx));
+            cachedCall.setArgument(1, array->getIndex(exec, idx));
             cachedCall.setArgument(2, jsNumber(exec, idx));
             cachedCall.setArgument(3, array);
             rv = cachedCall.call();
@@ -37,9 +37,11 @@
 #include "Nodes.h"
 #include "Tracing.h"
 #include <algorithm>
+#include <limits>
 #include <limits.h>
 #include <setjmp.h>
 #include <stdlib.h>
+#include <wtf/CurrentTime.h>
 #include <wtf/FastMalloc.h>
 #include <wtf/HashCountedSet.h>
 #include <wtf/UnusedParam.h>
@@ -47,11 +49,13 @@
 
 #if OS(DARWIN)
 
+#include <errno.h>
 #include <mach/mach_init.h>
 #include <mach/mach_port.h>
 #include <mach/task.h>
 #include <mach/thread_act.h>
 #include <mach/vm_map.h>
+#include <sys/mman.h>
 
 #elif OS(WINDOWS)
 
@@ -64,6 +68,7 @@
 
 #elif OS(UNIX)
 
+#include <errno.h>
 #include <stdlib.h>
 #if !OS(HAIKU)
 #include <sys/mman.h>
@@ -90,8 +95,11 @@
 #endif
 
 #define COLLECT_ON_EVERY_ALLOCATION 0
+#define VERIFY_NURSERY_COLLECTIONS 0
+#define VERIFY_INCREMENTAL_MARKING 0
 
 using std::max;
+using std::min;
 
 namespace JSC {
 
@@ -100,9 +108,16 @@ namespace JSC {
 const size_t GROWTH_FACTOR = 2;
 const size_t LOW_WATER_FACTOR = 4;
 const size_t ALLOCATIONS_PER_COLLECTION = 3600;
+const size_t BYTES_PER_BLOCK = ATOMS_PER_BLOCK * ATOM_SIZE;
 // This value has to be a macro to be used in max() without introducing
 // a PIC branch in Mach-O binaries, see <rdar://problem/5971391>.
 #define MIN_ARRAY_SIZE (static_cast<size_t>(14))
+const size_t LARGE_STORAGE_PAGE_SIZE = 4096;
+const size_t LARGE_STORAGE_HEADER_SIZE = 2 * sizeof(size_t); // Holds the mapped size; keeps the storage 16-byte aligned on 64-bit.
+const size_t MAX_UNUSED_LARGE_STORAGE_MAPPINGS = 16;
+#if ENABLE(BLOCK_FREEING_THREAD)
+const double BLOCK_FREEING_INTERVAL = 1.0; // seconds
+#endif
 
 #if ENABLE(JSC_MULTIPLE_THREADS)
 
@@ -129,12 +144,26 @@ public:
 
 #endif
 
+HeapSizingPolicy::HeapSizingPolicy()
+    : targetLiveRatio(0.5)
+    , minHeapSize(ALLOCATIONS_PER_COLLECTION * CELL_SIZE)
+    , maxHeapSize(0)
+    , extraMemoryBudget(Heap::maxExtraCost)
+    , evacuationThreshold(0)
+{
+}
+
 Heap::Heap(JSGlobalData* globalData)
     : m_markListSet(0)
 #if ENABLE(JSC_MULTIPLE_THREADS)
     , m_registeredThreads(0)
     , m_currentThreadRegistrar(0)
 #endif
+#if ENABLE(BLOCK_FREEING_THREAD)
+    , m_isTakingFreeBlocks(false)
+    , m_blockFreeingThreadShouldQuit(false)
+    , m_blockFreeingThread(0)
+#endif
 #if OS(SYMBIAN)
     , m_blockallocator(JSCCOLLECTOR_VIRTUALMEM_RESERVATION, BLOCK_SIZE)
 #endif
@@ -142,7 +171,11 @@ Heap::Heap(JSGlobalData* globalData)
 {
     ASSERT(globalData);
     memset(&m_heap, 0, sizeof(CollectorHeap));
-    allocateBlock();
+    for (size_t i = 0; i < NUM_SIZE_CLASSES; ++i)
+        m_heap.sizeClasses[i].atomsPerCell = 1 << i;
+    m_heap.fullCollectionThreshold = heapSizeLimit(0);
+    m_heap.growthLimit = (m_heap.fullCollectionThreshold + BYTES_PER_BLOCK - 1) / BYTES_PER_BLOCK;
+    m_heap.nextCollectionType = NurseryCollection;
 }
 
 Heap::~Heap()
@@ -168,7 +201,26 @@ void Heap::destroy()
     delete m_markListSet;
     m_markListSet = 0;
 
+    // Abandon an unfinished incremental collection.
+    if (m_heap.isMarkingIncrementally) {
+        m_globalData->markStack.drain();
+        m_heap.isMarkingIncrementally = false;
+    }
+
+#if ENABLE(BLOCK_FREEING_THREAD)
+    if (m_blockFreeingThread) {
+        {
+            MutexLocker locker(m_freeBlockLock);
+            m_blockFreeingThreadShouldQuit = true;
+            m_freeBlockCondition.signal();
+        }
+        waitForThreadCompletion(m_blockFreeingThread, 0);
+        m_blockFreeingThread = 0;
+    }
+#endif
+
     freeBlocks();
+    freeUnusedLargeStorage();
 
 #if ENABLE(JSC_MULTIPLE_THREADS)
     if (m_currentThreadRegistrar) {
@@ -189,7 +241,7 @@ void Heap::destroy()
     m_globalData = 0;
 }
 
-NEVER_INLINE CollectorBlock* Heap::allocateBlock()
+NEVER_INLINE CollectorBlock* Heap::allocateBlockPtr()
 {
 #if OS(DARWIN)
     vm_address_t address = 0;
@@ -237,49 +289,64 @@ NEVER_INLINE CollectorBlock* Heap::allocateBlock()
     address += adjust;
 #endif
 
+    return reinterpret_cast<CollectorBlock*>(address);
+}
+
+NEVER_INLINE CollectorBlock* Heap::allocateBlock(CollectorSizeClass& sizeClass)
+{
+    CollectorBlock* block = takeFreeBlock();
+    if (!block)
+        block = allocateBlockPtr();
+
     // Initialize block.
 
-    CollectorBlock* block = reinterpret_cast<CollectorBlock*>(address);
     block->heap = this;
+    block->atomsPerCell = sizeClass.atomsPerCell;
+    block->isEvacuating = false;
+    block->marked.clearAll();
+    block->immovable.clearAll();
     clearMarkBits(block);
 
     Structure* dummyMarkableCellStructure = m_globalData->dummyMarkableCellStructure.get();
-    for (size_t i = 0; i < HeapConstants::cellsPerBlock; ++i)
+    for (size_t i = 0; i < block->endAtom(); i += block->atomsPerCell)
         new (block->cells + i) JSCell(dummyMarkableCellStructure);
     
     // Add block to blocks vector.
 
-    size_t numBlocks = m_heap.numBlocks;
-    if (m_heap.usedBlocks == numBlocks) {
+    size_t numBlocks = sizeClass.numBlocks;
+    if (sizeClass.usedBlocks == numBlocks) {
         static const size_t maxNumBlocks = ULONG_MAX / sizeof(CollectorBlock*) / GROWTH_FACTOR;
         if (numBlocks > maxNumBlocks)
             CRASH();
         numBlocks = max(MIN_ARRAY_SIZE, numBlocks * GROWTH_FACTOR);
-        m_heap.numBlocks = numBlocks;
-        m_heap.blocks = static_cast<CollectorBlock**>(fastRealloc(m_heap.blocks, numBlocks * sizeof(CollectorBlock*)));
+        sizeClass.numBlocks = numBlocks;
+        sizeClass.blocks = static_cast<CollectorBlock**>(fastRealloc(sizeClass.blocks, numBlocks * sizeof(CollectorBlock*)));
     }
-    m_heap.blocks[m_heap.usedBlocks++] = block;
+    sizeClass.blocks[sizeClass.usedBlocks++] = block;
+    m_heap.usedBlocks++;
+    m_blocks.add(block);
 
     return block;
 }
 
-NEVER_INLINE void Heap::freeBlock(size_t block)
+NEVER_INLINE void Heap::freeBlock(CollectorSizeClass& sizeClass, size_t block)
 {
     m_heap.didShrink = true;
 
-    ObjectIterator it(m_heap, block);
-    ObjectIterator end(m_heap, block + 1);
-    for ( ; it != end; ++it)
-        (*it)->~JSCell();
-    freeBlockPtr(m_heap.blocks[block]);
+    CollectorBlock* ptr = sizeClass.blocks[block];
+    for (size_t i = 0; i < ptr->endAtom(); i += ptr->atomsPerCell)
+        reinterpret_cast<JSCell*>(ptr->cells + i)->~JSCell();
+    m_blocks.remove(ptr);
+    releaseBlock(ptr);
 
     // swap with the last block so we compact as we go
-    m_heap.blocks[block] = m_heap.blocks[m_heap.usedBlocks - 1];
+    sizeClass.blocks[block] = sizeClass.blocks[sizeClass.usedBlocks - 1];
+    sizeClass.usedBlocks--;
     m_heap.usedBlocks--;
 
-    if (m_heap.numBlocks > MIN_ARRAY_SIZE && m_heap.usedBlocks < m_heap.numBlocks / LOW_WATER_FACTOR) {
-        m_heap.numBlocks = m_heap.numBlocks / GROWTH_FACTOR; 
-        m_heap.blocks = static_cast<CollectorBlock**>(fastRealloc(m_heap.blocks, m_heap.numBlocks * sizeof(CollectorBlock*)));
+    if (sizeClass.numBlocks > MIN_ARRAY_SIZE && sizeClass.usedBlocks < sizeClass.numBlocks / LOW_WATER_FACTOR) {
+        sizeClass.numBlocks = sizeClass.numBlocks / GROWTH_FACTOR; 
+        sizeClass.blocks = static_cast<CollectorBlock**>(fastRealloc(sizeClass.blocks, sizeClass.numBlocks * sizeof(CollectorBlock*)));
     }
 }
 
@@ -304,19 +371,87 @@ NEVER_INLINE void Heap::freeBlockPtr(CollectorBlock* block)
 #endif
 }
 
+CollectorBlock* Heap::takeFreeBlock()
+{
+#if ENABLE(BLOCK_FREEING_THREAD)
+    MutexLocker locker(m_freeBlockLock);
+    m_isTakingFreeBlocks = true;
+    if (!m_freeBlocks.isEmpty()) {
+        CollectorBlock* block = m_freeBlocks.last();
+        m_freeBlocks.removeLast();
+        return block;
+    }
+#endif
+    return 0;
+}
+
+// Rather than being handed back to the system right away, freed blocks are
+// kept for the heap to reuse. If the heap stops taking them, the block freeing
+// thread releases them, a share at a time, so neither collecting nor growing
+// the heap waits on the system allocator.
+void Heap::releaseBlock(CollectorBlock* block)
+{
+#if ENABLE(BLOCK_FREEING_THREAD)
+    MutexLocker locker(m_freeBlockLock);
+    if (!m_blockFreeingThread)
+        m_blockFreeingThread = createThread(blockFreeingThreadStartFunc, this, "JavaScriptCore::BlockFree");
+    if (m_blockFreeingThread) {
+        m_freeBlocks.append(block);
+        return;
+    }
+#endif
+    freeBlockPtr(block);
+}
+
+#if ENABLE(BLOCK_FREEING_THREAD)
+void* Heap::blockFreeingThreadStartFunc(void* heap)
+{
+    static_cast<Heap*>(heap)->blockFreeingThreadMain();
+    return 0;
+}
+
+void Heap::blockFreeingThreadMain()
+{
+    MutexLocker locker(m_freeBlockLock);
+    while (!m_blockFreeingThreadShouldQuit) {
+        m_freeBlockCondition.timedWait(m_freeBlockLock, currentTime() + BLOCK_FREEING_INTERVAL);
+        if (m_blockFreeingThreadShouldQuit)
+            break;
+
+        // Keep the free blocks while the heap is still growing into them.
+        if (m_isTakingFreeBlocks) {
+            m_isTakingFreeBlocks = false;
+            continue;
+        }
+
+        // Free half of the blocks, dropping the lock while calling into the system.
+        for (size_t blocksToFree = (m_freeBlocks.size() + 1) / 2; blocksToFree && !m_freeBlocks.isEmpty(); --blocksToFree) {
+            CollectorBlock* block = m_freeBlocks.last();
+            m_freeBlocks.removeLast();
+            m_freeBlockLock.unlock();
+            freeBlockPtr(block);
+            m_freeBlockLock.lock();
+        }
+    }
+}
+#endif
+
 void Heap::freeBlocks()
 {
     ProtectCountSet protectedValuesCopy = m_protectedValues;
 
-    clearMarkBits();
+    for (size_t i = 0; i < NUM_SIZE_CLASSES; ++i) {
+        CollectorSizeClass& sizeClass = m_heap.sizeClasses[i];
+        for (size_t block = 0; block < sizeClass.usedBlocks; ++block)
+            sizeClass.blocks[block]->marked.clearAll();
+    }
     ProtectCountSet::iterator protectedValuesEnd = protectedValuesCopy.end();
     for (ProtectCountSet::iterator it = protectedValuesCopy.begin(); it != protectedValuesEnd; ++it)
         markCell(it->first);
 
-    m_heap.nextCell = 0;
-    m_heap.nextBlock = 0;
-    DeadObjectIterator it(m_heap, m_heap.nextBlock, m_heap.nextCell);
-    DeadObjectIterator end(m_heap, m_heap.usedBlocks);
+    resetAllocationCursors();
+    DeadObjectIterator it(m_heap, 0);
+    DeadObjectIterator end(m_heap, NUM_SIZE_CLASSES);
     for ( ; it != end; ++it)
         (*it)->~JSCell();
 
@@ -326,10 +461,20 @@ void Heap::freeBlocks()
     for (ProtectCountSet::iterator it = protectedValuesCopy.begin(); it != protectedValuesEnd; ++it)
         it->first->~JSCell();
 
-    for (size_t block = 0; block < m_heap.usedBlocks; ++block)
-        freeBlockPtr(m_heap.blocks[block]);
+    for (size_t i = 0; i < NUM_SIZE_CLASSES; ++i) {
+        CollectorSizeClass& sizeClass = m_heap.sizeClasses[i];
+        for (size_t block = 0; block < sizeClass.usedBlocks; ++block)
+            freeBlockPtr(sizeClass.blocks[block]);
+        fastFree(sizeClass.blocks);
+    }
+    m_blocks.clear();
 
-    fastFree(m_heap.blocks);
+#if ENABLE(BLOCK_FREEING_THREAD)
+    ASSERT(!m_blockFreeingThread);
+    for (size_t i = 0; i < m_freeBlocks.size(); ++i)
+        freeBlockPtr(m_freeBlocks[i]);
+    m_freeBlocks.clear();
+#endif
 
     memset(&m_heap, 0, sizeof(CollectorHeap));
 }
@@ -345,9 +490,11 @@ void Heap::recordExtraCost(size_t cost)
     // of this extra cost until the next GC. In garbage collected languages, most values
     // are either very short lived temporaries, or have extremely long lifetimes. So
     // if a large value survives one garbage collection, there is not much point to
-    // collecting more frequently as long as it stays alive.
+    // collecting more frequently as long as it stays alive. The extra cost has to
+    // exceed both the sizing policy's budget and half the heap's own size, so that
+    // a large heap is not collected for comparatively little extra memory.
 
-    if (m_heap.extraCost > maxExtraCost && m_heap.extraCost > m_heap.usedBlocks * BLOCK_SIZE / 2) {
+    if (m_heap.extraCost > m_sizingPolicy.extraMemoryBudget && m_heap.extraCost > m_heap.usedBlocks * BLOCK_SIZE / 2) {
         // If the last iteration through the heap deallocated blocks, we need
         // to clean up remaining garbage before marking. Otherwise, the conservative
         // marking mechanism might follow a pointer to unmapped memory.
@@ -358,14 +505,212 @@ void Heap::recordExtraCost(size_t cost)
     m_heap.extraCost += cost;
 }
 
+static void* mapLargeStorage(size_t size)
+{
+#if OS(WINDOWS)
+    return VirtualAlloc(0, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+#elif HAVE(MMAP) && !OS(HAIKU)
+    void* address = mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, VM_TAG_FOR_COLLECTOR_MEMORY, 0);
+    return address == MAP_FAILED ? 0 : address;
+#else
+    void* address;
+    return tryFastMalloc(size).getValue(address) ? address : 0;
+#endif
+}
+
+static void unmapLargeStorage(void* address, size_t size)
+{
+#if OS(WINDOWS)
+    UNUSED_PARAM(size);
+    VirtualFree(address, 0, MEM_RELEASE);
+#elif HAVE(MMAP) && !OS(HAIKU)
+    munmap(address, size);
+#else
+    UNUSED_PARAM(size);
+    fastFree(address);
+#endif
+}
+
+void* Heap::tryAllocateLargeStorage(size_t bytes)
+{
+    ASSERT(bytes >= minLargeStorageSize);
+    if (bytes > std::numeric_limits<size_t>::max() - LARGE_STORAGE_HEADER_SIZE - LARGE_STORAGE_PAGE_SIZE)
+        return 0;
+    size_t size = (bytes + LARGE_STORAGE_HEADER_SIZE + LARGE_STORAGE_PAGE_SIZE - 1) & ~(LARGE_STORAGE_PAGE_SIZE - 1);
+
+    // Reuse the smallest unused mapping that fits without wasting more than
+    // half of it.
+    size_t best = notFound;
+    for (size_t i = 0; i < m_unusedLargeStorage.size(); ++i) {
+        size_t unusedSize = m_unusedLargeStorage[i].size;
+        if (unusedSize >= size && unusedSize / 2 < size && (best == notFound || unusedSize < m_unusedLargeStorage[best].size))
+            best = i;
+    }
+
+    void* base;
+    if (best != notFound) {
+        base = m_unusedLargeStorage[best].base;
+        size = m_unusedLargeStorage[best].size;
+        m_unusedLargeStorage.remove(best);
+    } else {
+        base = mapLargeStorage(size);
+        if (!base)
+            return 0;
+    }
+
+    *static_cast<size_t*>(base) = size;
+    m_heap.largeStorageSize += size;
+    return static_cast<char*>(base) + LARGE_STORAGE_HEADER_SIZE;
+}
+
+void* Heap::tryReallocateLargeStorage(void* storage, size_t bytes)
+{
+    size_t size = *reinterpret_cast<size_t*>(static_cast<char*>(storage) - LARGE_STORAGE_HEADER_SIZE);
+    if (bytes <= size - LARGE_STORAGE_HEADER_SIZE)
+        return storage;
+
+    void* newStorage = tryAllocateLargeStorage(bytes);
+    if (!newStorage)
+        return 0;
+    memcpy(newStorage, storage, size - LARGE_STORAGE_HEADER_SIZE);
+    freeLargeStorage(storage);
+    return newStorage;
+}
+
+void Heap::freeLargeStorage(void* storage)
+{
+    void* base = static_cast<char*>(storage) - LARGE_STORAGE_HEADER_SIZE;
+    size_t size = *static_cast<size_t*>(base);
+    ASSERT(m_heap.largeStorageSize >= size);
+    m_heap.largeStorageSize -= size;
+
+#if HAVE(MMAP) && !OS(HAIKU)
+    // Hand the pages back now, but keep the mapping, since a program that
+    // makes one large array tends to make another of about the same size.
+    if (m_unusedLargeStorage.size() < MAX_UNUSED_LARGE_STORAGE_MAPPINGS) {
+#if HAVE(MADV_FREE)
+        while (madvise(base, size, MADV_FREE) == -1 && errno == EAGAIN) { }
+#else
+        while (madvise(base, size, MADV_DONTNEED) == -1 && errno == EAGAIN) { }
+#endif
+        LargeStorageMapping mapping = { base, size };
+        m_unusedLargeStorage.append(mapping);
+        return;
+    }
+#endif
+    unmapLargeStorage(base, size);
+}
+
+void Heap::freeUnusedLargeStorage()
+{
+    for (size_t i = 0; i < m_unusedLargeStorage.size(); ++i)
+        unmapLargeStorage(m_unusedLargeStorage[i].base, m_unusedLargeStorage[i].size);
+    m_unusedLargeStorage.clear();
+}
+
+#if COMPILER(GCC)
+static inline size_t countTrailingZeros(uint32_t bits)
+{
+    ASSERT(bits);
+    return __builtin_ctz(bits);
+}
+#else
+static inline size_t countTrailingZeros(uint32_t bits)
+{
+    ASSERT(bits);
+    size_t result = 0;
+    if (!(bits & 0xFFFF)) {
+        bits >>= 16;
+        result += 16;
+    }
+    if (!(bits & 0xFF)) {
+        bits >>= 8;
+        result += 8;
+    }
+    if (!(bits & 0xF)) {
+        bits >>= 4;
+        result += 4;
+    }
+    if (!(bits & 0x3)) {
+        bits >>= 2;
+        result += 2;
+    }
+    if (!(bits & 0x1))
+        result += 1;
+    return result;
+}
+#endif
+
+// Free cells stay valid (dummy) JSCells, so conservative marking can safely
+// reach them. The free list link lives just past the JSCell header.
+static inline CollectorCell*& freeListNext(CollectorCell* cell)
+{
+    return *reinterpret_cast<CollectorCell**>(reinterpret_cast<char*>(cell) + sizeof(JSCell));
+}
+
+COMPILE_ASSERT(sizeof(JSCell) + sizeof(CollectorCell*) <= sizeof(CollectorCell), free_list_link_fits_in_cell);
+
+void Heap::buildFreeList(CollectorSizeClass& sizeClass, CollectorBlock* block)
+{
+    ASSERT(!sizeClass.freeList);
+
+    // Bits of a bitmap word that correspond to the start of a cell.
+    uint32_t cellStartBits = 0;
+    for (size_t i = 0; i < 32; i += block->atomsPerCell)
+        cellStartBits |= 1u << i;
+
+    Structure* dummyMarkableCellStructure = m_globalData->dummyMarkableCellStructure.get();
+    CollectorCell** tail = &sizeClass.freeList;
+
+    m_heap.operationInProgress = Allocation;
+
+    size_t endAtom = block->endAtom();
+    for (size_t word = 0; word * 32 < endAtom; ++word) {
+        uint32_t deadCells = ~block->marked.bits[word] & cellStartBits;
+        // A dead cell that incremental marking has reached may still be on the
+        // mark stack, so leave it alone until the collection is done.
+        if (m_heap.isMarkingIncrementally)
+            deadCells &= ~block->marking.bits[word];
+        if (endAtom - word * 32 < 32)
+            deadCells &= (1u << (endAtom - word * 32)) - 1;
+        block->immovable.bits[word] &= ~deadCells;
+
+        while (deadCells) {
+            CollectorCell* cell = block->cells + word * 32 + countTrailingZeros(deadCells);
+            deadCells &= deadCells - 1;
+
+            JSCell* imp = reinterpret_cast<JSCell*>(cell);
+            imp->~JSCell();
+            new (imp) JSCell(dummyMarkableCellStructure);
+
+            *tail = cell;
+            tail = &freeListNext(cell);
+        }
+    }
+    *tail = 0;
+
+    m_heap.operationInProgress = NoOperation;
+}
+
+inline size_t Heap::sizeClassFor(size_t bytes)
+{
+    ASSERT(bytes <= LARGE_CELL_SIZE);
+    size_t sizeClass = 0;
+    for (size_t cellSize = ATOM_SIZE; cellSize < bytes; cellSize <<= 1)
+        ++sizeClass;
+    return sizeClass;
+}
+
+size_t Heap::cellSizeFor(size_t bytes)
+{
+    return ATOM_SIZE << sizeClassFor(bytes);
+}
+
 void* Heap::allocate(size_t s)
 {
-    typedef HeapConstants::Block Block;
-    typedef HeapConstants::Cell Cell;
-    
     ASSERT(JSLock::lockCount() > 0);
     ASSERT(JSLock::currentThreadIsHoldingLock());
-    ASSERT_UNUSED(s, s <= HeapConstants::cellSize);
+    ASSERT(s <= LARGE_CELL_SIZE);
 
     ASSERT(m_heap.operationInProgress == NoOperation);
 
@@ -374,78 +719,295 @@ void* Heap::allocate(size_t s)
     ASSERT(m_heap.operationInProgress == NoOperation);
 #endif
 
+#if ENABLE(JSC_ZOMBIES)
+    // Sweeping turns dead cells into zombies in place, so every cell must be able to hold one.
+    s = max(s, sizeof(JSZombie));
+#endif
+
+    CollectorSizeClass& sizeClass = m_heap.sizeClasses[sizeClassFor(s)];
+    bool didCollect = false;
+
 allocate:
 
-    // Fast case: find the next garbage cell and recycle it.
+    // Fast case: pop a cell off this size class's free list.
 
-    do {
-        ASSERT(m_heap.nextBlock < m_heap.usedBlocks);
-        Block* block = reinterpret_cast<Block*>(m_heap.blocks[m_heap.nextBlock]);
-        do {
-            ASSERT(m_heap.nextCell < HeapConstants::cellsPerBlock);
-            if (!block->marked.get(m_heap.nextCell)) { // Always false for the last cell in the block
-                Cell* cell = block->cells + m_heap.nextCell;
+    if (CollectorCell* cell = sizeClass.freeList) {
+        sizeClass.freeList = freeListNext(cell);
+        CollectorBlock* block = cellBlock(reinterpret_cast<JSCell*>(cell));
+        size_t offset = cellOffset(reinterpret_cast<JSCell*>(cell));
+        block->marked.set(offset);
+        if (!m_heap.isMarkingIncrementally)
+            block->young.set(offset);
+        return cell;
+    }
 
-                m_heap.operationInProgress = Allocation;
-                JSCell* imp = reinterpret_cast<JSCell*>(cell);
-                imp->~JSCell();
-                m_heap.operationInProgress = NoOperation;
+    // Pace incremental marking by allocation: one slice per free list refill.
+    if (m_heap.isMarkingIncrementally)
+        markIncrementally();
 
-                ++m_heap.nextCell;
-                return cell;
-            }
-        } while (++m_heap.nextCell != HeapConstants::cellsPerBlock);
-        m_heap.nextCell = 0;
-    } while (++m_heap.nextBlock != m_heap.usedBlocks);
+    // Refill the free list by sweeping the next block of this size class.
+    // Blocks waiting to be evacuated are left as sparse as they are.
+
+    while (sizeClass.nextBlock != sizeClass.usedBlocks) {
+        CollectorBlock* block = sizeClass.blocks[sizeClass.nextBlock++];
+        if (block->isEvacuating)
+            continue;
+        buildFreeList(sizeClass, block);
+        if (sizeClass.freeList)
+            goto allocate;
+    }
+
+    // Slow case: reached the end of the size class. Add a block if the heap has
+    // room to grow, or if collecting didn't free a cell of this size. Otherwise,
+    // mark live objects and start over.
+
+    if (didCollect || m_heap.usedBlocks < m_heap.growthLimit) {
+        allocateBlock(sizeClass);
+        goto allocate;
+    }
 
-    // Slow case: reached the end of the heap. Mark live objects and start over.
+    // While marking incrementally, let the heap grow to up to twice its limit
+    // before finishing the collection in one pause.
+    if (m_heap.isMarkingIncrementally && m_heap.usedBlocks < 2 * m_heap.growthLimit) {
+        allocateBlock(sizeClass);
+        goto allocate;
+    }
 
+    // Other size classes may still hold unswept garbage. If the last collection
+    // deallocated blocks, that garbage may point into unmapped memory, so it needs
+    // to be cleaned up before conservative marking can reach it.
+    if (m_heap.didShrink)
+        sweep();
+    if (shouldMarkIncrementally()) {
+        startIncrementalMarking();
+        allocateBlock(sizeClass);
+        goto allocate;
+    }
     reset();
+    didCollect = true;
     goto allocate;
 }
 
-void Heap::resizeBlocks()
+void Heap::setSizingPolicy(const HeapSizingPolicy& policy)
+{
+    ASSERT(policy.targetLiveRatio > 0 && policy.targetLiveRatio <= 1);
+    m_sizingPolicy = policy;
+
+    // Until the next collection, count every allocated cell as live.
+    size_t limit = heapSizeLimit(liveBytes());
+    m_heap.growthLimit = (limit + BYTES_PER_BLOCK - 1) / BYTES_PER_BLOCK;
+}
+
+// Returns the heap size to collect at, given how many bytes are live: big
+// enough for the live cells to make up the target ratio of it, within the
+// policy's caps. There is always room for ALLOCATIONS_PER_COLLECTION more
+// cells, so that a heap at its cap does not collect on every allocation.
+size_t Heap::heapSizeLimit(size_t liveBytes) const
+{
+    size_t limit = static_cast<size_t>(liveBytes / m_sizingPolicy.targetLiveRatio);
+    limit = max(limit, m_sizingPolicy.minHeapSize);
+    if (m_sizingPolicy.maxHeapSize)
+        limit = min(limit, m_sizingPolicy.maxHeapSize);
+    return max(limit, liveBytes + ALLOCATIONS_PER_COLLECTION * CELL_SIZE);
+}
+
+void Heap::resizeBlocks(CollectionType collectionType)
 {
     m_heap.didShrink = false;
 
-    size_t usedCellCount = markedCells();
-    size_t minCellCount = usedCellCount + max(ALLOCATIONS_PER_COLLECTION, usedCellCount);
-    size_t minBlockCount = (minCellCount + HeapConstants::cellsPerBlock - 1) / HeapConstants::cellsPerBlock;
+    size_t usedBytes = liveBytes();
+    size_t minBytes = heapSizeLimit(usedBytes);
+    size_t minBlockCount = (minBytes + BYTES_PER_BLOCK - 1) / BYTES_PER_BLOCK;
+
+    // Nursery collections never reclaim old cells, so fall back to a full
+    // collection once the heap has grown as much as a full one would allow.
+    if (collectionType == FullCollection)
+        m_heap.fullCollectionThreshold = minBytes;
+    m_heap.nextCollectionType = usedBytes > m_heap.fullCollectionThreshold ? FullCollection : NurseryCollection;
 
-    size_t maxCellCount = 1.25f * minCellCount;
-    size_t maxBlockCount = (maxCellCount + HeapConstants::cellsPerBlock - 1) / HeapConstants::cellsPerBlock;
+    size_t maxBytes = 1.25f * minBytes;
+    size_t maxBlockCount = (maxBytes + BYTES_PER_BLOCK - 1) / BYTES_PER_BLOCK;
 
-    if (m_heap.usedBlocks < minBlockCount)
-        growBlocks(minBlockCount);
-    else if (m_heap.usedBlocks > maxBlockCount)
+    // Size classes grow on demand, one block at a time, until the heap reaches
+    // minBlockCount blocks.
+    m_heap.growthLimit = minBlockCount;
+    if (m_heap.usedBlocks > maxBlockCount)
         shrinkBlocks(maxBlockCount);
-}
 
-void Heap::growBlocks(size_t neededBlocks)
-{
-    ASSERT(m_heap.usedBlocks < neededBlocks);
-    while (m_heap.usedBlocks < neededBlocks)
-        allocateBlock();
+    // Blocks that are only kept for a few live cells can be emptied, but only
+    // by a collection that knows which references to them it can update.
+    if (collectionType == FullCollection) {
+        bool shouldEvacuate = m_sizingPolicy.evacuationThreshold && m_heap.usedBlocks > maxBlockCount;
+        chooseBlocksToEvacuate(shouldEvacuate ? m_heap.usedBlocks - maxBlockCount : 0);
+    }
 }
 
 void Heap::shrinkBlocks(size_t neededBlocks)
 {
     ASSERT(m_heap.usedBlocks > neededBlocks);
     
-    // Clear the always-on last bit, so isEmpty() isn't fooled by it.
-    for (size_t i = 0; i < m_heap.usedBlocks; ++i)
-        m_heap.blocks[i]->marked.clear(HeapConstants::cellsPerBlock - 1);
-
-    for (size_t i = 0; i != m_heap.usedBlocks && m_heap.usedBlocks != neededBlocks; ) {
-        if (m_heap.blocks[i]->marked.isEmpty()) {
-            freeBlock(i);
-        } else
-            ++i;
+    for (size_t i = 0; i < NUM_SIZE_CLASSES; ++i) {
+        CollectorSizeClass& sizeClass = m_heap.sizeClasses[i];
+        for (size_t block = 0; block != sizeClass.usedBlocks && m_heap.usedBlocks != neededBlocks; ) {
+            if (sizeClass.blocks[block]->marked.isEmpty())
+                freeBlock(sizeClass, block);
+            else
+                ++block;
+        }
+    }
+}
+
+// Picks the sparsest blocks, up to maxBlocks, whose live cells the next
+// stop-the-world full collection moves out so that the blocks can be freed.
+// Until then, nothing is allocated in them.
+void Heap::chooseBlocksToEvacuate(size_t maxBlocks)
+{
+#if ENABLE(JSC_ZOMBIES)
+    maxBlocks = 0;
+#endif
+    if (!maxBlocks && !m_heap.evacuatingBlocks)
+        return;
+
+    size_t thresholdBytes = static_cast<size_t>(m_sizingPolicy.evacuationThreshold * BYTES_PER_BLOCK);
+    Vector<std::pair<size_t, CollectorBlock*> > candidates;
+    for (size_t i = 0; i < NUM_SIZE_CLASSES; ++i) {
+        CollectorSizeClass& sizeClass = m_heap.sizeClasses[i];
+        for (size_t block = 0; block < sizeClass.usedBlocks; ++block) {
+            CollectorBlock* collectorBlock = sizeClass.blocks[block];
+            collectorBlock->isEvacuating = false;
+            size_t liveBytes = collectorBlock->marked.count() * collectorBlock->cellSize();
+            if (maxBlocks && liveBytes < thresholdBytes)
+                candidates.append(std::make_pair(liveBytes, collectorBlock));
+        }
     }
 
-    // Reset the always-on last bit.
-    for (size_t i = 0; i < m_heap.usedBlocks; ++i)
-        m_heap.blocks[i]->marked.set(HeapConstants::cellsPerBlock - 1);
+    std::sort(candidates.begin(), candidates.end());
+    m_heap.evacuatingBlocks = min(maxBlocks, candidates.size());
+    for (size_t i = 0; i < m_heap.evacuatingBlocks; ++i)
+        candidates[i].second->isEvacuating = true;
+}
+
+// Only cells of these classes move: their addresses are kept nowhere that
+// marking does not either update or pin.
+static inline bool isMovable(JSCell* cell)
+{
+    void* vptr = cell->vptr();
+    return vptr == JSGlobalData::jsObjectVPtr || vptr == JSGlobalData::jsArrayVPtr || vptr == JSGlobalData::jsStringVPtr;
+}
+
+bool Heap::canEvacuate(CollectorBlock* block)
+{
+    for (size_t atom = 0; atom < block->endAtom(); atom += block->atomsPerCell) {
+        if (!block->marked.get(atom))
+            continue;
+        if (block->pinned.get(atom) || block->immovable.get(atom) || !isMovable(reinterpret_cast<JSCell*>(block->cells + atom)))
+            return false;
+    }
+    return true;
+}
+
+// A moved cell's old location holds its new address until the references to
+// it have been updated.
+static inline JSCell*& forwardingAddress(JSCell* cell)
+{
+    return *reinterpret_cast<JSCell**>(reinterpret_cast<char*>(cell) + sizeof(JSCell));
+}
+
+// Moves the live cells of the blocks chosen for evacuation into the dead cells
+// of other blocks of the same size class, then updates the references marking
+// recorded to them. A block is only evacuated if it will end up empty.
+void Heap::evacuateBlocks(MarkStack& markStack)
+{
+    // Free lists may hold the dead cells that are about to be moved into.
+    resetAllocationCursors();
+
+    Vector<JSCell*> movedCells;
+    for (size_t i = 0; i < NUM_SIZE_CLASSES; ++i) {
+        CollectorSizeClass& sizeClass = m_heap.sizeClasses[i];
+
+        size_t freeCells = 0;
+        for (size_t block = 0; block < sizeClass.usedBlocks; ++block) {
+            CollectorBlock* collectorBlock = sizeClass.blocks[block];
+            if (!collectorBlock->isEvacuating)
+                freeCells += collectorBlock->endAtom() / collectorBlock->atomsPerCell - collectorBlock->marked.count();
+        }
+        for (size_t block = 0; block < sizeClass.usedBlocks; ++block) {
+            CollectorBlock* collectorBlock = sizeClass.blocks[block];
+            if (!collectorBlock->isEvacuating)
+                continue;
+            size_t liveCells = collectorBlock->marked.count();
+            if (liveCells <= freeCells && canEvacuate(collectorBlock))
+                freeCells -= liveCells;
+            else
+                collectorBlock->isEvacuating = false;
+        }
+
+        size_t destinationBlock = 0;
+        size_t destinationAtom = 0;
+        for (size_t block = 0; block < sizeClass.usedBlocks; ++block) {
+            CollectorBlock* collectorBlock = sizeClass.blocks[block];
+            if (!collectorBlock->isEvacuating)
+                continue;
+            for (size_t atom = 0; atom < collectorBlock->endAtom(); atom += collectorBlock->atomsPerCell) {
+                if (!collectorBlock->marked.get(atom))
+                    continue;
+
+                CollectorBlock* destination;
+                while (true) {
+                    ASSERT(destinationBlock < sizeClass.usedBlocks);
+                    destination = sizeClass.blocks[destinationBlock];
+                    if (!destination->isEvacuating) {
+                        while (destinationAtom < destination->endAtom() && destination->marked.get(destinationAtom))
+                            destinationAtom += destination->atomsPerCell;
+                        if (destinationAtom < destination->endAtom())
+                            break;
+                    }
+                    ++destinationBlock;
+                    destinationAtom = 0;
+                }
+
+                JSCell* from = reinterpret_cast<JSCell*>(collectorBlock->cells + atom);
+                JSCell* to = reinterpret_cast<JSCell*>(destination->cells + destinationAtom);
+                to->~JSCell();
+                memcpy(to, from, collectorBlock->cellSize());
+                destination->marked.set(destinationAtom);
+                destination->immovable.clear(destinationAtom);
+                destinationAtom += destination->atomsPerCell;
+
+                forwardingAddress(from) = to;
+                collectorBlock->marked.clear(atom);
+                movedCells.append(from);
+            }
+        }
+    }
+
+    // The recorded slots may themselves be in cells that have moved.
+    Vector<JSValue*>& slots = markStack.slotsToUpdate();
+    for (size_t i = 0; i < slots.size(); ++i) {
+        JSValue* slot = slots[i];
+        CollectorBlock* slotBlock = cellBlock(reinterpret_cast<JSCell*>(slot));
+        if (m_blocks.contains(slotBlock) && slotBlock->isEvacuating) {
+            JSCell* owner = reinterpret_cast<JSCell*>(slotBlock->cells + (cellOffset(reinterpret_cast<JSCell*>(slot)) & ~(slotBlock->atomsPerCell - 1)));
+            slot = reinterpret_cast<JSValue*>(reinterpret_cast<char*>(forwardingAddress(owner)) + (reinterpret_cast<char*>(slot) - reinterpret_cast<char*>(owner)));
+        }
+        JSValue value = *slot;
+        if (value && value.isCell() && isEvacuating(value.asCell()))
+            *slot = JSValue(forwardingAddress(value.asCell()));
+    }
+    slots.clear();
+
+    // The moved cells now belong to their new locations, so leave nothing
+    // behind for freeing the blocks to destroy.
+    Structure* dummyMarkableCellStructure = m_globalData->dummyMarkableCellStructure.get();
+    for (size_t i = 0; i < movedCells.size(); ++i)
+        new (movedCells[i]) JSCell(dummyMarkableCellStructure);
+
+    for (size_t i = 0; i < NUM_SIZE_CLASSES; ++i) {
+        CollectorSizeClass& sizeClass = m_heap.sizeClasses[i];
+        for (size_t block = 0; block < sizeClass.usedBlocks; ++block)
+            sizeClass.blocks[block]->isEvacuating = false;
+    }
+    m_heap.evacuatingBlocks = 0;
 }
 
 #if OS(WINCE)
@@ -700,30 +1262,19 @@ inline bool isPointerAligned(void* p)
 
 // Cell size needs to be a power of two for isPossibleCell to be valid.
 COMPILE_ASSERT(sizeof(CollectorCell) % 2 == 0, Collector_cell_size_is_power_of_two);
+COMPILE_ASSERT(sizeof(CollectorBlock) <= BLOCK_SIZE, CollectorBlock_fits_in_block);
+COMPILE_ASSERT(1 << ATOM_SHIFT == ATOM_SIZE, ATOM_SHIFT_matches_ATOM_SIZE);
+COMPILE_ASSERT(1 << CARD_SHIFT == CARD_SIZE, CARD_SHIFT_matches_CARD_SIZE);
 
-#if USE(JSVALUE32)
-static bool isHalfCellAligned(void *p)
-{
-    return (((intptr_t)(p) & (CELL_MASK >> 1)) == 0);
-}
-
-static inline bool isPossibleCell(void* p)
-{
-    return isHalfCellAligned(p) && p;
-}
-
-#else
-
-static inline bool isCellAligned(void *p)
+static inline bool isAtomAligned(void *p)
 {
-    return (((intptr_t)(p) & CELL_MASK) == 0);
+    return (((intptr_t)(p) & ATOM_MASK) == 0);
 }
 
 static inline bool isPossibleCell(void* p)
 {
-    return isCellAligned(p) && p;
+    return isAtomAligned(p) && p;
 }
-#endif // USE(JSVALUE32)
 
 void Heap::markConservatively(MarkStack& markStack, void* start, void* end)
 {
@@ -740,27 +1291,26 @@ void Heap::markConservatively(MarkStack& markStack, void* start, void* end)
     char** p = static_cast<char**>(start);
     char** e = static_cast<char**>(end);
 
-    CollectorBlock** blocks = m_heap.blocks;
     while (p != e) {
         char* x = *p++;
         if (isPossibleCell(x)) {
-            size_t usedBlocks;
             uintptr_t xAsBits = reinterpret_cast<uintptr_t>(x);
-            xAsBits &= CELL_ALIGN_MASK;
 
             uintptr_t offset = xAsBits & BLOCK_OFFSET_MASK;
-            const size_t lastCellOffset = sizeof(CollectorCell) * (CELLS_PER_BLOCK - 1);
-            if (offset > lastCellOffset)
+            const size_t lastAtomOffset = sizeof(CollectorCell) * (ATOMS_PER_BLOCK - 1);
+            if (offset > lastAtomOffset)
                 continue;
 
             CollectorBlock* blockAddr = reinterpret_cast<CollectorBlock*>(xAsBits - offset);
-            usedBlocks = m_heap.usedBlocks;
-            for (size_t block = 0; block < usedBlocks; block++) {
-                if (blocks[block] != blockAddr)
-                    continue;
-                markStack.append(reinterpret_cast<JSCell*>(xAsBits));
-                markStack.drain();
-            }
+            if (!blockAddr || !m_blocks.contains(blockAddr))
+                continue;
+
+            // Only the first atom of a cell is a valid cell pointer.
+            size_t atom = offset / ATOM_SIZE;
+            if ((atom & (blockAddr->atomsPerCell - 1)) || atom >= blockAddr->endAtom())
+                continue;
+
+            markStack.append(reinterpret_cast<JSCell*>(xAsBits));
         }
     }
 }
@@ -996,10 +1546,8 @@ bool Heap::unprotect(JSValue k)
 void Heap::markProtectedObjects(MarkStack& markStack)
 {
     ProtectCountSet::iterator end = m_protectedValues.end();
-    for (ProtectCountSet::iterator it = m_protectedValues.begin(); it != end; ++it) {
+    for (ProtectCountSet::iterator it = m_protectedValues.begin(); it != end; ++it)
         markStack.append(it->first);
-        markStack.drain();
-    }
 }
 
 void Heap::pushTempSortVector(Vector<ValueStringPair>* tempVector)
@@ -1025,36 +1573,96 @@ void Heap::markTempSortVectors(MarkStack& markStack)
         for (Vector<ValueStringPair>::iterator vectorIt = tempSortingVector->begin(); vectorIt != vectorEnd; ++vectorIt)
             if (vectorIt->first)
                 markStack.append(vectorIt->first);
-        markStack.drain();
     }
 }
     
 void Heap::clearMarkBits()
 {
-    for (size_t i = 0; i < m_heap.usedBlocks; ++i)
-        clearMarkBits(m_heap.blocks[i]);
+    for (size_t i = 0; i < NUM_SIZE_CLASSES; ++i) {
+        CollectorSizeClass& sizeClass = m_heap.sizeClasses[i];
+        for (size_t block = 0; block < sizeClass.usedBlocks; ++block)
+            clearMarkBits(sizeClass.blocks[block]);
+    }
 }
 
 void Heap::clearMarkBits(CollectorBlock* block)
 {
-    // allocate assumes that the last cell in every block is marked.
-    block->marked.clearAll();
-    block->marked.set(HeapConstants::cellsPerBlock - 1);
+    if (block->isEvacuating)
+        block->pinned.clearAll();
+    block->marking.clearAll();
+    block->young.clearAll();
+    memset(block->cards, 0, sizeof(block->cards));
+}
+
+void Heap::clearNurseryMarkBits()
+{
+    for (size_t i = 0; i < NUM_SIZE_CLASSES; ++i) {
+        CollectorSizeClass& sizeClass = m_heap.sizeClasses[i];
+        for (size_t block = 0; block < sizeClass.usedBlocks; ++block) {
+            CollectorBlock* collectorBlock = sizeClass.blocks[block];
+            for (size_t word = 0; word < BITMAP_WORDS; ++word)
+                collectorBlock->marking.bits[word] = collectorBlock->marked.bits[word] & ~collectorBlock->young.bits[word];
+            collectorBlock->young.clearAll();
+        }
+    }
 }
 
-size_t Heap::markedCells(size_t startBlock, size_t startCell) const
+// Once marking is done, the cells it reached are the live ones.
+void Heap::publishMarkBits()
 {
-    ASSERT(startBlock <= m_heap.usedBlocks);
-    ASSERT(startCell < HeapConstants::cellsPerBlock);
+    for (size_t i = 0; i < NUM_SIZE_CLASSES; ++i) {
+        CollectorSizeClass& sizeClass = m_heap.sizeClasses[i];
+        for (size_t block = 0; block < sizeClass.usedBlocks; ++block)
+            sizeClass.blocks[block]->marked = sizeClass.blocks[block]->marking;
+    }
+}
 
-    if (startBlock >= m_heap.usedBlocks)
-        return 0;
+void Heap::markDirtyCards(MarkStack& markStack)
+{
+    for (size_t i = 0; i < NUM_SIZE_CLASSES; ++i) {
+        CollectorSizeClass& sizeClass = m_heap.sizeClasses[i];
+        for (size_t block = 0; block < sizeClass.usedBlocks; ++block) {
+            CollectorBlock* collectorBlock = sizeClass.blocks[block];
+            size_t endAtom = collectorBlock->endAtom();
+            for (size_t card = 0; card < CARDS_PER_BLOCK; ++card) {
+                if (!collectorBlock->cards[card])
+                    continue;
+                collectorBlock->cards[card] = 0;
+
+                // Cells the collection has not reached yet are traced in full
+                // if they are reached at all.
+                size_t cardEnd = min((card + 1) * ATOMS_PER_CARD, endAtom);
+                for (size_t atom = card * ATOMS_PER_CARD; atom < cardEnd; atom += collectorBlock->atomsPerCell) {
+                    if (collectorBlock->marking.get(atom))
+                        reinterpret_cast<JSCell*>(collectorBlock->cells + atom)->markChildren(markStack);
+                }
+            }
+        }
+    }
+}
+
+void Heap::addNurseryRoot(JSValue value)
+{
+    if (!value || !value.isCell())
+        return;
+    JSCell* cell = value.asCell();
+    if (m_heap.isMarkingIncrementally || cellBlock(cell)->young.get(cellOffset(cell)))
+        m_nurseryRoots.append(cell);
+}
 
+size_t Heap::markedCells(const CollectorSizeClass& sizeClass) const
+{
     size_t result = 0;
-    result += m_heap.blocks[startBlock]->marked.count(startCell);
-    for (size_t i = startBlock + 1; i < m_heap.usedBlocks; ++i)
-        result += m_heap.blocks[i]->marked.count();
+    for (size_t i = 0; i < sizeClass.usedBlocks; ++i)
+        result += sizeClass.blocks[i]->marked.count();
+    return result;
+}
 
+size_t Heap::liveBytes() const
+{
+    size_t result = 0;
+    for (size_t i = 0; i < NUM_SIZE_CLASSES; ++i)
+        result += markedCells(m_heap.sizeClasses[i]) * m_heap.sizeClasses[i].atomsPerCell * ATOM_SIZE;
     return result;
 }
 
@@ -1064,33 +1672,42 @@ void Heap::sweep()
     if (m_heap.operationInProgress != NoOperation)
         CRASH();
     m_heap.operationInProgress = Collection;
-    
+
 #if !ENABLE(JSC_ZOMBIES)
     Structure* dummyMarkableCellStructure = m_globalData->dummyMarkableCellStructure.get();
 #endif
 
-    DeadObjectIterator it(m_heap, m_heap.nextBlock, m_heap.nextCell);
-    DeadObjectIterator end(m_heap, m_heap.usedBlocks);
-    for ( ; it != end; ++it) {
-        JSCell* cell = *it;
+    // Blocks before a size class's allocation cursor have already been swept
+    // since the last collection, so only the rest of each size class can still
+    // hold garbage. Sweeping leaves the cursors and the current free lists alone.
+    for (size_t i = 0; i < NUM_SIZE_CLASSES; ++i) {
+        CollectorSizeClass& sizeClass = m_heap.sizeClasses[i];
+        for (size_t block = sizeClass.nextBlock; block < sizeClass.usedBlocks; ++block) {
+            CollectorBlock* collectorBlock = sizeClass.blocks[block];
+            for (size_t atom = 0; atom < collectorBlock->endAtom(); atom += collectorBlock->atomsPerCell) {
+                if (collectorBlock->marked.get(atom))
+                    continue;
+                JSCell* cell = reinterpret_cast<JSCell*>(collectorBlock->cells + atom);
 #if ENABLE(JSC_ZOMBIES)
-        if (!cell->isZombie()) {
-            const ClassInfo* info = cell->classInfo();
-            cell->~JSCell();
-            new (cell) JSZombie(info, JSZombie::leakedZombieStructure());
-            Heap::markCell(cell);
-        }
+                if (!cell->isZombie()) {
+                    const ClassInfo* info = cell->classInfo();
+                    cell->~JSCell();
+                    new (cell) JSZombie(info, JSZombie::leakedZombieStructure());
+                    Heap::markCell(cell);
+                }
 #else
-        cell->~JSCell();
-        // Callers of sweep assume it's safe to mark any cell in the heap.
-        new (cell) JSCell(dummyMarkableCellStructure);
+                cell->~JSCell();
+                // Callers of sweep assume it's safe to mark any cell in the heap.
+                new (cell) JSCell(dummyMarkableCellStructure);
 #endif
+            }
+        }
     }
 
     m_heap.operationInProgress = NoOperation;
 }
 
-void Heap::markRoots()
+void Heap::markRoots(CollectionType collectionType)
 {
 #ifndef NDEBUG
     if (m_globalData->isSharedInstance()) {
@@ -1107,11 +1724,66 @@ void Heap::markRoots()
 
     MarkStack& markStack = m_globalData->markStack;
 
-    // Reset mark bits.
-    clearMarkBits();
+    // Reset mark bits. A nursery collection keeps the marks of old cells, and
+    // instead treats old cells that may point to young ones as roots. Finishing
+    // an incremental collection keeps what has been marked so far, and looks
+    // again at the cells written since they were marked.
+    bool wasMarkingIncrementally = m_heap.isMarkingIncrementally;
+    bool isEvacuating = collectionType == FullCollection && !wasMarkingIncrementally && m_heap.evacuatingBlocks;
+    markStack.setEvacuating(isEvacuating);
+    if (collectionType == FullCollection && !wasMarkingIncrementally)
+        clearMarkBits();
+    else {
+        if (collectionType == NurseryCollection)
+            clearNurseryMarkBits();
+        markDirtyCards(markStack);
+
+        // The current global object's variables live in the register file, and
+        // are written without a write barrier.
+        m_globalData->interpreter->registerFile().markGlobals(markStack, this);
+
+        for (size_t i = 0; i < m_nurseryRoots.size(); ++i)
+            markStack.append(m_nurseryRoots[i]);
+    }
+    m_nurseryRoots.clear();
 
-    // Mark stack roots.
     markStackObjectsConservatively(markStack);
+    markRootObjects(markStack);
+
+    // Roots only push cells onto the mark stack; tracing what they reach is
+    // left to here, so that it can be spread over several threads.
+    markStack.drainInParallel(m_globalData->numberOfMarkingThreads);
+
+    // Mark the small strings cache last, since it will clear itself if nothing
+    // else has marked it.
+    m_globalData->smallStrings.markChildren(markStack);
+
+    markStack.drain();
+    markStack.compact();
+
+    publishMarkBits();
+    m_heap.isMarkingIncrementally = false;
+
+    if (isEvacuating) {
+        markStack.setEvacuating(false);
+        evacuateBlocks(markStack);
+    }
+
+    m_heap.operationInProgress = NoOperation;
+
+#if VERIFY_NURSERY_COLLECTIONS
+    if (collectionType == NurseryCollection)
+        verifyMarks();
+#endif
+#if VERIFY_INCREMENTAL_MARKING
+    if (wasMarkingIncrementally)
+        verifyMarks();
+#endif
+}
+
+// Marks every root but the machine stacks.
+void Heap::markRootObjects(MarkStack& markStack)
+{
     m_globalData->interpreter->registerFile().markCallFrames(markStack, this);
 
     // Mark explicitly registered roots.
@@ -1129,34 +1801,94 @@ void Heap::markRoots()
         m_globalData->functionCodeBlockBeingReparsed->markAggregate(markStack);
     if (m_globalData->firstStringifierToMark)
         JSONObject::markStringifiers(markStack, m_globalData->firstStringifierToMark);
+}
 
-    // Mark the small strings cache last, since it will clear itself if nothing
-    // else has marked it.
-    m_globalData->smallStrings.markChildren(markStack);
+bool Heap::shouldMarkIncrementally()
+{
+#if ENABLE(JSC_ZOMBIES)
+    return false;
+#else
+    // Nursery collections are short enough to run in one pause.
+    return m_globalData->markingSliceMicroseconds && m_heap.nextCollectionType == FullCollection && !m_heap.isMarkingIncrementally;
+#endif
+}
 
-    markStack.drain();
-    markStack.compact();
+// Starts a full collection whose marking is done a slice at a time, each time
+// the allocator needs a new free list. Cells allocated in the meantime are not
+// marked, and are only kept if the collection reaches them.
+void Heap::startIncrementalMarking()
+{
+    ASSERT(!m_heap.isMarkingIncrementally);
+    ASSERT(m_heap.operationInProgress == NoOperation);
+    if (m_heap.operationInProgress != NoOperation)
+        CRASH();
+
+    JAVASCRIPTCORE_GC_BEGIN();
+
+    m_heap.operationInProgress = Collection;
+
+    clearMarkBits();
+    m_nurseryRoots.clear();
+    markStackObjectsConservatively(m_globalData->markStack);
+    markRootObjects(m_globalData->markStack);
+    m_heap.isMarkingIncrementally = true;
+
+    // Free lists are rebuilt without the dead cells marking has reached.
+    resetAllocationCursors();
+
+    m_heap.operationInProgress = NoOperation;
+
+    markIncrementally();
+}
+
+void Heap::markIncrementally()
+{
+    ASSERT(m_heap.isMarkingIncrementally);
+    ASSERT(m_heap.operationInProgress == NoOperation);
+    if (m_heap.operationInProgress != NoOperation)
+        CRASH();
+
+    m_heap.operationInProgress = Collection;
+
+    MarkStack& markStack = m_globalData->markStack;
+    double deadline = currentTime() + m_globalData->markingSliceMicroseconds / 1000000.0;
+    bool isDone = markStack.drainUntil(deadline);
+    if (isDone && currentTime() < deadline) {
+        // Catch up with the cells written since they were marked, so that
+        // finishing the collection has less left to do.
+        markDirtyCards(markStack);
+        isDone = markStack.drainUntil(deadline);
+    }
 
     m_heap.operationInProgress = NoOperation;
+
+    // The roots have changed since marking started, so finishing takes one
+    // more pause, which marks them again along with any dirty cards.
+    if (isDone)
+        reset();
 }
 
+
 size_t Heap::objectCount() const
 {
-    return m_heap.nextBlock * HeapConstants::cellsPerBlock // allocated full blocks
-           + m_heap.nextCell // allocated cells in current block
-           + markedCells(m_heap.nextBlock, m_heap.nextCell) // marked cells in remainder of m_heap
-           - m_heap.usedBlocks; // 1 cell per block is a dummy sentinel
+    size_t result = 0;
+    for (size_t i = 0; i < NUM_SIZE_CLASSES; ++i)
+        result += markedCells(m_heap.sizeClasses[i]);
+    return result;
 }
 
 void Heap::addToStatistics(Heap::Statistics& statistics) const
 {
     statistics.size += m_heap.usedBlocks * BLOCK_SIZE;
-    statistics.free += m_heap.usedBlocks * BLOCK_SIZE - (objectCount() * HeapConstants::cellSize);
+    statistics.free += m_heap.usedBlocks * BLOCK_SIZE - liveBytes();
+    statistics.sizeLimit += m_heap.growthLimit * BLOCK_SIZE;
+    statistics.extraCost += m_heap.extraCost;
+    statistics.largeStorageSize += m_heap.largeStorageSize;
 }
 
 Heap::Statistics Heap::statistics() const
 {
-    Statistics statistics = { 0, 0 };
+    Statistics statistics = { 0, 0, 0, 0, 0 };
     addToStatistics(statistics);
     return statistics;
 }
@@ -1237,6 +1969,38 @@ HashCountedSet<const char*>* Heap::objectTypeCounts()
     return counts;
 }
 
+#if VERIFY_NURSERY_COLLECTIONS || VERIFY_INCREMENTAL_MARKING
+// Checks that a nursery or incremental collection marked every cell a full
+// collection would. A cell that is only found by the full collection is
+// reachable through a cell whose store was missing a write barrier.
+void Heap::verifyMarks()
+{
+    m_heap.operationInProgress = Collection;
+
+    // The machine stacks are left out: dead frames below the collection being
+    // verified hold stale pointers that it rightly did not see.
+    MarkStack& markStack = m_globalData->markStack;
+    clearMarkBits();
+    markRootObjects(markStack);
+    markStack.drain();
+
+    m_heap.operationInProgress = NoOperation;
+
+    for (size_t i = 0; i < NUM_SIZE_CLASSES; ++i) {
+        CollectorSizeClass& sizeClass = m_heap.sizeClasses[i];
+        for (size_t block = 0; block < sizeClass.usedBlocks; ++block) {
+            CollectorBlock* collectorBlock = sizeClass.blocks[block];
+            for (size_t atom = 0; atom < collectorBlock->endAtom(); atom += collectorBlock->atomsPerCell) {
+                if (collectorBlock->marking.get(atom) && !collectorBlock->marked.get(atom)) {
+                    fprintf(stderr, "Collection missed a live %s\n", typeName(reinterpret_cast<JSCell*>(collectorBlock->cells + atom)));
+                    CRASH();
+                }
+            }
+        }
+    }
+}
+#endif
+
 bool Heap::isBusy()
 {
     return m_heap.operationInProgress != NoOperation;
@@ -1246,18 +2010,17 @@ void Heap::reset()
 {
     JAVASCRIPTCORE_GC_BEGIN();
 
-    markRoots();
+    CollectionType collectionType = m_heap.nextCollectionType;
+    markRoots(collectionType);
 
     JAVASCRIPTCORE_GC_MARKED();
 
-    m_heap.nextCell = 0;
-    m_heap.nextBlock = 0;
-    m_heap.nextNumber = 0;
+    resetAllocationCursors();
     m_heap.extraCost = 0;
 #if ENABLE(JSC_ZOMBIES)
     sweep();
 #endif
-    resizeBlocks();
+    resizeBlocks(collectionType);
 
     JAVASCRIPTCORE_GC_END();
 }
@@ -1272,20 +2035,26 @@ void Heap::collectAllGarbage()
     if (m_heap.didShrink)
         sweep();
 
-    markRoots();
+    markRoots(FullCollection);
 
     JAVASCRIPTCORE_GC_MARKED();
 
-    m_heap.nextCell = 0;
-    m_heap.nextBlock = 0;
-    m_heap.nextNumber = 0;
+    resetAllocationCursors();
     m_heap.extraCost = 0;
     sweep();
-    resizeBlocks();
+    resizeBlocks(FullCollection);
 
     JAVASCRIPTCORE_GC_END();
 }
 
+void Heap::resetAllocationCursors()
+{
+    for (size_t i = 0; i < NUM_SIZE_CLASSES; ++i) {
+        m_heap.sizeClasses[i].freeList = 0;
+        m_heap.sizeClasses[i].nextBlock = 0;
+    }
+}
+
 LiveObjectIterator Heap::primaryHeapBegin()
 {
     return LiveObjectIterator(m_heap, 0);
@@ -1293,7 +2062,7 @@ LiveObjectIterator Heap::primaryHeapBegin()
 
 LiveObjectIterator Heap::primaryHeapEnd()
 {
-    return LiveObjectIterator(m_heap, m_heap.usedBlocks);
+    return LiveObjectIterator(m_heap, NUM_SIZE_CLASSES);
 }
 
 } // namespace JSC
@@ -40,11 +40,12 @@
 #include <wtf/symbian/BlockAllocatorSymbian.h>
 #endif
 
-#define ASSERT_CLASS_FITS_IN_CELL(class) COMPILE_ASSERT(sizeof(class) <= CELL_SIZE, class_fits_in_cell)
+#define ASSERT_CLASS_FITS_IN_CELL(class) COMPILE_ASSERT(sizeof(class) <= LARGE_CELL_SIZE, class_fits_in_cell)
 
 namespace JSC {
 
     class CollectorBlock;
+    struct CollectorCell;
     class JSCell;
     class JSGlobalData;
     class JSValue;
@@ -53,21 +54,57 @@ namespace JSC {
 
     enum OperationInProgress { NoOperation, Allocation, Collection };
 
+    // A nursery collection only marks cells allocated since the last collection,
+    // starting from the roots and from old cells in dirty cards. Cells that
+    // survive it are old, and are only reclaimed by a full collection.
+    enum CollectionType { NurseryCollection, FullCollection };
+
     class LiveObjectIterator;
 
-    struct CollectorHeap {
+    // Cells are allocated from a small number of power-of-two size classes.
+    // Each size class owns its own list of blocks. Blocks are swept lazily, one
+    // at a time, into the size class's free list; nextBlock is the next block
+    // to sweep.
+    struct CollectorSizeClass {
+        size_t atomsPerCell;
+
+        CollectorCell* freeList;
         size_t nextBlock;
-        size_t nextCell;
         CollectorBlock** blocks;
-        
-        void* nextNumber;
 
         size_t numBlocks;
         size_t usedBlocks;
+    };
+
+    const size_t NUM_SIZE_CLASSES = 4;
+
+    // Decides how far the heap may grow before the next collection, trading
+    // memory for fewer collections.
+    struct HeapSizingPolicy {
+        HeapSizingPolicy();
+
+        double targetLiveRatio; // Fraction of the heap that should be live after a collection, in (0, 1].
+        size_t minHeapSize; // Bytes the heap may grow to however little is live.
+        size_t maxHeapSize; // Bytes past which the heap only grows by the minimum; 0 for no cap.
+        size_t extraMemoryBudget; // Bytes of reportExtraMemoryCost() between collections that may force one.
+        double evacuationThreshold; // Fraction of a block below which its live cells are moved out when the heap is over its size; 0 never moves cells.
+    };
+
+    struct CollectorHeap {
+        CollectorSizeClass sizeClasses[NUM_SIZE_CLASSES];
+
+        size_t usedBlocks; // Total, across all size classes.
+        size_t growthLimit; // Block count the heap may grow to before an exhausted size class triggers a collection.
 
         size_t extraCost;
         bool didShrink;
 
+        size_t fullCollectionThreshold; // Live bytes beyond which a nursery collection is not worth trying.
+        CollectionType nextCollectionType;
+        bool isMarkingIncrementally; // A full collection is marking in slices between allocations.
+        size_t evacuatingBlocks; // Blocks the next stop-the-world full collection will try to empty.
+        size_t largeStorageSize; // Bytes mapped for large storage in use.
+
         OperationInProgress operationInProgress;
     };
 
@@ -77,7 +114,6 @@ namespace JSC {
 
         void destroy();
 
-        void* allocateNumber(size_t);
         void* allocate(size_t);
 
         bool isBusy(); // true if an allocation or collection is in progress
@@ -88,10 +124,25 @@ namespace JSC {
 
         void reportExtraMemoryCost(size_t cost);
 
+        // Buffers owned by cells that are too big for FastMalloc to place well,
+        // such as the vectors of large arrays, are mapped in whole pages by the
+        // heap itself. Freeing one hands its pages back to the system at once.
+        // Owners still report the cost of their buffers as extra memory.
+        static const size_t minLargeStorageSize = 16 * 1024;
+        void* tryAllocateLargeStorage(size_t);
+        void* tryReallocateLargeStorage(void*, size_t); // Leaves the buffer alone on failure.
+        void freeLargeStorage(void*);
+
+        const HeapSizingPolicy& sizingPolicy() const { return m_sizingPolicy; }
+        void setSizingPolicy(const HeapSizingPolicy&);
+
         size_t objectCount() const;
         struct Statistics {
             size_t size;
             size_t free;
+            size_t sizeLimit; // Bytes the heap may grow to before the next collection.
+            size_t extraCost; // Bytes of extra memory reported since the last collection.
+            size_t largeStorageSize; // Bytes mapped for large storage in use.
         };
         Statistics statistics() const;
 
@@ -113,6 +164,28 @@ namespace JSC {
 
         static bool isCellMarked(const JSCell*);
         static void markCell(JSCell*);
+        // For use while marking: whether the collection in progress has reached the cell.
+        static bool isCellMarkedByCollection(const JSCell*);
+        static bool testAndSetMarked(const JSCell*); // Returns whether the cell was already marked by the collection.
+
+        // Must be called whenever a cell may have been stored into another cell, so
+        // the next nursery collection finds the new reference if the owner is old.
+        static void writeBarrier(const JSCell* owner);
+        static void writeBarrier(const JSCell* owner, JSValue);
+        static uint32_t* addressOfCard(const JSCell*);
+        // For references to cells held outside the heap by memory that is only
+        // reachable through other cells, such as CodeBlock constants.
+        void addNurseryRoot(JSValue);
+
+        // Keeps a cell at its address for as long as it lives. Needed wherever
+        // the address is kept somewhere marking does not reach, or cannot
+        // update, such as the prototype of a Structure.
+        static void pinCell(const JSCell*);
+        // For use while marking a collection that evacuates blocks: whether the
+        // cell may be moved, and keeping it in place because of a reference
+        // marking cannot update.
+        static bool isEvacuating(const JSCell*);
+        static void pinForCollection(const JSCell*);
 
         void markConservatively(MarkStack&, void* start, void* end);
 
@@ -123,36 +196,58 @@ namespace JSC {
 
         JSGlobalData* globalData() const { return m_globalData; }
         static bool isNumber(JSCell*);
+
+        // The size of the cell that an allocation of the given size gets.
+        static size_t cellSizeFor(size_t);
         
         LiveObjectIterator primaryHeapBegin();
         LiveObjectIterator primaryHeapEnd();
 
     private:
         void reset();
+        void resetAllocationCursors();
         void sweep();
         static CollectorBlock* cellBlock(const JSCell*);
         static size_t cellOffset(const JSCell*);
+        static size_t sizeClassFor(size_t);
 
         friend class JSGlobalData;
         Heap(JSGlobalData*);
         ~Heap();
 
-        NEVER_INLINE CollectorBlock* allocateBlock();
-        NEVER_INLINE void freeBlock(size_t);
+        NEVER_INLINE CollectorBlock* allocateBlock(CollectorSizeClass&);
+        NEVER_INLINE CollectorBlock* allocateBlockPtr();
+        NEVER_INLINE void freeBlock(CollectorSizeClass&, size_t);
         NEVER_INLINE void freeBlockPtr(CollectorBlock*);
+        CollectorBlock* takeFreeBlock();
+        void releaseBlock(CollectorBlock*);
         void freeBlocks();
-        void resizeBlocks();
-        void growBlocks(size_t neededBlocks);
+        void freeUnusedLargeStorage();
+        size_t heapSizeLimit(size_t liveBytes) const;
+        void resizeBlocks(CollectionType);
         void shrinkBlocks(size_t neededBlocks);
         void clearMarkBits();
         void clearMarkBits(CollectorBlock*);
-        size_t markedCells(size_t startBlock = 0, size_t startCell = 0) const;
+        void clearNurseryMarkBits();
+        void publishMarkBits();
+        void markDirtyCards(MarkStack&);
+        void buildFreeList(CollectorSizeClass&, CollectorBlock*);
+        void chooseBlocksToEvacuate(size_t maxBlocks);
+        void evacuateBlocks(MarkStack&);
+        bool canEvacuate(CollectorBlock*);
+        size_t markedCells(const CollectorSizeClass&) const;
+        size_t liveBytes() const;
 
         void recordExtraCost(size_t);
 
         void addToStatistics(Statistics&) const;
 
-        void markRoots();
+        void markRoots(CollectionType);
+        void markRootObjects(MarkStack&);
+        bool shouldMarkIncrementally();
+        void startIncrementalMarking();
+        void markIncrementally();
+        void verifyMarks();
         void markProtectedObjects(MarkStack&);
         void markTempSortVectors(MarkStack&);
         void markCurrentThreadConservatively(MarkStack&);
@@ -163,12 +258,22 @@ namespace JSC {
         typedef HashCountedSet<JSCell*> ProtectCountSet;
 
         CollectorHeap m_heap;
+        HeapSizingPolicy m_sizingPolicy;
+        HashSet<CollectorBlock*> m_blocks;
+        WTF::Vector<JSCell*> m_nurseryRoots;
 
         ProtectCountSet m_protectedValues;
         WTF::Vector<WTF::Vector<ValueStringPair>* > m_tempSortingVectors;
 
         HashSet<MarkedArgumentBuffer*>* m_markListSet;
 
+        struct LargeStorageMapping {
+            void* base;
+            size_t size;
+        };
+        // Freed mappings whose pages have been given back, kept for reuse.
+        WTF::Vector<LargeStorageMapping> m_unusedLargeStorage;
+
 #if ENABLE(JSC_MULTIPLE_THREADS)
         void makeUsableFromMultipleThreads();
 
@@ -180,6 +285,20 @@ namespace JSC {
         pthread_key_t m_currentThreadRegistrar;
 #endif
 
+#if ENABLE(BLOCK_FREEING_THREAD)
+        static void* blockFreeingThreadStartFunc(void*);
+        void blockFreeingThreadMain();
+
+        // Blocks freed by the collector, kept around for reuse until the block
+        // freeing thread returns them to the system.
+        Mutex m_freeBlockLock;
+        ThreadCondition m_freeBlockCondition;
+        WTF::Vector<CollectorBlock*> m_freeBlocks;
+        bool m_isTakingFreeBlocks;
+        bool m_blockFreeingThreadShouldQuit;
+        ThreadIdentifier m_blockFreeingThread;
+#endif
+
 #if OS(SYMBIAN)
         // Allocates collector blocks with correct alignment
         WTF::AlignedBlockAllocator m_blockallocator; 
@@ -208,17 +327,59 @@ namespace JSC {
     const size_t CELL_ARRAY_LENGTH = (MINIMUM_CELL_SIZE / sizeof(double)) + (MINIMUM_CELL_SIZE % sizeof(double) != 0 ? sizeof(double) : 0);
     const size_t CELL_SIZE = CELL_ARRAY_LENGTH * sizeof(double);
     const size_t SMALL_CELL_SIZE = CELL_SIZE / 2;
-    const size_t CELL_MASK = CELL_SIZE - 1;
-    const size_t CELL_ALIGN_MASK = ~CELL_MASK;
-    const size_t CELLS_PER_BLOCK = (BLOCK_SIZE - sizeof(Heap*)) * 8 * CELL_SIZE / (8 * CELL_SIZE + 1) / CELL_SIZE; // one bitmap byte can represent 8 cells.
+    const size_t LARGE_CELL_SIZE = SMALL_CELL_SIZE << (NUM_SIZE_CLASSES - 1);
+
+    // Blocks are divided into atoms of the smallest cell size. A cell of a larger
+    // size class spans several atoms, but only its first atom's mark bit is used,
+    // so a cell's mark bit can be found from its address alone. Allocating a cell
+    // also sets its mark bit, so the mark bits tell exactly which cells are live.
+    // A collection marks the cells it reaches in a separate bitmap, which only
+    // replaces the mark bits once marking is done, so that the mark bits stay
+    // valid while an incremental collection is marking.
+    const size_t ATOM_SIZE = SMALL_CELL_SIZE;
+    const size_t ATOM_SHIFT = ATOM_SIZE == 32 ? 5 : 4;
+    const size_t ATOM_MASK = ATOM_SIZE - 1;
+    const size_t ATOM_ALIGN_MASK = ~ATOM_MASK;
+
+    // The write barrier dirties the card holding the start of the owner cell,
+    // unless the owner is young and will be traced in full anyway. Nothing is
+    // young while marking incrementally, so every store into a cell the marking
+    // may already have passed is found again before marking finishes.
+    const size_t CARD_SIZE = 1024;
+    const size_t CARD_SHIFT = 10;
+    const size_t CARDS_PER_BLOCK = BLOCK_SIZE / CARD_SIZE;
+    const size_t ATOMS_PER_CARD = CARD_SIZE / ATOM_SIZE;
+
+    const size_t ATOMS_PER_BLOCK = (BLOCK_SIZE - CARDS_PER_BLOCK * sizeof(uint32_t) - sizeof(Heap*) - 2 * sizeof(size_t) - 5 * sizeof(uint32_t)) * 8 * ATOM_SIZE / (8 * ATOM_SIZE + 5) / ATOM_SIZE; // five bitmap bytes can represent 8 atoms; each bitmap may round up by a word.
     
-    const size_t BITMAP_SIZE = (CELLS_PER_BLOCK + 7) / 8;
+    const size_t BITMAP_SIZE = (ATOMS_PER_BLOCK + 7) / 8;
     const size_t BITMAP_WORDS = (BITMAP_SIZE + 3) / sizeof(uint32_t);
 
     struct CollectorBitmap {
         uint32_t bits[BITMAP_WORDS];
         bool get(size_t n) const { return !!(bits[n >> 5] & (1 << (n & 0x1F))); } 
         void set(size_t n) { bits[n >> 5] |= (1 << (n & 0x1F)); } 
+        // Returns whether the bit was already set. Safe to race with other
+        // threads setting bits in the same word.
+        bool testAndSet(size_t n)
+        {
+            uint32_t mask = 1 << (n & 0x1F);
+#if ENABLE(PARALLEL_GC)
+            volatile uint32_t* word = &bits[n >> 5];
+            while (true) {
+                uint32_t oldValue = *word;
+                if (oldValue & mask)
+                    return true;
+                if (WTF::weakCompareAndSwap(reinterpret_cast<volatile unsigned*>(word), oldValue, oldValue | mask))
+                    return false;
+            }
+#else
+            if (bits[n >> 5] & mask)
+                return true;
+            bits[n >> 5] |= mask;
+            return false;
+#endif
+        }
         void clear(size_t n) { bits[n >> 5] &= ~(1 << (n & 0x1F)); } 
         void clearAll() { memset(bits, 0, sizeof(bits)); }
         size_t count(size_t startCell = 0)
@@ -242,21 +403,25 @@ namespace JSC {
     };
   
     struct CollectorCell {
-        double memory[CELL_ARRAY_LENGTH];
+        double memory[ATOM_SIZE / sizeof(double)];
     };
 
     class CollectorBlock {
     public:
-        CollectorCell cells[CELLS_PER_BLOCK];
+        CollectorCell cells[ATOMS_PER_BLOCK];
         CollectorBitmap marked;
+        CollectorBitmap marking; // Cells reached by the collection in progress.
+        CollectorBitmap young; // Cells allocated since the last collection, outside of incremental marking.
+        CollectorBitmap pinned; // Cells the collection in progress found a reference to that it cannot update.
+        CollectorBitmap immovable; // Cells pinned for as long as they live.
+        uint32_t cards[CARDS_PER_BLOCK]; // Non-zero if a cell starting in the card may have been written since the collection last looked at it.
         Heap* heap;
-    };
+        size_t atomsPerCell;
+        bool isEvacuating; // Not allocated into; the next stop-the-world full collection moves its live cells out if it can.
 
-    struct HeapConstants {
-        static const size_t cellSize = CELL_SIZE;
-        static const size_t cellsPerBlock = CELLS_PER_BLOCK;
-        typedef CollectorCell Cell;
-        typedef CollectorBlock Block;
+        size_t cellSize() const { return atomsPerCell * ATOM_SIZE; }
+        // Atoms at or beyond endAtom() are too few to hold another whole cell.
+        size_t endAtom() const { return ATOMS_PER_BLOCK - ATOMS_PER_BLOCK % atomsPerCell; }
     };
 
     inline CollectorBlock* Heap::cellBlock(const JSCell* cell)
@@ -266,7 +431,7 @@ namespace JSC {
 
     inline size_t Heap::cellOffset(const JSCell* cell)
     {
-        return (reinterpret_cast<uintptr_t>(cell) & BLOCK_OFFSET_MASK) / CELL_SIZE;
+        return (reinterpret_cast<uintptr_t>(cell) & BLOCK_OFFSET_MASK) / ATOM_SIZE;
     }
 
     inline bool Heap::isCellMarked(const JSCell* cell)
@@ -279,22 +444,46 @@ namespace JSC {
         cellBlock(cell)->marked.set(cellOffset(cell));
     }
 
-    inline void Heap::reportExtraMemoryCost(size_t cost)
+    inline bool Heap::isCellMarkedByCollection(const JSCell* cell)
     {
-        if (cost > minExtraCost) 
-            recordExtraCost(cost);
+        return cellBlock(cell)->marking.get(cellOffset(cell));
     }
-    
-    inline void* Heap::allocateNumber(size_t s)
+
+    inline bool Heap::testAndSetMarked(const JSCell* cell)
     {
-        if (void* result = m_heap.nextNumber) {
-            m_heap.nextNumber = 0;
-            return result;
-        }
+        return cellBlock(cell)->marking.testAndSet(cellOffset(cell));
+    }
+
+    inline void Heap::pinCell(const JSCell* cell)
+    {
+        cellBlock(cell)->immovable.set(cellOffset(cell));
+    }
+
+    inline bool Heap::isEvacuating(const JSCell* cell)
+    {
+        return cellBlock(cell)->isEvacuating;
+    }
 
-        void* result = allocate(s);
-        m_heap.nextNumber = static_cast<char*>(result) + (CELL_SIZE / 2);
-        return result;
+    inline void Heap::pinForCollection(const JSCell* cell)
+    {
+        cellBlock(cell)->pinned.testAndSet(cellOffset(cell));
+    }
+
+    inline uint32_t* Heap::addressOfCard(const JSCell* cell)
+    {
+        return &cellBlock(cell)->cards[(reinterpret_cast<uintptr_t>(cell) & BLOCK_OFFSET_MASK) >> CARD_SHIFT];
+    }
+
+    inline void Heap::writeBarrier(const JSCell* owner)
+    {
+        if (!cellBlock(owner)->young.get(cellOffset(owner)))
+            *addressOfCard(owner) = 1;
+    }
+
+    inline void Heap::reportExtraMemoryCost(size_t cost)
+    {
+        if (cost > minExtraCost) 
+            recordExtraCost(cost);
     }
 
 } // namespace JSC
@@ -31,107 +31,125 @@
 
 namespace JSC {
 
+    // Iterators walk every size class in turn. A cell counts as live if it has
+    // been marked, either by the last collection or by being allocated since.
     class CollectorHeapIterator {
     public:
         bool operator!=(const CollectorHeapIterator& other);
         JSCell* operator*() const;
     
     protected:
-        CollectorHeapIterator(CollectorHeap&, size_t startBlock, size_t startCell);
-        void advance(size_t max);
+        CollectorHeapIterator(CollectorHeap&, size_t startSizeClass);
+        void advance();
+        void skipEmptySizeClasses();
+        bool atEnd() const { return m_sizeClass == NUM_SIZE_CLASSES; }
+        bool isLive() const;
 
         CollectorHeap& m_heap;
+        size_t m_sizeClass;
         size_t m_block;
         size_t m_cell;
     };
 
     class LiveObjectIterator : public CollectorHeapIterator {
     public:
-        LiveObjectIterator(CollectorHeap&, size_t startBlock, size_t startCell = 0);
+        LiveObjectIterator(CollectorHeap&, size_t startSizeClass);
         LiveObjectIterator& operator++();
     };
 
     class DeadObjectIterator : public CollectorHeapIterator {
     public:
-        DeadObjectIterator(CollectorHeap&, size_t startBlock, size_t startCell = 0);
+        DeadObjectIterator(CollectorHeap&, size_t startSizeClass);
         DeadObjectIterator& operator++();
     };
 
     class ObjectIterator : public CollectorHeapIterator {
     public:
-        ObjectIterator(CollectorHeap&, size_t startBlock, size_t startCell = 0);
+        ObjectIterator(CollectorHeap&, size_t startSizeClass);
         ObjectIterator& operator++();
     };
 
-    inline CollectorHeapIterator::CollectorHeapIterator(CollectorHeap& heap, size_t startBlock, size_t startCell)
+    inline CollectorHeapIterator::CollectorHeapIterator(CollectorHeap& heap, size_t startSizeClass)
         : m_heap(heap)
-        , m_block(startBlock)
-        , m_cell(startCell)
+        , m_sizeClass(startSizeClass)
+        , m_block(0)
+        , m_cell(0)
     {
+        skipEmptySizeClasses();
     }
 
     inline bool CollectorHeapIterator::operator!=(const CollectorHeapIterator& other)
     {
-        return m_block != other.m_block || m_cell != other.m_cell;
+        return m_sizeClass != other.m_sizeClass || m_block != other.m_block || m_cell != other.m_cell;
     }
 
     inline JSCell* CollectorHeapIterator::operator*() const
     {
-        return reinterpret_cast<JSCell*>(m_heap.blocks[m_block]->cells + m_cell);
+        return reinterpret_cast<JSCell*>(m_heap.sizeClasses[m_sizeClass].blocks[m_block]->cells + m_cell);
     }
-    
-    // Iterators advance up to the next-to-last -- and not the last -- cell in a
-    // block, since the last cell is a dummy sentinel.
-    inline void CollectorHeapIterator::advance(size_t max)
+
+    inline void CollectorHeapIterator::skipEmptySizeClasses()
+    {
+        while (m_sizeClass < NUM_SIZE_CLASSES && m_block == m_heap.sizeClasses[m_sizeClass].usedBlocks) {
+            ++m_sizeClass;
+            m_block = 0;
+        }
+    }
+
+    inline void CollectorHeapIterator::advance()
     {
-        ++m_cell;
-        if (m_cell == max) {
+        CollectorBlock* block = m_heap.sizeClasses[m_sizeClass].blocks[m_block];
+        m_cell += block->atomsPerCell;
+        if (m_cell == block->endAtom()) {
             m_cell = 0;
             ++m_block;
+            skipEmptySizeClasses();
         }
     }
 
-    inline LiveObjectIterator::LiveObjectIterator(CollectorHeap& heap, size_t startBlock, size_t startCell)
-        : CollectorHeapIterator(heap, startBlock, startCell - 1)
+    inline bool CollectorHeapIterator::isLive() const
     {
-        ++(*this);
+        return m_heap.sizeClasses[m_sizeClass].blocks[m_block]->marked.get(m_cell);
     }
 
-    inline LiveObjectIterator& LiveObjectIterator::operator++()
+    inline LiveObjectIterator::LiveObjectIterator(CollectorHeap& heap, size_t startSizeClass)
+        : CollectorHeapIterator(heap, startSizeClass)
     {
-        advance(HeapConstants::cellsPerBlock - 1);
-        if (m_block < m_heap.nextBlock || (m_block == m_heap.nextBlock && m_cell < m_heap.nextCell))
-            return *this;
+        if (!atEnd() && !isLive())
+            ++(*this);
+    }
 
-        while (m_block < m_heap.usedBlocks && !m_heap.blocks[m_block]->marked.get(m_cell))
-            advance(HeapConstants::cellsPerBlock - 1);
+    inline LiveObjectIterator& LiveObjectIterator::operator++()
+    {
+        do {
+            advance();
+        } while (!atEnd() && !isLive());
         return *this;
     }
 
-    inline DeadObjectIterator::DeadObjectIterator(CollectorHeap& heap, size_t startBlock, size_t startCell)
-        : CollectorHeapIterator(heap, startBlock, startCell - 1)
+    inline DeadObjectIterator::DeadObjectIterator(CollectorHeap& heap, size_t startSizeClass)
+        : CollectorHeapIterator(heap, startSizeClass)
     {
-        ++(*this);
+        if (!atEnd() && isLive())
+            ++(*this);
     }
 
     inline DeadObjectIterator& DeadObjectIterator::operator++()
     {
         do {
-            advance(HeapConstants::cellsPerBlock - 1);
-            ASSERT(m_block > m_heap.nextBlock || (m_block == m_heap.nextBlock && m_cell >= m_heap.nextCell));
-        } while (m_block < m_heap.usedBlocks && m_heap.blocks[m_block]->marked.get(m_cell));
+            advance();
+        } while (!atEnd() && isLive());
         return *this;
     }
 
-    inline ObjectIterator::ObjectIterator(CollectorHeap& heap, size_t startBlock, size_t startCell)
-        : CollectorHeapIterator(heap, startBlock, startCell - 1)
+    inline ObjectIterator::ObjectIterator(CollectorHeap& heap, size_t startSizeClass)
+        : CollectorHeapIterator(heap, startSizeClass)
     {
-        ++(*this);
     }
 
     inline ObjectIterator& ObjectIterator::operator++()
     {
-        advance(HeapConstants::cellsPerBlock - 1);
+        advance();
         return *this;
     }
 
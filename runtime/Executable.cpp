@@ -26,6 +26,7 @@
 #include "config.h"
 #include "Executable.h"
 
+#include "BytecodeCache.h"
 #include "BytecodeGenerator.h"
 #include "CodeBlock.h"
 #include "JIT.h"
@@ -58,6 +59,9 @@ ProgramExecutable::~ProgramExecutable()
 FunctionExecutable::~FunctionExecutable()
 {
     delete m_codeBlock;
+#if ENABLE(JIT_OPTIMIZING_TIER)
+    delete m_optimizedCodeBlock;
+#endif
 }
 
 JSObject* EvalExecutable::compile(ExecState* exec, ScopeChainNode* scopeChainNode)
@@ -115,24 +119,43 @@ JSObject* ProgramExecutable::compile(ExecState* exec, ScopeChainNode* scopeChain
 void FunctionExecutable::compile(ExecState*, ScopeChainNode* scopeChainNode)
 {
     JSGlobalData* globalData = scopeChainNode->globalData;
-    RefPtr<FunctionBodyNode> body = globalData->parser->parse<FunctionBodyNode>(globalData, 0, 0, m_source);
-    if (m_forceUsesArguments)
-        body->setUsesArguments();
-    body->finishParsing(m_parameters, m_name);
-    recordParse(body->features(), body->lineNo(), body->lastLine());
-
     ScopeChain scopeChain(scopeChainNode);
     JSGlobalObject* globalObject = scopeChain.globalObject();
 
+    // Code compiled for the debugger or the profiler carries hooks that the cache does not.
+    BytecodeCache* bytecodeCache = globalObject->debugger() || globalObject->supportsProfiling() ? 0 : globalData->bytecodeCache.get();
+
     ASSERT(!m_codeBlock);
-    m_codeBlock = new FunctionCodeBlock(this, FunctionCode, source().provider(), source().startOffset());
-    OwnPtr<BytecodeGenerator> generator(new BytecodeGenerator(body.get(), globalObject->debugger(), scopeChain, m_codeBlock->symbolTable(), m_codeBlock));
-    generator->generate();
-    m_numParameters = m_codeBlock->m_numParameters;
+    if (bytecodeCache)
+        m_codeBlock = bytecodeCache->load(this, scopeChain);
+    if (!m_codeBlock) {
+        RefPtr<FunctionBodyNode> body = globalData->parser->parse<FunctionBodyNode>(globalData, 0, 0, m_source);
+        if (m_forceUsesArguments)
+            body->setUsesArguments();
+        body->finishParsing(m_parameters, m_name);
+        recordParse(body->features(), body->lineNo(), body->lastLine());
+
+        m_codeBlock = new FunctionCodeBlock(this, FunctionCode, source().provider(), source().startOffset());
+        OwnPtr<BytecodeGenerator> generator(new BytecodeGenerator(body.get(), globalObject->debugger(), scopeChain, m_codeBlock->symbolTable(), m_codeBlock));
+        Vector<ScopedPropertyLookup> scopedPropertyLookups;
+        if (bytecodeCache)
+            generator->recordScopedPropertyLookups(&scopedPropertyLookups);
+        generator->generate();
+        if (bytecodeCache)
+            bytecodeCache->store(this, scopeChain, scopedPropertyLookups);
+
+        body->destroyData();
+    }
+#if ENABLE(INTERPRETER_OSR)
+    // JIT code takes a positive m_numParameters to mean the function has been
+    // compiled, so a function warming up in the interpreter leaves it unset.
+    if (globalData->canUseJIT())
+        m_codeBlock->jitAfter(globalData->interpreterFunctionThreshold);
+    if (!globalData->canUseJIT() || !globalData->interpreterFunctionThreshold)
+#endif
+        m_numParameters = m_codeBlock->m_numParameters;
     ASSERT(m_numParameters);
     m_numVariables = m_codeBlock->m_numVars;
-
-    body->destroyData();
 }
 
 #if ENABLE(JIT)
@@ -144,6 +167,7 @@ void EvalExecutable::generateJITCode(ExecState* exec, ScopeChainNode* scopeChain
 #endif
     CodeBlock* codeBlock = &bytecode(exec, scopeChainNode);
     m_jitCode = JIT::compile(scopeChainNode->globalData, codeBlock);
+    codeBlock->setJITCode(m_jitCode);
 
 #if !ENABLE(OPCODE_SAMPLING)
     if (!BytecodeGenerator::dumpsGeneratedCode())
@@ -158,6 +182,7 @@ void ProgramExecutable::generateJITCode(ExecState* exec, ScopeChainNode* scopeCh
 #endif
     CodeBlock* codeBlock = &bytecode(exec, scopeChainNode);
     m_jitCode = JIT::compile(scopeChainNode->globalData, codeBlock);
+    codeBlock->setJITCode(m_jitCode);
 
 #if !ENABLE(OPCODE_SAMPLING)
     if (!BytecodeGenerator::dumpsGeneratedCode())
@@ -172,6 +197,20 @@ void FunctionExecutable::generateJITCode(ExecState* exec, ScopeChainNode* scopeC
 #endif
     CodeBlock* codeBlock = &bytecode(exec, scopeChainNode);
     m_jitCode = JIT::compile(scopeChainNode->globalData, codeBlock);
+    codeBlock->setJITCode(m_jitCode);
+    m_numParameters = codeBlock->m_numParameters;
+#if ENABLE(JIT_OPTIMIZING_TIER)
+    if (scopeChainNode->globalData->optimizationThreshold)
+        codeBlock->optimizeAfter(scopeChainNode->globalData->optimizationThreshold);
+    else
+        codeBlock->optimizeNever();
+#endif
+
+#if ENABLE(INTERPRETER_OSR)
+    // Interpreter frames further up the stack may still be running the bytecode.
+    if (scopeChainNode->globalData->interpreterFunctionThreshold)
+        return;
+#endif
 
 #if !ENABLE(OPCODE_SAMPLING)
     if (!BytecodeGenerator::dumpsGeneratedCode())
@@ -179,12 +218,108 @@ void FunctionExecutable::generateJITCode(ExecState* exec, ScopeChainNode* scopeC
 #endif
 }
 
+#if ENABLE(JIT_OPTIMIZE_CALL)
+void FunctionExecutable::unlinkCallers()
+{
+    if (m_codeBlock)
+        m_codeBlock->unlinkCallers();
+#if ENABLE(JIT_OPTIMIZING_TIER)
+    if (m_optimizedCodeBlock)
+        m_optimizedCodeBlock->unlinkCallers();
+#endif
+}
+#endif
+
+#if ENABLE(JIT_OPTIMIZING_TIER)
+CodeBlock* FunctionExecutable::optimize(JSGlobalData* globalData, ScopeChainNode* scopeChainNode)
+{
+    ASSERT(m_codeBlock);
+    if (m_optimizationDisabled)
+        return 0;
+
+    if (m_optimizedCodeBlock) {
+        if (m_codeBlock->speculationFailures() >= globalData->speculationFailureLimit) {
+            jettisonOptimizedCode();
+            return 0;
+        }
+        return m_optimizedCodeBlock;
+    }
+
+    ScopeChain scopeChain(scopeChainNode);
+    JSGlobalObject* globalObject = scopeChain.globalObject();
+    if (globalObject->debugger()) {
+        m_optimizationDisabled = true;
+        return 0;
+    }
+
+    RefPtr<FunctionBodyNode> body = globalData->parser->parse<FunctionBodyNode>(globalData, 0, 0, m_source);
+    if (!body) {
+        m_optimizationDisabled = true;
+        return 0;
+    }
+    if (m_forceUsesArguments)
+        body->setUsesArguments();
+    body->finishParsing(m_parameters, m_name);
+
+    // The baseline bytecode has been discarded, so the optimizing tier works from a
+    // second copy. Regenerating it the way exception info is regenerated guarantees
+    // the same bytecode, so bytecode offsets agree between the two tiers, and keeps
+    // the exception info that the baseline CodeBlock throws away.
+    CodeBlock* codeBlock = new FunctionCodeBlock(this, FunctionCode, source().provider(), source().startOffset());
+    globalData->functionCodeBlockBeingReparsed = codeBlock;
+
+    OwnPtr<BytecodeGenerator> generator(new BytecodeGenerator(body.get(), 0, scopeChain, codeBlock->symbolTable(), codeBlock));
+    generator->setRegeneratingForExceptionInfo(static_cast<FunctionCodeBlock*>(m_codeBlock));
+    generator->generate();
+    codeBlock->computeCallSiteLiveness();
+    body->destroyData();
+
+    ASSERT(codeBlock->m_numCalleeRegisters == m_codeBlock->m_numCalleeRegisters);
+    JITCode code = JIT::compileOptimized(globalData, codeBlock, m_codeBlock);
+    globalData->functionCodeBlockBeingReparsed = 0;
+    if (!code) {
+        delete codeBlock;
+        m_optimizationDisabled = true;
+        return 0;
+    }
+    codeBlock->setJITCode(code);
+
+#if !ENABLE(OPCODE_SAMPLING)
+    if (!BytecodeGenerator::dumpsGeneratedCode())
+        codeBlock->discardBytecode();
+#endif
+
+    m_optimizedCodeBlock = codeBlock;
+#if ENABLE(JIT_OPTIMIZE_CALL)
+    m_codeBlock->unlinkCallers();
+#endif
+    m_jitCode = code;
+    return codeBlock;
+}
+
+void FunctionExecutable::jettisonOptimizedCode()
+{
+    ASSERT(m_optimizedCodeBlock);
+    // Frames may still be running the optimized code, so it lives on until the
+    // executable does; only new calls are sent back to the baseline code.
+#if ENABLE(JIT_OPTIMIZE_CALL)
+    m_optimizedCodeBlock->unlinkCallers();
+#endif
+    m_jitCode = m_codeBlock->getJITCode();
+    m_optimizationDisabled = true;
+}
+#endif
+
 #endif
 
 void FunctionExecutable::markAggregate(MarkStack& markStack)
 {
     if (m_codeBlock)
         m_codeBlock->markAggregate(markStack);
+#if ENABLE(JIT_OPTIMIZING_TIER)
+    if (m_optimizedCodeBlock)
+        m_optimizedCodeBlock->markAggregate(markStack);
+#endif
 }
 
 ExceptionInfo* FunctionExecutable::reparseExceptionInfo(JSGlobalData* globalData, ScopeChainNode* scopeChainNode, CodeBlock* codeBlock)
@@ -208,11 +343,13 @@ ExceptionInfo* FunctionExecutable::reparseExceptionInfo(JSGlobalData* globalData
 
 #if ENABLE(JIT)
 #if ENABLE(INTERPRETER)
-    if (globalData->canUseJIT())
+    // A function still warming up in the interpreter has no JIT code to map yet;
+    // compiling it later fills in the call return offsets.
+    if (globalData->canUseJIT() && !!codeBlock->getJITCode())
 #endif
     {
-        JITCode newJITCode = JIT::compile(globalData, newCodeBlock.get(), generatedJITCode().start());
-        ASSERT(newJITCode.size() == generatedJITCode().size());
+        JITCode newJITCode = JIT::compile(globalData, newCodeBlock.get(), codeBlock->getJITCode().start());
+        ASSERT(newJITCode.size() == codeBlock->getJITCode().size());
     }
 #endif
 
@@ -241,8 +378,8 @@ ExceptionInfo* EvalExecutable::reparseExceptionInfo(JSGlobalData* globalData, Sc
     if (globalData->canUseJIT())
 #endif
     {
-        JITCode newJITCode = JIT::compile(globalData, newCodeBlock.get(), generatedJITCode().start());
-        ASSERT(newJITCode.size() == generatedJITCode().size());
+        JITCode newJITCode = JIT::compile(globalData, newCodeBlock.get(), codeBlock->getJITCode().start());
+        ASSERT(newJITCode.size() == codeBlock->getJITCode().size());
     }
 #endif
 
@@ -253,6 +390,11 @@ void FunctionExecutable::recompile()
 {
     delete m_codeBlock;
     m_codeBlock = 0;
+#if ENABLE(JIT_OPTIMIZING_TIER)
+    delete m_optimizedCodeBlock;
+    m_optimizedCodeBlock = 0;
+    m_optimizationDisabled = false;
+#endif
     m_numParameters = NUM_PARAMETERS_NOT_COMPILED;
 #if ENABLE(JIT)
     m_jitCode = JITCode();
@@ -63,6 +63,8 @@ namespace JSC {
 
 #if ENABLE(JIT)
     public:
+        bool hasJITCode() const { return !!m_jitCode; }
+
         JITCode& generatedJITCode()
         {
             ASSERT(m_jitCode);
@@ -244,6 +246,7 @@ namespace JSC {
     };
 
     class FunctionExecutable : public ScriptExecutable {
+        friend class BytecodeCache;
         friend class JIT;
     public:
         static PassRefPtr<FunctionExecutable> create(ExecState* exec, const Identifier& name, const SourceCode& source, bool forceUsesArguments, FunctionParameters* parameters, int firstLine, int lastLine)
@@ -282,6 +285,31 @@ namespace JSC {
             return *m_codeBlock;
         }
 
+#if ENABLE(JIT)
+        // The CodeBlock whose machine code calls currently enter; this is the
+        // optimized one once the function has been recompiled by the second tier.
+        CodeBlock& generatedJITCodeBlock()
+        {
+#if ENABLE(JIT_OPTIMIZING_TIER)
+            if (m_optimizedCodeBlock && !m_optimizationDisabled)
+                return *m_optimizedCodeBlock;
+#endif
+            return generatedBytecode();
+        }
+#endif
+
+#if ENABLE(JIT_OPTIMIZE_CALL)
+        void unlinkCallers();
+#endif
+
+#if ENABLE(JIT_OPTIMIZING_TIER)
+        // Recompiles the function with the optimizing tier, or returns the existing
+        // optimized CodeBlock. Returns 0 if the function cannot be optimized.
+        CodeBlock* optimize(JSGlobalData*, ScopeChainNode*);
+        // Sends future calls back to the baseline code and never optimizes again.
+        void jettisonOptimizedCode();
+#endif
+
         const Identifier& name() { return m_name; }
         size_t parameterCount() const { return m_parameters->size(); }
         unsigned variableCount() const { return m_numVariables; }
@@ -300,6 +328,10 @@ namespace JSC {
             , m_parameters(parameters)
             , m_codeBlock(0)
             , m_name(name)
+#if ENABLE(JIT_OPTIMIZING_TIER)
+            , m_optimizedCodeBlock(0)
+            , m_optimizationDisabled(false)
+#endif
         {
             m_firstLine = firstLine;
             m_lastLine = lastLine;
@@ -312,6 +344,10 @@ namespace JSC {
             , m_parameters(parameters)
             , m_codeBlock(0)
             , m_name(name)
+#if ENABLE(JIT_OPTIMIZING_TIER)
+            , m_optimizedCodeBlock(0)
+            , m_optimizationDisabled(false)
+#endif
         {
             m_firstLine = firstLine;
             m_lastLine = lastLine;
@@ -325,6 +361,10 @@ namespace JSC {
         RefPtr<FunctionParameters> m_parameters;
         CodeBlock* m_codeBlock;
         Identifier m_name;
+#if ENABLE(JIT_OPTIMIZING_TIER)
+        CodeBlock* m_optimizedCodeBlock;
+        bool m_optimizationDisabled;
+#endif
 
 #if ENABLE(JIT)
     public:
@@ -46,9 +46,17 @@ namespace JSC {
         virtual void markChildren(MarkStack&);
 
         JSObject* getter() const { return m_getter; }
-        void setGetter(JSObject* getter) { m_getter = getter; }
+        void setGetter(JSObject* getter)
+        {
+            m_getter = getter;
+            Heap::writeBarrier(this);
+        }
         JSObject* setter() const { return m_setter; }
-        void setSetter(JSObject* setter) { m_setter = setter; }
+        void setSetter(JSObject* setter)
+        {
+            m_setter = setter;
+            Heap::writeBarrier(this);
+        }
         static PassRefPtr<Structure> createStructure(JSValue prototype)
         {
             return Structure::create(prototype, TypeInfo(GetterSetterType, OverridesMarkChildren), AnonymousSlotCount);
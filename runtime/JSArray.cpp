@@ -66,6 +66,12 @@ ASSERT_CLASS_FITS_IN_CELL(JSArray);
 //     (1 / minDensityMultiplier) of the entries would be populated).
 //   * Where (MAX_STORAGE_VECTOR_INDEX < i <= MAX_ARRAY_INDEX) the value will always be stored
 //     in the sparse array.
+//
+// The array's Structure records the kind of values in the storage vector (see
+// ArrayElementKind). Arrays that have only held numbers do not need their vector
+// marked, and those that have held doubles keep them unboxed. An array moves on
+// to a more general kind as soon as it is given a value that does not fit, or it
+// gains a sparse map; it never moves back.
 
 // The definition of MAX_STORAGE_VECTOR_LENGTH is dependant on the definition storageSize
 // function below - the MAX_STORAGE_VECTOR_LENGTH limit is defined such that the storage
@@ -117,6 +123,56 @@ static inline unsigned increasedVectorLength(unsigned newLength)
     return min(increasedLength, MAX_STORAGE_VECTOR_LENGTH);
 }
 
+// Storage this big lives in its owner's heap's large storage rather than in
+// FastMalloc. Vectors never shrink, so the vector length alone tells where the
+// storage is. Small storage does not need the heap, which the array made by
+// JSGlobalData::storeVPtrs does not have.
+static inline bool isLargeStorage(unsigned vectorLength)
+{
+    return storageSize(vectorLength) >= Heap::minLargeStorageSize;
+}
+
+static inline ArrayStorage* allocateStorage(JSCell* owner, unsigned vectorLength)
+{
+    if (!isLargeStorage(vectorLength))
+        return static_cast<ArrayStorage*>(fastMalloc(storageSize(vectorLength)));
+    void* storage = Heap::heap(owner)->tryAllocateLargeStorage(storageSize(vectorLength));
+    if (!storage)
+        CRASH();
+    return static_cast<ArrayStorage*>(storage);
+}
+
+static inline bool tryReallocateStorage(JSCell* owner, ArrayStorage*& storage, unsigned vectorLength, unsigned newVectorLength)
+{
+    ASSERT(newVectorLength >= vectorLength);
+    if (!isLargeStorage(newVectorLength))
+        return tryFastRealloc(storage, storageSize(newVectorLength)).getValue(storage);
+
+    Heap* heap = Heap::heap(owner);
+    void* newStorage;
+    if (isLargeStorage(vectorLength))
+        newStorage = heap->tryReallocateLargeStorage(storage, storageSize(newVectorLength));
+    else {
+        newStorage = heap->tryAllocateLargeStorage(storageSize(newVectorLength));
+        if (newStorage) {
+            memcpy(newStorage, storage, storageSize(vectorLength));
+            fastFree(storage);
+        }
+    }
+    if (!newStorage)
+        return false;
+    storage = static_cast<ArrayStorage*>(newStorage);
+    return true;
+}
+
+static inline void freeStorage(JSCell* owner, ArrayStorage* storage, unsigned vectorLength)
+{
+    if (isLargeStorage(vectorLength))
+        Heap::heap(owner)->freeLargeStorage(storage);
+    else
+        fastFree(storage);
+}
+
 static inline bool isDenseEnoughForVector(unsigned length, unsigned numValues)
 {
     return length / minDensityMultiplier <= numValues;
@@ -146,7 +202,7 @@ JSArray::JSArray(NonNullPassRefPtr<Structure> structure, unsigned initialLength)
 {
     unsigned initialCapacity = min(initialLength, MIN_SPARSE_ARRAY_INDEX);
 
-    m_storage = static_cast<ArrayStorage*>(fastMalloc(storageSize(initialCapacity)));
+    m_storage = allocateStorage(this, initialCapacity);
     m_storage->m_length = initialLength;
     m_vectorLength = initialCapacity;
     m_storage->m_numValuesInVector = 0;
@@ -154,9 +210,10 @@ JSArray::JSArray(NonNullPassRefPtr<Structure> structure, unsigned initialLength)
     m_storage->subclassData = 0;
     m_storage->reportedMapCapacity = 0;
 
+    JSValue hole = holeSlot(elementKind());
     JSValue* vector = m_storage->m_vector;
     for (size_t i = 0; i < initialCapacity; ++i)
-        vector[i] = JSValue();
+        vector[i] = hole;
 
     checkConsistency();
 
@@ -168,7 +225,7 @@ JSArray::JSArray(NonNullPassRefPtr<Structure> structure, const ArgList& list)
 {
     unsigned initialCapacity = list.size();
 
-    m_storage = static_cast<ArrayStorage*>(fastMalloc(storageSize(initialCapacity)));
+    m_storage = allocateStorage(this, initialCapacity);
     m_storage->m_length = initialCapacity;
     m_vectorLength = initialCapacity;
     m_storage->m_numValuesInVector = initialCapacity;
@@ -176,10 +233,21 @@ JSArray::JSArray(NonNullPassRefPtr<Structure> structure, const ArgList& list)
     m_storage->subclassData = 0;
     m_storage->reportedMapCapacity = 0;
 
-    size_t i = 0;
+    ArrayElementKind kind = elementKind();
     ArgList::const_iterator end = list.end();
+    if (kind < ContiguousArrayElements) {
+        ArrayElementKind valuesKind = Int32ArrayElements;
+        for (ArgList::const_iterator it = list.begin(); it != end; ++it)
+            valuesKind = max(valuesKind, elementKindForValue(*it));
+        if (valuesKind > kind) {
+            kind = valuesKind;
+            setStructure(Structure::arrayElementKindTransition(this->structure(), kind));
+        }
+    }
+
+    size_t i = 0;
     for (ArgList::const_iterator it = list.begin(); it != end; ++it, ++i)
-        m_storage->m_vector[i] = *it;
+        m_storage->m_vector[i] = slotFor(kind, *it);
 
     checkConsistency();
 
@@ -192,7 +260,7 @@ JSArray::~JSArray()
     checkConsistency(DestructorConsistencyCheck);
 
     delete m_storage->m_sparseValueMap;
-    fastFree(m_storage);
+    freeStorage(this, m_storage, m_vectorLength);
 }
 
 bool JSArray::getOwnPropertySlot(ExecState* exec, unsigned i, PropertySlot& slot)
@@ -207,7 +275,13 @@ bool JSArray::getOwnPropertySlot(ExecState* exec, unsigned i, PropertySlot& slot
 
     if (i < m_vectorLength) {
         JSValue& valueSlot = storage->m_vector[i];
-        if (valueSlot) {
+        ArrayElementKind kind = elementKind();
+        if (kind == DoubleArrayElements) {
+            if (valueSlot != doubleArrayHole()) {
+                slot.setValue(jsNumber(exec, doubleInArraySlot(valueSlot)));
+                return true;
+            }
+        } else if (valueSlot) {
             slot.setValueSlot(&valueSlot);
             return true;
         }
@@ -252,9 +326,10 @@ bool JSArray::getOwnPropertyDescriptor(ExecState* exec, const Identifier& proper
         if (i >= m_storage->m_length)
             return false;
         if (i < m_vectorLength) {
+            ArrayElementKind kind = elementKind();
             JSValue& value = m_storage->m_vector[i];
-            if (value) {
-                descriptor.setDescriptor(value, 0);
+            if (!isHole(kind, value)) {
+                descriptor.setDescriptor(valueInSlot(exec, kind, value), 0);
                 return true;
             }
         } else if (SparseArrayValueMap* map = m_storage->m_sparseValueMap) {
@@ -296,6 +371,7 @@ void JSArray::put(ExecState* exec, const Identifier& propertyName, JSValue value
 void JSArray::put(ExecState* exec, unsigned i, JSValue value)
 {
     checkConsistency();
+    Heap::writeBarrier(this, value);
 
     unsigned length = m_storage->m_length;
     if (i >= length && i <= MAX_ARRAY_INDEX) {
@@ -304,13 +380,14 @@ void JSArray::put(ExecState* exec, unsigned i, JSValue value)
     }
 
     if (i < m_vectorLength) {
+        ArrayElementKind kind = elementKindForStoring(value);
         JSValue& valueSlot = m_storage->m_vector[i];
-        if (valueSlot) {
-            valueSlot = value;
+        if (!isHole(kind, valueSlot)) {
+            valueSlot = slotFor(kind, value);
             checkConsistency();
             return;
         }
-        valueSlot = value;
+        valueSlot = slotFor(kind, value);
         ++m_storage->m_numValuesInVector;
         checkConsistency();
         return;
@@ -335,6 +412,8 @@ NEVER_INLINE void JSArray::putSlowCase(ExecState* exec, unsigned i, JSValue valu
         // (which will only be compacted as we reach indices that are less than MIN_SPARSE_ARRAY_INDEX) - but this makes the check much faster.
         if ((i > MAX_STORAGE_VECTOR_INDEX) || !isDenseEnoughForVector(i + 1, storage->m_numValuesInVector + 1)) {
             if (!map) {
+                if (elementKind() != SparseArrayElements)
+                    convertToElementKind(SparseArrayElements);
                 map = new SparseArrayValueMap;
                 storage->m_sparseValueMap = map;
             }
@@ -358,8 +437,9 @@ NEVER_INLINE void JSArray::putSlowCase(ExecState* exec, unsigned i, JSValue valu
     // Fast case is when there is no sparse map, so we can increase the vector size without moving values from it.
     if (!map || map->isEmpty()) {
         if (increaseVectorLength(i + 1)) {
+            ArrayElementKind kind = elementKindForStoring(value);
             storage = m_storage;
-            storage->m_vector[i] = value;
+            storage->m_vector[i] = slotFor(kind, value);
             ++storage->m_numValuesInVector;
             checkConsistency();
         } else
@@ -388,7 +468,7 @@ NEVER_INLINE void JSArray::putSlowCase(ExecState* exec, unsigned i, JSValue valu
         }
     }
 
-    if (!tryFastRealloc(storage, storageSize(newVectorLength)).getValue(storage)) {
+    if (!tryReallocateStorage(this, storage, m_vectorLength, newVectorLength)) {
         throwOutOfMemoryError(exec);
         return;
     }
@@ -439,12 +519,13 @@ bool JSArray::deleteProperty(ExecState* exec, unsigned i)
     ArrayStorage* storage = m_storage;
 
     if (i < m_vectorLength) {
+        ArrayElementKind kind = elementKind();
         JSValue& valueSlot = storage->m_vector[i];
-        if (!valueSlot) {
+        if (isHole(kind, valueSlot)) {
             checkConsistency();
             return false;
         }
-        valueSlot = JSValue();
+        valueSlot = holeSlot(kind);
         --storage->m_numValuesInVector;
         checkConsistency();
         return true;
@@ -477,9 +558,10 @@ void JSArray::getOwnPropertyNames(ExecState* exec, PropertyNameArray& propertyNa
 
     ArrayStorage* storage = m_storage;
 
+    ArrayElementKind kind = elementKind();
     unsigned usedVectorLength = min(storage->m_length, m_vectorLength);
     for (unsigned i = 0; i < usedVectorLength; ++i) {
-        if (storage->m_vector[i])
+        if (!isHole(kind, storage->m_vector[i]))
             propertyNames.add(Identifier::from(exec, i));
     }
 
@@ -507,13 +589,14 @@ bool JSArray::increaseVectorLength(unsigned newLength)
     ASSERT(newLength <= MAX_STORAGE_VECTOR_INDEX);
     unsigned newVectorLength = increasedVectorLength(newLength);
 
-    if (!tryFastRealloc(storage, storageSize(newVectorLength)).getValue(storage))
+    if (!tryReallocateStorage(this, storage, vectorLength, newVectorLength))
         return false;
 
     m_vectorLength = newVectorLength;
 
+    JSValue hole = holeSlot(elementKind());
     for (unsigned i = vectorLength; i < newVectorLength; ++i)
-        storage->m_vector[i] = JSValue();
+        storage->m_vector[i] = hole;
 
     m_storage = storage;
 
@@ -522,6 +605,25 @@ bool JSArray::increaseVectorLength(unsigned newLength)
     return true;
 }
 
+void JSArray::convertToElementKind(ArrayElementKind kind)
+{
+    ArrayElementKind oldKind = elementKind();
+    ASSERT(kind > oldKind);
+
+    JSValue* vector = m_storage->m_vector;
+    if (oldKind == Int32ArrayElements && kind == DoubleArrayElements) {
+        for (unsigned i = 0; i < m_vectorLength; ++i)
+            vector[i] = vector[i] ? doubleArraySlot(vector[i].asInt32()) : doubleArrayHole();
+    } else if (oldKind == DoubleArrayElements) {
+        // Numbers are never cells, so these need no write barrier.
+        JSGlobalData* globalData = Heap::heap(this)->globalData();
+        for (unsigned i = 0; i < m_vectorLength; ++i)
+            vector[i] = vector[i] == doubleArrayHole() ? JSValue() : jsNumber(globalData, doubleInArraySlot(vector[i]));
+    }
+
+    setStructure(Structure::arrayElementKindTransition(structure(), kind));
+}
+
 void JSArray::setLength(unsigned newLength)
 {
     checkConsistency();
@@ -531,11 +633,13 @@ void JSArray::setLength(unsigned newLength)
     unsigned length = m_storage->m_length;
 
     if (newLength < length) {
+        ArrayElementKind kind = elementKind();
+        JSValue hole = holeSlot(kind);
         unsigned usedVectorLength = min(length, m_vectorLength);
         for (unsigned i = newLength; i < usedVectorLength; ++i) {
             JSValue& valueSlot = storage->m_vector[i];
-            bool hadValue = valueSlot;
-            valueSlot = JSValue();
+            bool hadValue = !isHole(kind, valueSlot);
+            valueSlot = hole;
             storage->m_numValuesInVector -= hadValue;
         }
 
@@ -558,7 +662,7 @@ void JSArray::setLength(unsigned newLength)
     checkConsistency();
 }
 
-JSValue JSArray::pop()
+JSValue JSArray::pop(ExecState* exec)
 {
     checkConsistency();
 
@@ -571,11 +675,12 @@ JSValue JSArray::pop()
     JSValue result;
 
     if (length < m_vectorLength) {
+        ArrayElementKind kind = elementKind();
         JSValue& valueSlot = m_storage->m_vector[length];
-        if (valueSlot) {
+        if (!isHole(kind, valueSlot)) {
             --m_storage->m_numValuesInVector;
-            result = valueSlot;
-            valueSlot = JSValue();
+            result = valueInSlot(exec, kind, valueSlot);
+            valueSlot = holeSlot(kind);
         } else
             result = jsUndefined();
     } else {
@@ -603,9 +708,10 @@ JSValue JSArray::pop()
 void JSArray::push(ExecState* exec, JSValue value)
 {
     checkConsistency();
+    Heap::writeBarrier(this, value);
 
     if (m_storage->m_length < m_vectorLength) {
-        m_storage->m_vector[m_storage->m_length] = value;
+        m_storage->m_vector[m_storage->m_length] = slotFor(elementKindForStoring(value), value);
         ++m_storage->m_numValuesInVector;
         ++m_storage->m_length;
         checkConsistency();
@@ -616,7 +722,7 @@ void JSArray::push(ExecState* exec, JSValue value)
         SparseArrayValueMap* map = m_storage->m_sparseValueMap;
         if (!map || map->isEmpty()) {
             if (increaseVectorLength(m_storage->m_length + 1)) {
-                m_storage->m_vector[m_storage->m_length] = value;
+                m_storage->m_vector[m_storage->m_length] = slotFor(elementKindForStoring(value), value);
                 ++m_storage->m_numValuesInVector;
                 ++m_storage->m_length;
                 checkConsistency();
@@ -643,6 +749,13 @@ static int compareNumbersForQSort(const void* a, const void* b)
     return (da > db) - (da < db);
 }
 
+static int compareDoublesForQSort(const void* a, const void* b)
+{
+    double da = doubleInArraySlot(*static_cast<const JSValue*>(a));
+    double db = doubleInArraySlot(*static_cast<const JSValue*>(b));
+    return (da > db) - (da < db);
+}
+
 static int compareByStringPairForQSort(const void* a, const void* b)
 {
     const ValueStringPair* va = static_cast<const ValueStringPair*>(a);
@@ -660,6 +773,12 @@ void JSArray::sortNumeric(ExecState* exec, JSValue compareFunction, CallType cal
 
     if (!lengthNotIncludingUndefined)
         return;
+
+    if (elementKind() == DoubleArrayElements) {
+        qsort(m_storage->m_vector, lengthNotIncludingUndefined, sizeof(JSValue), compareDoublesForQSort);
+        checkConsistency(SortConsistencyCheck);
+        return;
+    }
         
     bool allValuesAreNumbers = true;
     size_t size = m_storage->m_numValuesInVector;
@@ -683,6 +802,9 @@ void JSArray::sortNumeric(ExecState* exec, JSValue compareFunction, CallType cal
 
 void JSArray::sort(ExecState* exec)
 {
+    if (elementKind() == DoubleArrayElements)
+        convertToElementKind(ContiguousArrayElements);
+
     unsigned lengthNotIncludingUndefined = compactForSorting();
     if (m_storage->m_sparseValueMap) {
         throwOutOfMemoryError(exec);
@@ -841,6 +963,11 @@ void JSArray::sort(ExecState* exec, JSValue compareFunction, CallType callType,
     if (!m_storage->m_length)
         return;
 
+    // The compare function can store anything in the array, so the values are
+    // sorted as JSValues.
+    if (elementKind() < ContiguousArrayElements)
+        convertToElementKind(ContiguousArrayElements);
+
     unsigned usedVectorLength = min(m_storage->m_length, m_vectorLength);
 
     AVLTree<AVLTreeAbstractorForArrayCompare, 44> tree; // Depth 44 is enough for 2^31 items
@@ -866,10 +993,13 @@ void JSArray::sort(ExecState* exec, JSValue compareFunction, CallType callType,
     unsigned numUndefined = 0;
 
     // Iterate over the array, ignoring missing values, counting undefined ones, and inserting all other ones into the tree.
+    // The tree is not marked, so the values in it are pinned.
     for (; numDefined < usedVectorLength; ++numDefined) {
         JSValue v = m_storage->m_vector[numDefined];
         if (!v || v.isUndefined())
             break;
+        if (v.isCell())
+            Heap::pinCell(v.asCell());
         tree.abstractor().m_nodes[numDefined].value = v;
         tree.insert(numDefined);
     }
@@ -879,6 +1009,8 @@ void JSArray::sort(ExecState* exec, JSValue compareFunction, CallType callType,
             if (v.isUndefined())
                 ++numUndefined;
             else {
+                if (v.isCell())
+                    Heap::pinCell(v.asCell());
                 tree.abstractor().m_nodes[numDefined].value = v;
                 tree.insert(numDefined);
                 ++numDefined;
@@ -900,6 +1032,8 @@ void JSArray::sort(ExecState* exec, JSValue compareFunction, CallType callType,
 
         SparseArrayValueMap::iterator end = map->end();
         for (SparseArrayValueMap::iterator it = map->begin(); it != end; ++it) {
+            if (it->second.isCell())
+                Heap::pinCell(it->second.asCell());
             tree.abstractor().m_nodes[numDefined].value = it->second;
             tree.insert(numDefined);
             ++numDefined;
@@ -937,14 +1071,15 @@ void JSArray::sort(ExecState* exec, JSValue compareFunction, CallType callType,
 
 void JSArray::fillArgList(ExecState* exec, MarkedArgumentBuffer& args)
 {
+    ArrayElementKind kind = elementKind();
     JSValue* vector = m_storage->m_vector;
     unsigned vectorEnd = min(m_storage->m_length, m_vectorLength);
     unsigned i = 0;
     for (; i < vectorEnd; ++i) {
         JSValue& v = vector[i];
-        if (!v)
+        if (isHole(kind, v))
             break;
-        args.append(v);
+        args.append(valueInSlot(exec, kind, v));
     }
 
     for (; i < m_storage->m_length; ++i)
@@ -955,14 +1090,15 @@ void JSArray::copyToRegisters(ExecState* exec, Register* buffer, uint32_t maxSiz
 {
     ASSERT(m_storage->m_length >= maxSize);
     UNUSED_PARAM(maxSize);
+    ArrayElementKind kind = elementKind();
     JSValue* vector = m_storage->m_vector;
     unsigned vectorEnd = min(maxSize, m_vectorLength);
     unsigned i = 0;
     for (; i < vectorEnd; ++i) {
         JSValue& v = vector[i];
-        if (!v)
+        if (isHole(kind, v))
             break;
-        buffer[i] = v;
+        buffer[i] = valueInSlot(exec, kind, v);
     }
 
     for (; i < maxSize; ++i)
@@ -980,6 +1116,22 @@ unsigned JSArray::compactForSorting()
     unsigned numDefined = 0;
     unsigned numUndefined = 0;
 
+    // Arrays of doubles have neither undefined values nor a sparse map.
+    if (elementKind() == DoubleArrayElements) {
+        for (unsigned i = 0; i < usedVectorLength; ++i) {
+            JSValue v = storage->m_vector[i];
+            if (v != doubleArrayHole())
+                storage->m_vector[numDefined++] = v;
+        }
+        for (unsigned i = numDefined; i < usedVectorLength; ++i)
+            storage->m_vector[i] = doubleArrayHole();
+        ASSERT(numDefined == storage->m_numValuesInVector);
+
+        checkConsistency(SortConsistencyCheck);
+
+        return numDefined;
+    }
+
     for (; numDefined < usedVectorLength; ++numDefined) {
         JSValue v = storage->m_vector[numDefined];
         if (!v || v.isUndefined())
@@ -1045,11 +1197,18 @@ void JSArray::checkConsistency(ConsistencyCheckType type)
     if (type == SortConsistencyCheck)
         ASSERT(!m_storage->m_sparseValueMap);
 
+    ArrayElementKind kind = elementKind();
+    if (m_storage->m_sparseValueMap)
+        ASSERT(kind == SparseArrayElements);
+
     unsigned numValuesInVector = 0;
     for (unsigned i = 0; i < m_vectorLength; ++i) {
-        if (JSValue value = m_storage->m_vector[i]) {
+        JSValue value = m_storage->m_vector[i];
+        if (!isHole(kind, value)) {
             ASSERT(i < m_storage->m_length);
-            if (type != DestructorConsistencyCheck)
+            if (kind == Int32ArrayElements)
+                ASSERT(value.isInt32());
+            else if (kind != DoubleArrayElements && type != DestructorConsistencyCheck)
                 value->type(); // Likely to crash if the object was deallocated.
             ++numValuesInVector;
         } else {
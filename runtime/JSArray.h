@@ -36,6 +36,48 @@ namespace JSC {
         JSValue m_vector[1];
     };
 
+    // The vector of an array of DoubleArrayElements holds the bits of a double in
+    // each slot in place of a JSValue, so the values need no boxing and the vector
+    // no marking. The bits of a hole are a signalling NaN, which arithmetic never
+    // gives; an array given a double with these bits anyway becomes contiguous.
+    // JSValues that cannot hold a double keep arrays from having this kind.
+    static const int64_t arrayDoubleHoleBits = 0x7ff4000000000000ll;
+
+#if USE(JSVALUE32)
+    inline JSValue doubleArraySlot(double)
+    {
+        ASSERT_NOT_REACHED();
+        return JSValue();
+    }
+
+    inline double doubleInArraySlot(JSValue)
+    {
+        ASSERT_NOT_REACHED();
+        return 0;
+    }
+
+    inline JSValue doubleArrayHole()
+    {
+        ASSERT_NOT_REACHED();
+        return JSValue();
+    }
+#else
+    inline JSValue doubleArraySlot(double value)
+    {
+        return JSValue::decode(WTF::bitwise_cast<EncodedJSValue>(value));
+    }
+
+    inline double doubleInArraySlot(JSValue slot)
+    {
+        return WTF::bitwise_cast<double>(JSValue::encode(slot));
+    }
+
+    inline JSValue doubleArrayHole()
+    {
+        return JSValue::decode(WTF::bitwise_cast<EncodedJSValue>(arrayDoubleHoleBits));
+    }
+#endif
+
     class JSArray : public JSObject {
         friend class JIT;
         friend class Walker;
@@ -61,26 +103,28 @@ namespace JSC {
         void sortNumeric(ExecState*, JSValue compareFunction, CallType, const CallData&);
 
         void push(ExecState*, JSValue);
-        JSValue pop();
+        JSValue pop(ExecState*);
 
-        bool canGetIndex(unsigned i) { return i < m_vectorLength && m_storage->m_vector[i]; }
-        JSValue getIndex(unsigned i)
+        bool canGetIndex(unsigned i) { return i < m_vectorLength && !isHole(elementKind(), m_storage->m_vector[i]); }
+        JSValue getIndex(ExecState* exec, unsigned i)
         {
             ASSERT(canGetIndex(i));
-            return m_storage->m_vector[i];
+            return valueInSlot(exec, elementKind(), m_storage->m_vector[i]);
         }
 
         bool canSetIndex(unsigned i) { return i < m_vectorLength; }
         void setIndex(unsigned i, JSValue v)
         {
             ASSERT(canSetIndex(i));
+            ArrayElementKind kind = elementKindForStoring(v);
             JSValue& x = m_storage->m_vector[i];
-            if (!x) {
+            if (isHole(kind, x)) {
                 ++m_storage->m_numValuesInVector;
                 if (i >= m_storage->m_length)
                     m_storage->m_length = i + 1;
             }
-            x = v;
+            x = slotFor(kind, v);
+            Heap::writeBarrier(this, v);
         }
 
         void fillArgList(ExecState*, MarkedArgumentBuffer&);
@@ -111,6 +155,29 @@ namespace JSC {
         void putSlowCase(ExecState*, unsigned propertyName, JSValue);
 
         bool increaseVectorLength(unsigned newLength);
+
+        ArrayElementKind elementKind() const { return structure()->arrayElementKind(); }
+        // The kind the array has to be to hold value, which it is converted to if
+        // it is not already.
+        ArrayElementKind elementKindForStoring(JSValue value)
+        {
+            ArrayElementKind kind = elementKind();
+            if (kind < ContiguousArrayElements) {
+                ArrayElementKind valueKind = elementKindForValue(value);
+                if (valueKind > kind) {
+                    convertToElementKind(valueKind);
+                    return valueKind;
+                }
+            }
+            return kind;
+        }
+        void convertToElementKind(ArrayElementKind);
+        static ArrayElementKind elementKindForValue(JSValue);
+
+        static bool isHole(ArrayElementKind kind, JSValue slot) { return kind == DoubleArrayElements ? slot == doubleArrayHole() : !slot; }
+        static JSValue holeSlot(ArrayElementKind kind) { return kind == DoubleArrayElements ? doubleArrayHole() : JSValue(); }
+        static JSValue slotFor(ArrayElementKind kind, JSValue value) { return kind == DoubleArrayElements ? doubleArraySlot(value.uncheckedGetNumber()) : value; }
+        static JSValue valueInSlot(ExecState* exec, ArrayElementKind kind, JSValue slot) { return kind == DoubleArrayElements ? jsNumber(exec, doubleInArraySlot(slot)) : slot; }
         
         unsigned compactForSorting();
 
@@ -140,14 +207,28 @@ namespace JSC {
     }
     inline bool isJSArray(JSGlobalData* globalData, JSCell* cell) { return cell->vptr() == globalData->jsArrayVPtr; }
 
+    inline ArrayElementKind JSArray::elementKindForValue(JSValue value)
+    {
+        if (value.isInt32())
+            return Int32ArrayElements;
+#if !USE(JSVALUE32)
+        if (value.isDouble() && WTF::bitwise_cast<int64_t>(value.asDouble()) != arrayDoubleHoleBits)
+            return DoubleArrayElements;
+#endif
+        return ContiguousArrayElements;
+    }
+
     inline void JSArray::markChildrenDirect(MarkStack& markStack)
     {
         JSObject::markChildrenDirect(markStack);
         
         ArrayStorage* storage = m_storage;
 
-        unsigned usedVectorLength = std::min(storage->m_length, m_vectorLength);
-        markStack.appendValues(storage->m_vector, usedVectorLength, MayContainNullValues);
+        // The vectors of arrays of numbers hold no cells.
+        if (elementKind() >= ContiguousArrayElements) {
+            unsigned usedVectorLength = std::min(storage->m_length, m_vectorLength);
+            markStack.appendSlots(storage->m_vector, usedVectorLength, MayContainNullValues);
+        }
 
         if (SparseArrayValueMap* map = storage->m_sparseValueMap) {
             SparseArrayValueMap::iterator end = map->end();
@@ -158,7 +239,7 @@ namespace JSC {
 
     inline void MarkStack::markChildren(JSCell* cell)
     {
-        ASSERT(Heap::isCellMarked(cell));
+        ASSERT(Heap::isCellMarkedByCollection(cell));
         if (!cell->structure()->typeInfo().overridesMarkChildren()) {
 #ifdef NDEBUG
             asObject(cell)->markChildrenDirect(*this);
@@ -190,11 +271,12 @@ namespace JSC {
                 ASSERT(current.m_values != end);
             findNextUnmarkedNullValue:
                 ASSERT(current.m_values != end);
-                JSValue value = *current.m_values;
+                JSValue* slot = current.m_values;
+                JSValue value = *slot;
                 current.m_values++;
 
                 JSCell* cell;
-                if (!value || !value.isCell() || Heap::isCellMarked(cell = value.asCell())) {
+                if (!value || !value.isCell() || testAndSetMarked(cell = value.asCell(), current.m_slotsAreUpdatable ? slot : 0)) {
                     if (current.m_values == end) {
                         m_markSets.removeLast();
                         continue;
@@ -202,7 +284,6 @@ namespace JSC {
                     goto findNextUnmarkedNullValue;
                 }
 
-                Heap::markCell(cell);
                 if (cell->structure()->typeInfo().type() < CompoundType) {
                     if (current.m_values == end) {
                         m_markSets.removeLast();
@@ -323,13 +323,33 @@ namespace JSC {
         return isCell() ? asCell()->toThisObject(exec) : toThisObjectSlowCase(exec);
     }
 
+    ALWAYS_INLINE void MarkStack::noteReference(JSCell* cell, JSValue* slot)
+    {
+        if (!Heap::isEvacuating(cell))
+            return;
+        if (slot)
+            m_slotsToUpdate.append(slot);
+        else
+            Heap::pinForCollection(cell);
+    }
+
+    // Returns whether the cell was already marked, after noting the reference
+    // to it from a mark set.
+    ALWAYS_INLINE bool MarkStack::testAndSetMarked(JSCell* cell, JSValue* slot)
+    {
+        if (m_isEvacuating)
+            noteReference(cell, slot);
+        return Heap::testAndSetMarked(cell);
+    }
+
     ALWAYS_INLINE void MarkStack::append(JSCell* cell)
     {
         ASSERT(!m_isCheckingForDefaultMarkViolation);
         ASSERT(cell);
-        if (Heap::isCellMarked(cell))
+        if (m_isEvacuating)
+            noteReference(cell, 0);
+        if (Heap::testAndSetMarked(cell))
             return;
-        Heap::markCell(cell);
         if (cell->structure()->typeInfo().type() >= CompoundType)
             m_values.append(cell);
     }
@@ -352,6 +372,12 @@ namespace JSC {
     {
         return cellBlock(c)->heap;
     }
+
+    inline void Heap::writeBarrier(const JSCell* owner, JSValue value)
+    {
+        if (value.isCell())
+            writeBarrier(owner);
+    }
     
 #if ENABLE(JSC_ZOMBIES)
     inline bool JSValue::isZombie() const
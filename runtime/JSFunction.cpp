@@ -107,7 +107,7 @@ JSFunction::~JSFunction()
 #if ENABLE(JIT_OPTIMIZE_CALL)
         ASSERT(m_executable);
         if (jsExecutable()->isGenerated())
-            jsExecutable()->generatedBytecode().unlinkCallers();
+            jsExecutable()->unlinkCallers();
 #endif
         scopeChain().~ScopeChain(); // FIXME: Don't we need to do this in the interpreter too?
     }
@@ -272,10 +272,10 @@ JSObject* JSFunction::construct(ExecState* exec, const ArgList& args)
     Structure* structure;
     JSValue prototype = get(exec, exec->propertyNames().prototype);
     if (prototype.isObject())
-        structure = asObject(prototype)->inheritorID();
+        structure = asObject(prototype)->inheritorIDForConstruction();
     else
         structure = exec->lexicalGlobalObject()->emptyObjectStructure();
-    JSObject* thisObj = new (exec) JSObject(structure);
+    JSObject* thisObj = constructObject(&exec->globalData(), structure);
 
     JSValue result = exec->interpreter()->execute(jsExecutable(), exec, this, thisObj, args, scopeChain().node(), exec->exceptionSlot());
     if (exec->hadException() || !result.isObject())
@@ -30,6 +30,7 @@
 #include "JSGlobalData.h"
 
 #include "ArgList.h"
+#include "BytecodeCache.h"
 #include "Collector.h"
 #include "CollectorHeapIterator.h"
 #include "CommonIdentifiers.h"
@@ -79,31 +80,37 @@ void* JSGlobalData::jsArrayVPtr;
 void* JSGlobalData::jsByteArrayVPtr;
 void* JSGlobalData::jsStringVPtr;
 void* JSGlobalData::jsFunctionVPtr;
+void* JSGlobalData::jsObjectVPtr;
 
 void JSGlobalData::storeVPtrs()
 {
-    CollectorCell cell;
+    CollectorCell cell[LARGE_CELL_SIZE / ATOM_SIZE];
     void* storage = &cell;
 
-    COMPILE_ASSERT(sizeof(JSArray) <= sizeof(CollectorCell), sizeof_JSArray_must_be_less_than_CollectorCell);
+    COMPILE_ASSERT(sizeof(JSArray) <= sizeof(cell), sizeof_JSArray_must_be_less_than_largest_cell);
     JSCell* jsArray = new (storage) JSArray(JSArray::createStructure(jsNull()));
     JSGlobalData::jsArrayVPtr = jsArray->vptr();
     jsArray->~JSCell();
 
-    COMPILE_ASSERT(sizeof(JSByteArray) <= sizeof(CollectorCell), sizeof_JSByteArray_must_be_less_than_CollectorCell);
+    COMPILE_ASSERT(sizeof(JSByteArray) <= sizeof(cell), sizeof_JSByteArray_must_be_less_than_largest_cell);
     JSCell* jsByteArray = new (storage) JSByteArray(JSByteArray::VPtrStealingHack);
     JSGlobalData::jsByteArrayVPtr = jsByteArray->vptr();
     jsByteArray->~JSCell();
 
-    COMPILE_ASSERT(sizeof(JSString) <= sizeof(CollectorCell), sizeof_JSString_must_be_less_than_CollectorCell);
+    COMPILE_ASSERT(sizeof(JSString) <= sizeof(cell), sizeof_JSString_must_be_less_than_largest_cell);
     JSCell* jsString = new (storage) JSString(JSString::VPtrStealingHack);
     JSGlobalData::jsStringVPtr = jsString->vptr();
     jsString->~JSCell();
 
-    COMPILE_ASSERT(sizeof(JSFunction) <= sizeof(CollectorCell), sizeof_JSFunction_must_be_less_than_CollectorCell);
+    COMPILE_ASSERT(sizeof(JSFunction) <= sizeof(cell), sizeof_JSFunction_must_be_less_than_largest_cell);
     JSCell* jsFunction = new (storage) JSFunction(JSFunction::createStructure(jsNull()));
     JSGlobalData::jsFunctionVPtr = jsFunction->vptr();
     jsFunction->~JSCell();
+
+    COMPILE_ASSERT(sizeof(JSObject) <= sizeof(cell), sizeof_JSObject_must_be_less_than_largest_cell);
+    JSCell* jsObject = new (storage) JSObject(JSObject::createStructure(jsNull()));
+    JSGlobalData::jsObjectVPtr = jsObject->vptr();
+    jsObject->~JSCell();
 }
 
 JSGlobalData::JSGlobalData(GlobalDataType globalDataType, ThreadStackType threadStackType)
@@ -144,6 +151,16 @@ JSGlobalData::JSGlobalData(GlobalDataType globalDataType, ThreadStackType thread
     , functionCodeBlockBeingReparsed(0)
     , firstStringifierToMark(0)
     , markStack(jsArrayVPtr)
+    , numberOfMarkingThreads(MarkStack::defaultNumberOfMarkingThreads())
+    , markingSliceMicroseconds(0)
+#if ENABLE(JIT_OPTIMIZING_TIER)
+    , optimizationThreshold(1000)
+    , speculationFailureLimit(100)
+#endif
+#if ENABLE(INTERPRETER_OSR)
+    , interpreterLoopThreshold(100)
+    , interpreterFunctionThreshold(500)
+#endif
     , cachedUTCOffset(NaN)
     , maxReentryDepth(threadStackType == ThreadStackTypeSmall ? MaxSmallThreadReentryDepth : MaxLargeThreadReentryDepth)
     , m_regExpCache(new RegExpCache(this))
@@ -214,6 +231,7 @@ JSGlobalData::~JSGlobalData()
 
     delete emptyList;
 
+    megamorphicCache.clear();
     delete propertyNames;
     if (globalDataType != Default)
         deleteIdentifierTable(identifierTable);
@@ -36,6 +36,7 @@
 #include "JITStubs.h"
 #include "JSValue.h"
 #include "MarkStack.h"
+#include "MegamorphicCache.h"
 #include "NumericStrings.h"
 #include "SmallStrings.h"
 #include "Terminator.h"
@@ -50,6 +51,7 @@ struct OpaqueJSClassContextData;
 
 namespace JSC {
 
+    class BytecodeCache;
     class CodeBlock;
     class CommonIdentifiers;
     class IdentifierTable;
@@ -154,6 +156,7 @@ namespace JSC {
         static JS_EXPORTDATA void* jsByteArrayVPtr;
         static JS_EXPORTDATA void* jsStringVPtr;
         static JS_EXPORTDATA void* jsFunctionVPtr;
+        static JS_EXPORTDATA void* jsObjectVPtr;
 
         IdentifierTable* identifierTable;
         CommonIdentifiers* propertyNames;
@@ -161,6 +164,7 @@ namespace JSC {
         SmallStrings smallStrings;
         NumericStrings numericStrings;
         DateInstanceCache dateInstanceCache;
+        MegamorphicCache megamorphicCache;
         
 #if ENABLE(ASSEMBLER)
         ExecutableAllocator executableAllocator;
@@ -177,6 +181,7 @@ namespace JSC {
         Lexer* lexer;
         Parser* parser;
         Interpreter* interpreter;
+        OwnPtr<BytecodeCache> bytecodeCache; // Only used if the embedder installs one.
 #if ENABLE(JIT)
         OwnPtr<JITThunks> jitStubs;
         NativeExecutable* getThunk(ThunkGenerator generator)
@@ -208,6 +213,16 @@ namespace JSC {
         Stringifier* firstStringifierToMark;
 
         MarkStack markStack;
+        unsigned numberOfMarkingThreads; // Including the collecting thread. Only honored with ENABLE(PARALLEL_GC).
+        unsigned markingSliceMicroseconds; // Pause budget for incremental marking of full collections; 0 marks in one pause.
+#if ENABLE(JIT_OPTIMIZING_TIER)
+        unsigned optimizationThreshold; // Function entries plus loop iterations before a function is recompiled by the optimizing tier; 0 disables it.
+        unsigned speculationFailureLimit; // Bail-outs to baseline code after which optimized code is discarded for good.
+#endif
+#if ENABLE(INTERPRETER_OSR)
+        unsigned interpreterLoopThreshold; // Loop iterations global code runs in the interpreter before switching to JIT code; 0 compiles it before it runs.
+        unsigned interpreterFunctionThreshold; // Calls plus loop iterations a function runs in the interpreter before it is compiled; 0 compiles functions on their first call.
+#endif
 
         double cachedUTCOffset;
         DSTOffsetCache dstOffsetCache;
@@ -347,6 +347,7 @@ namespace JSC {
             SymbolTableEntry newEntry(index, global.attributes);
             symbolTable().add(global.identifier.ustring().rep(), newEntry);
             registerAt(index) = global.value;
+            Heap::writeBarrier(this, global.value);
         }
     }
 
@@ -528,7 +528,7 @@ bool Stringifier::Holder::appendNextProperty(Stringifier& stringifier, StringBui
         // Get the value.
         JSValue value;
         if (m_isJSArray && asArray(m_object)->canGetIndex(index))
-            value = asArray(m_object)->getIndex(index);
+            value = asArray(m_object)->getIndex(exec, index);
         else {
             PropertySlot slot(m_object);
             if (!m_object->getOwnPropertySlot(exec, index, slot))
@@ -679,6 +679,8 @@ NEVER_INLINE JSValue Walker::walk(JSValue unfiltered)
                 }
 
                 JSArray* array = asArray(inValue);
+                // Marking reaches the array through its holder, not this stack.
+                Heap::pinCell(array);
                 arrayStack.append(array);
                 indexStack.append(0);
                 // fallthrough
@@ -702,7 +704,7 @@ NEVER_INLINE JSValue Walker::walk(JSValue unfiltered)
                     break;
                 }
                 if (isJSArray(&m_exec->globalData(), array) && array->canGetIndex(index))
-                    inValue = array->getIndex(index);
+                    inValue = array->getIndex(m_exec, index);
                 else {
                     PropertySlot slot;
                     if (array->getOwnPropertySlot(m_exec, index, slot))
@@ -744,6 +746,8 @@ NEVER_INLINE JSValue Walker::walk(JSValue unfiltered)
                 }
 
                 JSObject* object = asObject(inValue);
+                // Marking reaches the object through its holder, not this stack.
+                Heap::pinCell(object);
                 objectStack.append(object);
                 indexStack.append(0);
                 propertyStack.append(PropertyNameArray(m_exec));
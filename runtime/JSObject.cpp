@@ -531,6 +531,16 @@ Structure* JSObject::createInheritorID()
     return m_inheritorID.get();
 }
 
+Structure* JSObject::growInheritorID()
+{
+    // Objects that started out with the old Structure keep it, and its transitions.
+    size_t cellSize = Heap::cellSizeFor(allocationSize(m_inheritorID->observedPropertyStorageSize()));
+    unsigned capacity = inlineStorageCapacity + (cellSize - sizeof(JSObject)) / sizeof(EncodedJSValue);
+    ASSERT(capacity > m_inheritorID->inlineStorageCapacity() && capacity <= maxInlineStorageCapacity());
+    m_inheritorID = Structure::createWithInlineStorageCapacity(this, TypeInfo(ObjectType, StructureFlags), AnonymousSlotCount, capacity);
+    return m_inheritorID.get();
+}
+
 void JSObject::allocatePropertyStorage(size_t oldSize, size_t newSize)
 {
     allocatePropertyStorageInline(oldSize, newSize);
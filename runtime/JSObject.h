@@ -90,6 +90,10 @@ namespace JSC {
         
         void setStructure(NonNullPassRefPtr<Structure>);
         Structure* inheritorID();
+        // The Structure that objects constructed with this object as their
+        // prototype start out with. Once they are seen to need more storage than
+        // it has inline, it is replaced by one that has room for all of it.
+        Structure* inheritorIDForConstruction();
 
         virtual UString className() const;
 
@@ -184,7 +188,11 @@ namespace JSC {
 
         // Fast access to known property offsets.
         JSValue getDirectOffset(size_t offset) const { return JSValue::decode(propertyStorage()[offset]); }
-        void putDirectOffset(size_t offset, JSValue value) { propertyStorage()[offset] = JSValue::encode(value); }
+        void putDirectOffset(size_t offset, JSValue value)
+        {
+            propertyStorage()[offset] = JSValue::encode(value);
+            Heap::writeBarrier(this, value);
+        }
 
         void fillGetterPropertySlot(PropertySlot&, JSValue* location);
 
@@ -208,6 +216,11 @@ namespace JSC {
         static const unsigned inlineStorageCapacity = sizeof(EncodedJSValue) == 2 * sizeof(void*) ? 4 : 3;
         static const unsigned nonInlineBaseStorageCapacity = 16;
 
+        // A plain JSObject may be allocated in a larger cell, with the rest of the
+        // cell holding more of its properties inline.
+        static size_t allocationSize(unsigned capacity) { return sizeof(JSObject) + (capacity - inlineStorageCapacity) * sizeof(EncodedJSValue); }
+        static unsigned maxInlineStorageCapacity() { return inlineStorageCapacity + (LARGE_CELL_SIZE - sizeof(JSObject)) / sizeof(EncodedJSValue); }
+
         static PassRefPtr<Structure> createStructure(JSValue prototype)
         {
             return Structure::create(prototype, TypeInfo(ObjectType, StructureFlags), AnonymousSlotCount);
@@ -225,6 +238,7 @@ namespace JSC {
         {
             ASSERT(index < m_structure->anonymousSlotCount());
             *locationForOffset(index) = value;
+            Heap::writeBarrier(this, value);
         }
         JSValue getAnonymousValue(unsigned index) const
         {
@@ -266,13 +280,15 @@ namespace JSC {
 
         const HashEntry* findPropertyHashEntry(ExecState*, const Identifier& propertyName) const;
         Structure* createInheritorID();
+        Structure* growInheritorID();
+
+        RefPtr<Structure> m_inheritorID;
 
+        // Last, so that inline storage can run on into the rest of a larger cell.
         union {
             PropertyStorage m_externalStorage;
             EncodedJSValue m_inlineStorage[inlineStorageCapacity];
         };
-
-        RefPtr<Structure> m_inheritorID;
     };
     
 inline JSObject* asObject(JSCell* cell)
@@ -289,7 +305,7 @@ inline JSObject* asObject(JSValue value)
 inline JSObject::JSObject(NonNullPassRefPtr<Structure> structure)
     : JSCell(structure.releaseRef()) // ~JSObject balances this ref()
 {
-    ASSERT(m_structure->propertyStorageCapacity() == inlineStorageCapacity);
+    ASSERT(m_structure->isUsingInlineStorage());
     ASSERT(m_structure->isEmpty());
     ASSERT(prototype().isNull() || Heap::heap(this) == Heap::heap(prototype()));
 #if USE(JSVALUE64) || USE(JSVALUE32_64)
@@ -315,6 +331,7 @@ inline void JSObject::setPrototype(JSValue prototype)
     ASSERT(prototype);
     RefPtr<Structure> newStructure = Structure::changePrototypeTransition(m_structure, prototype);
     setStructure(newStructure.release());
+    Heap::writeBarrier(this, prototype);
 }
 
 inline void JSObject::setStructure(NonNullPassRefPtr<Structure> structure)
@@ -330,9 +347,28 @@ inline Structure* JSObject::inheritorID()
     return createInheritorID();
 }
 
+inline Structure* JSObject::inheritorIDForConstruction()
+{
+    Structure* structure = inheritorID();
+    if (LIKELY(structure->observedPropertyStorageSize() <= structure->inlineStorageCapacity()))
+        return structure;
+    return growInheritorID();
+}
+
+// Allocates a plain object in a cell with room for its Structure's inline storage.
+inline JSObject* constructObject(JSGlobalData* globalData, Structure* structure)
+{
+    return new (globalData->heap.allocate(JSObject::allocationSize(structure->inlineStorageCapacity()))) JSObject(structure);
+}
+
+inline PassRefPtr<Structure> Structure::create(JSValue prototype, const TypeInfo& typeInfo, unsigned anonymousSlotCount)
+{
+    return adoptRef(new Structure(prototype, typeInfo, anonymousSlotCount, JSObject::inlineStorageCapacity));
+}
+
 inline bool Structure::isUsingInlineStorage() const
 {
-    return (propertyStorageCapacity() == JSObject::inlineStorageCapacity);
+    return propertyStorageCapacity() == inlineStorageCapacity();
 }
 
 inline bool JSCell::inherits(const ClassInfo* info) const
@@ -697,9 +733,9 @@ ALWAYS_INLINE void JSObject::allocatePropertyStorageInline(size_t oldSize, size_
 {
     ASSERT(newSize > oldSize);
 
-    // It's important that this function not rely on m_structure, since
-    // we might be in the middle of a transition.
-    bool wasInline = (oldSize == JSObject::inlineStorageCapacity);
+    // We might be in the middle of a transition, but both sides of it have
+    // the same inline storage capacity.
+    bool wasInline = (oldSize == m_structure->inlineStorageCapacity());
 
     PropertyStorage oldPropertyStorage = (wasInline ? m_inlineStorage : m_externalStorage);
     PropertyStorage newPropertyStorage = new EncodedJSValue[newSize];
@@ -721,7 +757,7 @@ ALWAYS_INLINE void JSObject::markChildrenDirect(MarkStack& markStack)
     
     PropertyStorage storage = propertyStorage();
     size_t storageSize = m_structure->propertyStorageSize();
-    markStack.appendValues(reinterpret_cast<JSValue*>(storage), storageSize);
+    markStack.appendSlots(reinterpret_cast<JSValue*>(storage), storageSize);
 }
 
 // --- JSValue inlines ----------------------------
@@ -43,8 +43,11 @@ inline JSPropertyNameIterator::JSPropertyNameIterator(ExecState* exec, PropertyN
     , m_jsStrings(new JSValue[m_jsStringsSize])
 {
     PropertyNameArrayData::PropertyNameVector& propertyNameVector = propertyNameArrayData->propertyNameVector();
-    for (size_t i = 0; i < m_jsStringsSize; ++i)
+    for (size_t i = 0; i < m_jsStringsSize; ++i) {
         m_jsStrings[i] = jsOwnedString(exec, propertyNameVector[i].ustring());
+        // Allocating the strings can collect, after which this iterator is old.
+        Heap::writeBarrier(this, m_jsStrings[i]);
+    }
 }
 
 JSPropertyNameIterator::~JSPropertyNameIterator()
@@ -308,6 +308,8 @@ namespace JSC {
             // nasty hack because we can't union non-POD types
             m_other.m_finalizerCallback = finalizer;
             m_other.m_finalizerContext = context;
+            // The finalizer is handed the string's address.
+            Heap::pinCell(this);
             Heap::heap(this)->reportExtraMemoryCost(value.cost());
         }
 
@@ -132,6 +132,7 @@ namespace JSC {
         if (entry.isReadOnly())
             return true;
         registerAt(entry.getIndex()) = value;
+        Heap::writeBarrier(this, value);
         return true;
     }
 
@@ -146,6 +147,7 @@ namespace JSC {
         ASSERT(!entry.isNull());
         entry.setAttributes(attributes);
         registerAt(entry.getIndex()) = value;
+        Heap::writeBarrier(this, value);
         return true;
     }
 
@@ -162,6 +164,7 @@ namespace JSC {
         ASSERT(registerArray != d->registerArray.get());
         d->registerArray.set(registerArray);
         d->registers = registers;
+        Heap::writeBarrier(this);
     }
 
 } // namespace JSC
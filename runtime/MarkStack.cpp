@@ -26,10 +26,290 @@
 #include "config.h"
 #include "MarkStack.h"
 
+#include "JSArray.h"
+#include <wtf/CurrentTime.h>
+#include <wtf/Threading.h>
+#include <wtf/Vector.h>
+
+using std::max;
+using std::min;
+
 namespace JSC {
 
 size_t MarkStack::s_pageSize = 0;
 
+// How many cells drainUntil() visits between looks at the clock.
+static const unsigned deadlineCheckInterval = 128;
+
+#if ENABLE(PARALLEL_GC)
+
+// Marking rarely scales beyond this many threads, so use no more by default.
+static const unsigned maximumDefaultNumberOfMarkingThreads = 8;
+
+// How many cells a marker visits between checks for idle markers to donate work to.
+static const unsigned donationInterval = 64;
+
+// Mark sets shorter than this are not worth splitting to donate half.
+static const size_t minimumMarkSetSplitSize = 128;
+
+// The helper threads for drainInParallel(). Each thread drains its own
+// MarkStack. Whenever some marker is idle, busy markers donate half of their
+// work to a shared pool that idle markers steal from. Marking is complete once
+// the pool is empty and no marker is busy.
+class MarkStack::MarkingThreads : public Noncopyable {
+public:
+    MarkingThreads(void* jsArrayVPtr, unsigned numberOfHelpers)
+        : m_jsArrayVPtr(jsArrayVPtr)
+        , m_requestedNumberOfHelpers(numberOfHelpers)
+        , m_numberOfMarkers(1)
+        , m_busyMarkers(0)
+        , m_runningHelpers(0)
+        , m_markingGeneration(0)
+        , m_isEvacuating(false)
+        , m_shouldExit(false)
+    {
+        for (unsigned i = 0; i < numberOfHelpers; ++i) {
+            if (ThreadIdentifier thread = createThread(markingThreadMain, this, "JavaScriptCore::Marking"))
+                m_threads.append(thread);
+        }
+        m_numberOfMarkers += m_threads.size();
+    }
+
+    ~MarkingThreads()
+    {
+        {
+            MutexLocker locker(m_lock);
+            m_shouldExit = true;
+            m_markingStarted.broadcast();
+        }
+        for (size_t i = 0; i < m_threads.size(); ++i)
+            waitForThreadCompletion(m_threads[i], 0);
+    }
+
+    unsigned requestedNumberOfHelpers() const { return m_requestedNumberOfHelpers; }
+    bool hasHelpers() const { return !m_threads.isEmpty(); }
+
+    bool hasIdleMarkers() const { return m_busyMarkers < m_numberOfMarkers; }
+    bool hasSharedWork() { return !m_sharedMarkSets.isEmpty() || !m_sharedValues.isEmpty(); }
+
+    void startMarking(bool isEvacuating)
+    {
+        MutexLocker locker(m_lock);
+        m_isEvacuating = isEvacuating;
+        m_busyMarkers = m_numberOfMarkers;
+        m_runningHelpers = m_threads.size();
+        ++m_markingGeneration;
+        m_markingStarted.broadcast();
+    }
+
+    void waitForHelpers()
+    {
+        MutexLocker locker(m_lock);
+        while (m_runningHelpers)
+            m_helpersFinished.wait(m_lock);
+        ASSERT(!hasSharedWork());
+    }
+
+    void* m_jsArrayVPtr;
+    unsigned m_requestedNumberOfHelpers;
+    Vector<ThreadIdentifier> m_threads;
+    unsigned m_numberOfMarkers; // Including the collecting thread.
+
+    Mutex m_lock;
+    ThreadCondition m_markingStarted;
+    ThreadCondition m_workAvailable; // Also signalled once marking is complete.
+    ThreadCondition m_helpersFinished;
+    MarkStackArray<MarkSet> m_sharedMarkSets;
+    MarkStackArray<JSCell*> m_sharedValues;
+    volatile unsigned m_busyMarkers; // Read without the lock to decide whether to donate.
+    unsigned m_runningHelpers;
+    unsigned m_markingGeneration;
+    bool m_isEvacuating;
+    Vector<JSValue*> m_slotsToUpdate; // Recorded by the helpers while evacuating.
+    bool m_shouldExit;
+};
+
+void* MarkStack::markingThreadMain(void* argument)
+{
+    MarkingThreads* threads = static_cast<MarkingThreads*>(argument);
+    MarkStack markStack(threads->m_jsArrayVPtr);
+    unsigned markingGeneration = 0;
+
+    threads->m_lock.lock();
+    while (true) {
+        while (markingGeneration == threads->m_markingGeneration && !threads->m_shouldExit)
+            threads->m_markingStarted.wait(threads->m_lock);
+        if (threads->m_shouldExit)
+            break;
+        markingGeneration = threads->m_markingGeneration;
+        markStack.setEvacuating(threads->m_isEvacuating);
+        threads->m_lock.unlock();
+
+        markStack.drainSharingWork(*threads);
+        markStack.compact();
+
+        threads->m_lock.lock();
+        threads->m_slotsToUpdate.append(markStack.m_slotsToUpdate.data(), markStack.m_slotsToUpdate.size());
+        markStack.m_slotsToUpdate.clear();
+        if (!--threads->m_runningHelpers)
+            threads->m_helpersFinished.signal();
+    }
+    threads->m_lock.unlock();
+    return 0;
+}
+
+void MarkStack::drainSharingWork(MarkingThreads& threads)
+{
+    do {
+        unsigned visitedCells = 0;
+        while (!m_markSets.isEmpty() || !m_values.isEmpty()) {
+            if (!m_values.isEmpty())
+                markChildren(m_values.removeLast());
+            else {
+                MarkSet& current = m_markSets.last();
+                JSValue* slot = current.m_values++;
+                JSValue* updatableSlot = current.m_slotsAreUpdatable ? slot : 0;
+                if (current.m_values == current.m_end)
+                    m_markSets.removeLast();
+
+                JSValue value = *slot;
+                JSCell* cell;
+                if (value && value.isCell() && !testAndSetMarked(cell = value.asCell(), updatableSlot) && cell->structure()->typeInfo().type() >= CompoundType)
+                    markChildren(cell);
+            }
+
+            if (!(++visitedCells % donationInterval) && threads.hasIdleMarkers())
+                donateWork(threads);
+        }
+    } while (stealWork(threads));
+}
+
+void MarkStack::donateWork(MarkingThreads& threads)
+{
+    MutexLocker locker(threads.m_lock);
+    if (threads.hasSharedWork())
+        return;
+
+    for (size_t count = m_values.size() / 2; count; --count)
+        threads.m_sharedValues.append(m_values.removeLast());
+
+    if (!m_markSets.isEmpty()) {
+        MarkSet& current = m_markSets.last();
+        size_t size = current.m_end - current.m_values;
+        if (size >= minimumMarkSetSplitSize) {
+            JSValue* middle = current.m_values + size / 2;
+            threads.m_sharedMarkSets.append(MarkSet(middle, current.m_end, current.m_properties, current.m_slotsAreUpdatable));
+            current.m_end = middle;
+        }
+    }
+
+    if (threads.hasSharedWork())
+        threads.m_workAvailable.broadcast();
+}
+
+bool MarkStack::stealWork(MarkingThreads& threads)
+{
+    MutexLocker locker(threads.m_lock);
+    --threads.m_busyMarkers;
+    while (true) {
+        if (threads.hasSharedWork()) {
+            if (!threads.m_sharedMarkSets.isEmpty())
+                m_markSets.append(threads.m_sharedMarkSets.removeLast());
+            // Leave some of the cells for the other idle markers.
+            size_t count = (threads.m_sharedValues.size() + threads.m_numberOfMarkers - 1) / threads.m_numberOfMarkers;
+            while (count--)
+                m_values.append(threads.m_sharedValues.removeLast());
+            ++threads.m_busyMarkers;
+            return true;
+        }
+        if (!threads.m_busyMarkers) {
+            threads.m_workAvailable.broadcast();
+            return false;
+        }
+        threads.m_workAvailable.wait(threads.m_lock);
+    }
+}
+
+unsigned MarkStack::defaultNumberOfMarkingThreads()
+{
+    return max(1u, min(numberOfProcessors(), maximumDefaultNumberOfMarkingThreads));
+}
+
+#else
+
+unsigned MarkStack::defaultNumberOfMarkingThreads()
+{
+    return 1;
+}
+
+#endif // ENABLE(PARALLEL_GC)
+
+void MarkStack::drainInParallel(unsigned numberOfThreads)
+{
+#if ENABLE(PARALLEL_GC)
+    if (numberOfThreads > 1) {
+        if (!m_markingThreads || m_markingThreads->requestedNumberOfHelpers() != numberOfThreads - 1) {
+            delete m_markingThreads;
+            m_markingThreads = new MarkingThreads(m_jsArrayVPtr, numberOfThreads - 1);
+        }
+        if (m_markingThreads->hasHelpers()) {
+            m_markingThreads->startMarking(m_isEvacuating);
+            drainSharingWork(*m_markingThreads);
+            m_markingThreads->waitForHelpers();
+            m_slotsToUpdate.append(m_markingThreads->m_slotsToUpdate.data(), m_markingThreads->m_slotsToUpdate.size());
+            m_markingThreads->m_slotsToUpdate.clear();
+            return;
+        }
+    }
+#else
+    UNUSED_PARAM(numberOfThreads);
+#endif
+    drain();
+}
+
+bool MarkStack::drainUntil(double deadline)
+{
+    for (unsigned count = 1; ; ++count) {
+        if (!m_values.isEmpty())
+            markChildren(m_values.removeLast());
+        else if (!m_markSets.isEmpty())
+            flattenMarkSet();
+        else
+            return true;
+
+        if (!(count % deadlineCheckInterval) && currentTime() >= deadline)
+            break;
+    }
+
+    // Mark sets point into storage that the mutator may reallocate before the
+    // next slice, so only cells are left on the stack.
+    while (!m_markSets.isEmpty())
+        flattenMarkSet();
+    return false;
+}
+
+void MarkStack::flattenMarkSet()
+{
+    MarkSet set = m_markSets.removeLast();
+    for (JSValue* it = set.m_values; it != set.m_end; ++it) {
+        JSValue value = *it;
+        JSCell* cell;
+        if (!value || !value.isCell() || testAndSetMarked(cell = value.asCell(), set.m_slotsAreUpdatable ? it : 0))
+            continue;
+        if (cell->structure()->typeInfo().type() >= CompoundType)
+            m_values.append(cell);
+    }
+}
+
+MarkStack::~MarkStack()
+{
+    ASSERT(m_markSets.isEmpty());
+    ASSERT(m_values.isEmpty());
+#if ENABLE(PARALLEL_GC)
+    delete m_markingThreads;
+#endif
+}
+
 void MarkStack::compact()
 {
     ASSERT(s_pageSize);
@@ -28,6 +28,7 @@
 
 #include "JSValue.h"
 #include <wtf/Noncopyable.h>
+#include <wtf/Vector.h>
 
 namespace JSC {
 
@@ -40,6 +41,10 @@ namespace JSC {
     public:
         MarkStack(void* jsArrayVPtr)
             : m_jsArrayVPtr(jsArrayVPtr)
+            , m_isEvacuating(false)
+#if ENABLE(PARALLEL_GC)
+            , m_markingThreads(0)
+#endif
 #ifndef NDEBUG
             , m_isCheckingForDefaultMarkViolation(false)
 #endif
@@ -57,38 +62,63 @@ namespace JSC {
         ALWAYS_INLINE void appendValues(JSValue* values, size_t count, MarkSetProperties properties = NoNullValues)
         {
             if (count)
-                m_markSets.append(MarkSet(values, values + count, properties));
+                m_markSets.append(MarkSet(values, values + count, properties, false));
         }
 
+        // Like appendValues(), but for values held in a cell's own storage, which
+        // the collector may update in place if the cells they point to move.
+        ALWAYS_INLINE void appendSlots(JSValue* values, size_t count, MarkSetProperties properties = NoNullValues)
+        {
+            if (count)
+                m_markSets.append(MarkSet(values, values + count, properties, true));
+        }
+
+        // While evacuating, references found through appendSlots() are recorded
+        // so they can be updated, and any other reference pins its cell.
+        void setEvacuating(bool isEvacuating) { m_isEvacuating = isEvacuating; }
+        Vector<JSValue*>& slotsToUpdate() { return m_slotsToUpdate; }
+
         inline void drain();
+        // Like drain(), but with numberOfThreads - 1 helper threads stealing work
+        // from the calling thread, if parallel marking is available.
+        void drainInParallel(unsigned numberOfThreads);
+        // Drains until the stack is empty, returning true, or until currentTime()
+        // passes the deadline, returning false with only cells left on the stack.
+        bool drainUntil(double deadline);
         void compact();
 
-        ~MarkStack()
-        {
-            ASSERT(m_markSets.isEmpty());
-            ASSERT(m_values.isEmpty());
-        }
+        static unsigned defaultNumberOfMarkingThreads();
+
+        ~MarkStack();
 
     private:
         void markChildren(JSCell*);
+        void flattenMarkSet(); // Pushes the unmarked cells of the top mark set.
 
         struct MarkSet {
-            MarkSet(JSValue* values, JSValue* end, MarkSetProperties properties)
+            MarkSet(JSValue* values, JSValue* end, MarkSetProperties properties, bool slotsAreUpdatable)
                 : m_values(values)
                 , m_end(end)
                 , m_properties(properties)
+                , m_slotsAreUpdatable(slotsAreUpdatable)
             {
                 ASSERT(values);
             }
             JSValue* m_values;
             JSValue* m_end;
             MarkSetProperties m_properties;
+            bool m_slotsAreUpdatable;
         };
 
+        // A null slot pins the cell.
+        void noteReference(JSCell*, JSValue* slot);
+        bool testAndSetMarked(JSCell*, JSValue* slot);
+
         static void* allocateStack(size_t size);
         static void releaseStack(void* addr, size_t size);
 
         static void initializePagesize();
+        static unsigned numberOfProcessors();
         static size_t pageSize()
         {
             if (!s_pageSize)
@@ -172,9 +202,22 @@ namespace JSC {
             T* m_data;
         };
 
+#if ENABLE(PARALLEL_GC)
+        class MarkingThreads;
+        static void* markingThreadMain(void*);
+        void drainSharingWork(MarkingThreads&);
+        void donateWork(MarkingThreads&);
+        bool stealWork(MarkingThreads&);
+#endif
+
         void* m_jsArrayVPtr;
         MarkStackArray<MarkSet> m_markSets;
         MarkStackArray<JSCell*> m_values;
+        bool m_isEvacuating;
+        Vector<JSValue*> m_slotsToUpdate;
+#if ENABLE(PARALLEL_GC)
+        MarkingThreads* m_markingThreads; // Only used by the collecting thread's MarkStack.
+#endif
         static size_t s_pageSize;
 
 #ifndef NDEBUG
@@ -36,6 +36,11 @@ void MarkStack::initializePagesize()
     MarkStack::s_pageSize = 4096;
 }
 
+unsigned MarkStack::numberOfProcessors()
+{
+    return 1;
+}
+
 void* MarkStack::allocateStack(size_t size)
 {
     return fastMalloc(size);
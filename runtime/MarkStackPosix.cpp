@@ -38,6 +38,12 @@ void MarkStack::initializePagesize()
     MarkStack::s_pageSize = getpagesize();
 }
 
+unsigned MarkStack::numberOfProcessors()
+{
+    long result = sysconf(_SC_NPROCESSORS_ONLN);
+    return result > 0 ? static_cast<unsigned>(result) : 1;
+}
+
 void* MarkStack::allocateStack(size_t size)
 {
     return mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
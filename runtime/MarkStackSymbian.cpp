@@ -33,6 +33,11 @@ void MarkStack::initializePagesize()
     MarkStack::s_pageSize = page_size;
 }
 
+unsigned MarkStack::numberOfProcessors()
+{
+    return 1;
+}
+
 void* MarkStack::allocateStack(size_t size)
 {
     return fastMalloc(size);
@@ -39,6 +39,13 @@ void MarkStack::initializePagesize()
     MarkStack::s_pageSize = system_info.dwPageSize;
 }
 
+unsigned MarkStack::numberOfProcessors()
+{
+    SYSTEM_INFO system_info;
+    GetSystemInfo(&system_info);
+    return system_info.dwNumberOfProcessors;
+}
+
 void* MarkStack::allocateStack(size_t size)
 {
     return VirtualAlloc(0, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
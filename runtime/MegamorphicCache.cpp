@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2010 Apple Inc. All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY APPLE INC. ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL APPLE INC. OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+#include "MegamorphicCache.h"
+
+#include "JSObject.h"
+
+namespace JSC {
+
+// Out of line, where Structure is a complete type.
+MegamorphicCache::MegamorphicCache()
+{
+}
+
+MegamorphicCache::~MegamorphicCache()
+{
+}
+
+bool MegamorphicCache::get(JSCell* base, const Identifier& propertyName, JSValue& result)
+{
+    Structure* structure = base->structure();
+    CacheEntry& entry = lookup(structure, propertyName.ustring().rep());
+    if (entry.structure != structure || entry.propertyName != propertyName.ustring().rep())
+        return false;
+
+    result = asObject(base)->getDirectOffset(entry.offset);
+    return true;
+}
+
+void MegamorphicCache::add(JSValue base, const Identifier& propertyName, const PropertySlot& slot)
+{
+    if (!base.isCell() || !slot.isCacheableValue() || slot.slotBase() != base)
+        return;
+
+    // Dictionaries change their property maps without changing Structure.
+    Structure* structure = asCell(base)->structure();
+    if (structure->isDictionary())
+        return;
+
+    CacheEntry& entry = lookup(structure, propertyName.ustring().rep());
+    entry.structure = structure;
+    entry.propertyName = propertyName.ustring().rep();
+    entry.offset = slot.cachedOffset();
+}
+
+void MegamorphicCache::clear()
+{
+    for (size_t i = 0; i < cacheSize; ++i) {
+        m_entries[i].structure = 0;
+        m_entries[i].propertyName = 0;
+    }
+}
+
+} // namespace JSC
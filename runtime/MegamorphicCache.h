@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2010 Apple Inc. All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY APPLE INC. ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL APPLE INC. OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef MegamorphicCache_h
+#define MegamorphicCache_h
+
+#include "UString.h"
+#include <wtf/HashFunctions.h>
+#include <wtf/Noncopyable.h>
+#include <wtf/RefPtr.h>
+
+namespace JSC {
+
+    class Identifier;
+    class JSCell;
+    class JSValue;
+    class PropertySlot;
+    class Structure;
+
+    // Remembers where objects keep their own properties, by Structure and
+    // property name, for property accesses that have seen too many Structures
+    // to keep a stub for each. Entries hold on to their Structure and name, so
+    // neither can be reused for something else while cached.
+    class MegamorphicCache : public Noncopyable {
+    public:
+        MegamorphicCache();
+        ~MegamorphicCache();
+
+        // Loads the property from base if its Structure is cached.
+        bool get(JSCell* base, const Identifier& propertyName, JSValue& result);
+
+        // Caches the result of a full lookup, if it found a plain value in base itself.
+        void add(JSValue base, const Identifier& propertyName, const PropertySlot&);
+
+        // Releases every entry; the names must go before the identifier table does.
+        void clear();
+
+    private:
+        static const size_t cacheSize = 512;
+
+        struct CacheEntry {
+            RefPtr<Structure> structure;
+            RefPtr<UString::Rep> propertyName;
+            size_t offset;
+        };
+
+        CacheEntry& lookup(Structure* structure, UString::Rep* propertyName)
+        {
+            return m_entries[(WTF::PtrHash<Structure*>::hash(structure) + propertyName->existingHash()) & (cacheSize - 1)];
+        }
+
+        CacheEntry m_entries[cacheSize];
+    };
+
+} // namespace JSC
+
+#endif // MegamorphicCache_h
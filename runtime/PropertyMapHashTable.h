@@ -56,7 +56,13 @@ namespace JSC {
     // were inserted into the property map. It's required that getEnumerablePropertyNames
     // return the properties in the order they were added for compatibility with other
     // browsers' JavaScript implementations.
+    //
+    // A table is shared by the Structures of a transition chain. New entries are
+    // only ever appended while it is shared, and each Structure sees the entries
+    // up to the count it had when it last used the table, so the entries a
+    // Structure sees are a prefix of those of the Structures after it.
     struct PropertyMapHashTable {
+        unsigned refCount;
         unsigned sizeMask;
         unsigned size;
         unsigned keyCount;
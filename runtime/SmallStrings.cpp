@@ -36,7 +36,7 @@ static const unsigned numCharactersToStore = 0x100;
 
 static inline bool isMarked(JSString* string)
 {
-    return string && Heap::isCellMarked(string);
+    return string && Heap::isCellMarkedByCollection(string);
 }
 
 class SmallStringsStorage : public Noncopyable {
@@ -187,6 +187,7 @@ void Structure::dumpStatistics()
     unsigned numberSingletons = 0;
     unsigned numberWithPropertyMaps = 0;
     unsigned totalPropertyMapsSize = 0;
+    HashSet<PropertyMapHashTable*> propertyMaps;
 
     HashSet<Structure*>::const_iterator end = liveStructureSet.end();
     for (HashSet<Structure*>::const_iterator it = liveStructureSet.begin(); it != end; ++it) {
@@ -203,6 +204,8 @@ void Structure::dumpStatistics()
 
         if (structure->m_propertyTable) {
             ++numberWithPropertyMaps;
+            if (!propertyMaps.add(structure->m_propertyTable).second)
+                continue;
             totalPropertyMapsSize += PropertyMapHashTable::allocationSize(structure->m_propertyTable->size);
             if (structure->m_propertyTable->deletedOffsets)
                 totalPropertyMapsSize += (structure->m_propertyTable->deletedOffsets->capacity() * sizeof(unsigned)); 
@@ -223,15 +226,18 @@ void Structure::dumpStatistics()
 #endif
 }
 
-Structure::Structure(JSValue prototype, const TypeInfo& typeInfo, unsigned anonymousSlotCount)
+Structure::Structure(JSValue prototype, const TypeInfo& typeInfo, unsigned anonymousSlotCount, unsigned inlineStorageCapacity)
     : m_typeInfo(typeInfo)
+    , m_arrayElementKind(Int32ArrayElements)
     , m_prototype(prototype)
     , m_specificValueInPrevious(0)
     , m_propertyTable(0)
-    , m_propertyStorageCapacity(JSObject::inlineStorageCapacity)
+    , m_propertyTableEntryCount(0)
+    , m_propertyStorageCapacity(inlineStorageCapacity)
+    , m_inlineStorageCapacity(inlineStorageCapacity)
+    , m_observedPropertyStorageSize(anonymousSlotCount)
     , m_offset(noOffset)
     , m_dictionaryKind(NoneDictionaryKind)
-    , m_isPinnedPropertyTable(false)
     , m_hasGetterSetterProperties(false)
     , m_attributesInPrevious(0)
     , m_specificFunctionThrashCount(0)
@@ -243,6 +249,10 @@ Structure::Structure(JSValue prototype, const TypeInfo& typeInfo, unsigned anony
     ASSERT(m_prototype);
     ASSERT(m_prototype.isObject() || m_prototype.isNull());
 
+    // Property caches keyed on a Structure hold on to its prototype.
+    if (m_prototype.isCell())
+        Heap::pinCell(m_prototype.asCell());
+
 #ifndef NDEBUG
 #if ENABLE(JSC_MULTIPLE_THREADS)
     MutexLocker protect(ignoreSetMutex);
@@ -258,6 +268,21 @@ Structure::Structure(JSValue prototype, const TypeInfo& typeInfo, unsigned anony
 #endif
 }
 
+static void derefPropertyTable(PropertyMapHashTable* table)
+{
+    if (--table->refCount)
+        return;
+
+    unsigned entryCount = table->keyCount + table->deletedSentinelCount;
+    for (unsigned i = 1; i <= entryCount; i++) {
+        if (UString::Rep* key = table->entries()[i].key)
+            key->deref();
+    }
+
+    delete table->deletedOffsets;
+    fastFree(table);
+}
+
 Structure::~Structure()
 {
     if (m_previous) {
@@ -267,16 +292,8 @@ Structure::~Structure()
     }
     ASSERT(!m_enumerationCache.hasDeadObject());
 
-    if (m_propertyTable) {
-        unsigned entryCount = m_propertyTable->keyCount + m_propertyTable->deletedSentinelCount;
-        for (unsigned i = 1; i <= entryCount; i++) {
-            if (UString::Rep* key = m_propertyTable->entries()[i].key)
-                key->deref();
-        }
-
-        delete m_propertyTable->deletedOffsets;
-        fastFree(m_propertyTable);
-    }
+    if (m_propertyTable)
+        derefPropertyTable(m_propertyTable);
 
     if (!m_isUsingSingleSlot)
         delete transitionTable();
@@ -357,24 +374,24 @@ void Structure::materializePropertyMap()
 
     Structure* structure = this;
 
-    // Search for the last Structure with a property table. 
+    // Search for the last Structure with a property table, so that only the
+    // transitions after it are replayed, however long the chain is.
     while ((structure = structure->previousID())) {
-        if (structure->m_isPinnedPropertyTable) {
-            ASSERT(structure->m_propertyTable);
-            ASSERT(!structure->m_previous);
+        structures.append(structure);
 
-            m_propertyTable = structure->copyPropertyTable();
+        if (structure->m_propertyTable) {
+            sharePropertyTable(structure);
             break;
         }
-
-        structures.append(structure);
     }
 
     if (!m_propertyTable)
         createPropertyMapHashTable(sizeForKeyCount(m_offset + 1));
     else {
-        if (sizeForKeyCount(m_offset + 1) > m_propertyTable->size)
-            rehashPropertyMapHashTable(sizeForKeyCount(m_offset + 1)); // This could be made more efficient by combining with the copy above. 
+        prepareToAppendToPropertyTable();
+        // The entries are replayed after the last one, without reusing deleted ones.
+        if (m_propertyTable->deletedSentinelCount || sizeForKeyCount(m_offset + 1) > m_propertyTable->size)
+            rehashPropertyMapHashTable(max(m_propertyTable->size, sizeForKeyCount(m_offset + 1)));
     }
 
     for (ptrdiff_t i = structures.size() - 2; i >= 0; --i) {
@@ -387,8 +404,8 @@ void Structure::materializePropertyMap()
 
 void Structure::growPropertyStorageCapacity()
 {
-    if (m_propertyStorageCapacity == JSObject::inlineStorageCapacity)
-        m_propertyStorageCapacity = JSObject::nonInlineBaseStorageCapacity;
+    if (m_propertyStorageCapacity == m_inlineStorageCapacity)
+        m_propertyStorageCapacity = max(JSObject::nonInlineBaseStorageCapacity, 2 * m_inlineStorageCapacity);
     else
         m_propertyStorageCapacity *= 2;
 }
@@ -402,6 +419,8 @@ void Structure::despecifyDictionaryFunction(const Identifier& propertyName)
     ASSERT(isDictionary());
     ASSERT(m_propertyTable);
 
+    prepareToModifyPropertyTable();
+
     unsigned i = rep->existingHash();
 
 #if DUMP_PROPERTYMAP_STATS
@@ -483,23 +502,19 @@ PassRefPtr<Structure> Structure::addPropertyTransition(Structure* structure, con
     transition->m_attributesInPrevious = attributes;
     transition->m_specificValueInPrevious = specificValue;
     transition->m_propertyStorageCapacity = structure->m_propertyStorageCapacity;
+    transition->m_inlineStorageCapacity = structure->m_inlineStorageCapacity;
+    transition->m_arrayElementKind = structure->m_arrayElementKind;
     transition->m_hasGetterSetterProperties = structure->m_hasGetterSetterProperties;
     transition->m_hasNonEnumerableProperties = structure->m_hasNonEnumerableProperties;
     transition->m_specificFunctionThrashCount = structure->m_specificFunctionThrashCount;
 
-    if (structure->m_propertyTable) {
-        if (structure->m_isPinnedPropertyTable)
-            transition->m_propertyTable = structure->copyPropertyTable();
-        else {
-            transition->m_propertyTable = structure->m_propertyTable;
-            structure->m_propertyTable = 0;
-        }
-    } else {
-        if (structure->m_previous)
-            transition->materializePropertyMap();
-        else
-            transition->createPropertyMapHashTable();
-    }
+    // The transition appends its property to the table in place if it is the first
+    // to extend structure, so a chain of transitions shares a single table.
+    structure->materializePropertyMapIfNecessary();
+    if (structure->m_propertyTable)
+        transition->sharePropertyTable(structure);
+    else
+        transition->createPropertyMapHashTable();
 
     offset = transition->put(propertyName, attributes, specificValue);
     ASSERT(offset >= structure->m_anonymousSlotCount);
@@ -510,6 +525,16 @@ PassRefPtr<Structure> Structure::addPropertyTransition(Structure* structure, con
     transition->m_offset = offset - structure->m_anonymousSlotCount;
     ASSERT(structure->anonymousSlotCount() == transition->anonymousSlotCount());
     structure->transitionTableAdd(make_pair(propertyName.ustring().rep(), attributes), transition.get(), specificValue);
+
+    // Let the Structure objects are allocated with learn how much storage they go on
+    // to need. Past the most they could hold inline, that has been recorded already.
+    if (transition->propertyStorageSize() <= JSObject::maxInlineStorageCapacity()) {
+        Structure* root = structure;
+        while (root->m_previous)
+            root = root->m_previous.get();
+        root->m_observedPropertyStorageSize = max(root->m_observedPropertyStorageSize, transition->propertyStorageSize());
+    }
+
     return transition.release();
 }
 
@@ -531,6 +556,8 @@ PassRefPtr<Structure> Structure::changePrototypeTransition(Structure* structure,
     RefPtr<Structure> transition = create(prototype, structure->typeInfo(), structure->anonymousSlotCount());
 
     transition->m_propertyStorageCapacity = structure->m_propertyStorageCapacity;
+    transition->m_inlineStorageCapacity = structure->m_inlineStorageCapacity;
+    transition->m_arrayElementKind = structure->m_arrayElementKind;
     transition->m_hasGetterSetterProperties = structure->m_hasGetterSetterProperties;
     transition->m_hasNonEnumerableProperties = structure->m_hasNonEnumerableProperties;
     transition->m_specificFunctionThrashCount = structure->m_specificFunctionThrashCount;
@@ -538,8 +565,7 @@ PassRefPtr<Structure> Structure::changePrototypeTransition(Structure* structure,
     // Don't set m_offset, as one can not transition to this.
 
     structure->materializePropertyMapIfNecessary();
-    transition->m_propertyTable = structure->copyPropertyTable();
-    transition->m_isPinnedPropertyTable = true;
+    transition->sharePropertyTable(structure);
     
     ASSERT(structure->anonymousSlotCount() == transition->anonymousSlotCount());
     return transition.release();
@@ -551,6 +577,8 @@ PassRefPtr<Structure> Structure::despecifyFunctionTransition(Structure* structur
     RefPtr<Structure> transition = create(structure->storedPrototype(), structure->typeInfo(), structure->anonymousSlotCount());
 
     transition->m_propertyStorageCapacity = structure->m_propertyStorageCapacity;
+    transition->m_inlineStorageCapacity = structure->m_inlineStorageCapacity;
+    transition->m_arrayElementKind = structure->m_arrayElementKind;
     transition->m_hasGetterSetterProperties = structure->m_hasGetterSetterProperties;
     transition->m_hasNonEnumerableProperties = structure->m_hasNonEnumerableProperties;
     transition->m_specificFunctionThrashCount = structure->m_specificFunctionThrashCount + 1;
@@ -558,8 +586,7 @@ PassRefPtr<Structure> Structure::despecifyFunctionTransition(Structure* structur
     // Don't set m_offset, as one can not transition to this.
 
     structure->materializePropertyMapIfNecessary();
-    transition->m_propertyTable = structure->copyPropertyTable();
-    transition->m_isPinnedPropertyTable = true;
+    transition->sharePropertyTable(structure);
 
     if (transition->m_specificFunctionThrashCount == maxSpecificFunctionThrashCount)
         transition->despecifyAllFunctions();
@@ -576,6 +603,8 @@ PassRefPtr<Structure> Structure::getterSetterTransition(Structure* structure)
 {
     RefPtr<Structure> transition = create(structure->storedPrototype(), structure->typeInfo(), structure->anonymousSlotCount());
     transition->m_propertyStorageCapacity = structure->m_propertyStorageCapacity;
+    transition->m_inlineStorageCapacity = structure->m_inlineStorageCapacity;
+    transition->m_arrayElementKind = structure->m_arrayElementKind;
     transition->m_hasGetterSetterProperties = transition->m_hasGetterSetterProperties;
     transition->m_hasNonEnumerableProperties = structure->m_hasNonEnumerableProperties;
     transition->m_specificFunctionThrashCount = structure->m_specificFunctionThrashCount;
@@ -583,8 +612,7 @@ PassRefPtr<Structure> Structure::getterSetterTransition(Structure* structure)
     // Don't set m_offset, as one can not transition to this.
 
     structure->materializePropertyMapIfNecessary();
-    transition->m_propertyTable = structure->copyPropertyTable();
-    transition->m_isPinnedPropertyTable = true;
+    transition->sharePropertyTable(structure);
     
     ASSERT(structure->anonymousSlotCount() == transition->anonymousSlotCount());
     return transition.release();
@@ -597,13 +625,14 @@ PassRefPtr<Structure> Structure::toDictionaryTransition(Structure* structure, Di
     RefPtr<Structure> transition = create(structure->m_prototype, structure->typeInfo(), structure->anonymousSlotCount());
     transition->m_dictionaryKind = kind;
     transition->m_propertyStorageCapacity = structure->m_propertyStorageCapacity;
+    transition->m_inlineStorageCapacity = structure->m_inlineStorageCapacity;
+    transition->m_arrayElementKind = structure->m_arrayElementKind;
     transition->m_hasGetterSetterProperties = structure->m_hasGetterSetterProperties;
     transition->m_hasNonEnumerableProperties = structure->m_hasNonEnumerableProperties;
     transition->m_specificFunctionThrashCount = structure->m_specificFunctionThrashCount;
     
     structure->materializePropertyMapIfNecessary();
-    transition->m_propertyTable = structure->copyPropertyTable();
-    transition->m_isPinnedPropertyTable = true;
+    transition->sharePropertyTable(structure);
     
     ASSERT(structure->anonymousSlotCount() == transition->anonymousSlotCount());
     return transition.release();
@@ -619,11 +648,49 @@ PassRefPtr<Structure> Structure::toUncacheableDictionaryTransition(Structure* st
     return toDictionaryTransition(structure, UncachedDictionaryKind);
 }
 
+PassRefPtr<Structure> Structure::arrayElementKindTransition(Structure* structure, ArrayElementKind kind)
+{
+    ASSERT(kind > structure->arrayElementKind());
+
+    // A dictionary belongs to a single object, so it can change in place.
+    if (structure->isDictionary()) {
+        structure->m_arrayElementKind = kind;
+        return structure;
+    }
+
+    // Moving on more than one kind goes through the Structures for the kinds in
+    // between, so that each Structure needs to remember just one transition.
+    while (structure->arrayElementKind() != kind) {
+        if (!structure->m_arrayElementKindTransition) {
+            RefPtr<Structure> transition = create(structure->storedPrototype(), structure->typeInfo(), structure->anonymousSlotCount());
+            transition->m_cachedPrototypeChain = structure->m_cachedPrototypeChain;
+            transition->m_propertyStorageCapacity = structure->m_propertyStorageCapacity;
+            transition->m_inlineStorageCapacity = structure->m_inlineStorageCapacity;
+            transition->m_arrayElementKind = structure->m_arrayElementKind + 1;
+            transition->m_hasGetterSetterProperties = structure->m_hasGetterSetterProperties;
+            transition->m_hasNonEnumerableProperties = structure->m_hasNonEnumerableProperties;
+            transition->m_specificFunctionThrashCount = structure->m_specificFunctionThrashCount;
+
+            // Don't set m_offset, as one can not transition to this.
+
+            structure->materializePropertyMapIfNecessary();
+            transition->sharePropertyTable(structure);
+
+            ASSERT(structure->anonymousSlotCount() == transition->anonymousSlotCount());
+            structure->m_arrayElementKindTransition = transition.release();
+        }
+        structure = structure->m_arrayElementKindTransition.get();
+    }
+    return structure;
+}
+
 PassRefPtr<Structure> Structure::flattenDictionaryStructure(JSObject* object)
 {
     ASSERT(isDictionary());
     if (isUncacheableDictionary()) {
         ASSERT(m_propertyTable);
+        prepareToModifyPropertyTable();
+
         Vector<PropertyMapEntry*> sortedPropertyEntries(m_propertyTable->keyCount);
         PropertyMapEntry** p = sortedPropertyEntries.data();
         unsigned entryCount = m_propertyTable->keyCount + m_propertyTable->deletedSentinelCount;
@@ -671,8 +738,6 @@ size_t Structure::addPropertyWithoutTransition(const Identifier& propertyName, u
 
     materializePropertyMapIfNecessary();
 
-    m_isPinnedPropertyTable = true;
-
     size_t offset = put(propertyName, attributes, specificValue);
     ASSERT(offset >= m_anonymousSlotCount);
     if (propertyStorageSize() > propertyStorageCapacity())
@@ -687,7 +752,6 @@ size_t Structure::removePropertyWithoutTransition(const Identifier& propertyName
 
     materializePropertyMapIfNecessary();
 
-    m_isPinnedPropertyTable = true;
     size_t offset = remove(propertyName);
     ASSERT(offset >= m_anonymousSlotCount);
     return offset;
@@ -727,26 +791,41 @@ inline void Structure::checkConsistency()
 
 #endif
 
-PropertyMapHashTable* Structure::copyPropertyTable()
+void Structure::sharePropertyTable(Structure* structure)
 {
-    if (!m_propertyTable)
-        return 0;
+    ASSERT(!m_propertyTable);
+    if (!structure->m_propertyTable)
+        return;
 
-    size_t tableSize = PropertyMapHashTable::allocationSize(m_propertyTable->size);
-    PropertyMapHashTable* newTable = static_cast<PropertyMapHashTable*>(fastMalloc(tableSize));
-    memcpy(newTable, m_propertyTable, tableSize);
+    m_propertyTable = structure->m_propertyTable;
+    m_propertyTableEntryCount = structure->m_propertyTableEntryCount;
+    ++m_propertyTable->refCount;
+}
 
-    unsigned entryCount = m_propertyTable->keyCount + m_propertyTable->deletedSentinelCount;
-    for (unsigned i = 1; i <= entryCount; ++i) {
-        if (UString::Rep* key = newTable->entries()[i].key)
-            key->ref();
+void Structure::prepareToAppendToPropertyTable()
+{
+    ASSERT(m_propertyTable);
+
+    // Other Structures sharing the table do not see entries appended after theirs,
+    // but would see deleted entries and offsets being reused.
+    if (m_propertyTableEntryCount == m_propertyTable->keyCount + m_propertyTable->deletedSentinelCount) {
+        if (m_propertyTable->refCount == 1)
+            return;
+        if (!m_propertyTable->deletedSentinelCount && (!m_propertyTable->deletedOffsets || m_propertyTable->deletedOffsets->isEmpty()))
+            return;
     }
 
-    // Copy the deletedOffsets vector.
-    if (m_propertyTable->deletedOffsets)
-        newTable->deletedOffsets = new Vector<unsigned>(*m_propertyTable->deletedOffsets);
+    rehashPropertyMapHashTable();
+}
+
+void Structure::prepareToModifyPropertyTable()
+{
+    ASSERT(m_propertyTable);
+
+    if (m_propertyTable->refCount == 1 && m_propertyTableEntryCount == m_propertyTable->keyCount + m_propertyTable->deletedSentinelCount)
+        return;
 
-    return newTable;
+    rehashPropertyMapHashTable();
 }
 
 size_t Structure::get(const UString::Rep* rep, unsigned& attributes, JSCell*& specificValue)
@@ -766,6 +845,8 @@ size_t Structure::get(const UString::Rep* rep, unsigned& attributes, JSCell*& sp
         return notFound;
 
     if (rep == m_propertyTable->entries()[entryIndex - 1].key) {
+        if (!propertyTableEntryIsVisible(entryIndex))
+            return notFound;
         attributes = m_propertyTable->entries()[entryIndex - 1].attributes;
         specificValue = m_propertyTable->entries()[entryIndex - 1].specificValue;
         ASSERT(m_propertyTable->entries()[entryIndex - 1].offset >= m_anonymousSlotCount);
@@ -790,6 +871,8 @@ size_t Structure::get(const UString::Rep* rep, unsigned& attributes, JSCell*& sp
             return notFound;
 
         if (rep == m_propertyTable->entries()[entryIndex - 1].key) {
+            if (!propertyTableEntryIsVisible(entryIndex))
+                return notFound;
             attributes = m_propertyTable->entries()[entryIndex - 1].attributes;
             specificValue = m_propertyTable->entries()[entryIndex - 1].specificValue;
             ASSERT(m_propertyTable->entries()[entryIndex - 1].offset >= m_anonymousSlotCount);
@@ -806,6 +889,8 @@ bool Structure::despecifyFunction(const Identifier& propertyName)
     if (!m_propertyTable)
         return false;
 
+    prepareToModifyPropertyTable();
+
     UString::Rep* rep = propertyName._ustring.rep();
 
     unsigned i = rep->existingHash();
@@ -854,7 +939,9 @@ void Structure::despecifyAllFunctions()
     materializePropertyMapIfNecessary();
     if (!m_propertyTable)
         return;
-    
+
+    prepareToModifyPropertyTable();
+
     unsigned entryCount = m_propertyTable->keyCount + m_propertyTable->deletedSentinelCount;
     for (unsigned i = 1; i <= entryCount; ++i)
         m_propertyTable->entries()[i].specificValue = 0;
@@ -874,6 +961,8 @@ size_t Structure::put(const Identifier& propertyName, unsigned attributes, JSCel
 
     if (!m_propertyTable)
         createPropertyMapHashTable();
+    else
+        prepareToAppendToPropertyTable();
 
     // FIXME: Consider a fast case for tables with no deleted sentinels.
 
@@ -946,6 +1035,7 @@ size_t Structure::put(const Identifier& propertyName, unsigned attributes, JSCel
     
     ASSERT(newOffset >= m_anonymousSlotCount);
     ++m_propertyTable->keyCount;
+    m_propertyTableEntryCount = m_propertyTable->keyCount + m_propertyTable->deletedSentinelCount;
 
     if ((m_propertyTable->keyCount + m_propertyTable->deletedSentinelCount) * 2 >= m_propertyTable->size)
         expandPropertyMapHashTable();
@@ -970,6 +1060,8 @@ size_t Structure::remove(const Identifier& propertyName)
     if (!m_propertyTable)
         return notFound;
 
+    prepareToModifyPropertyTable();
+
 #if DUMP_PROPERTYMAP_STATS
     ++numProbes;
     ++numRemoves;
@@ -1061,11 +1153,13 @@ void Structure::insertIntoPropertyMapHashTable(const PropertyMapEntry& entry)
 #endif
     }
 
+    ASSERT(!m_propertyTable->deletedSentinelCount);
     unsigned entryIndex = m_propertyTable->keyCount + 2;
     m_propertyTable->entryIndices[i & m_propertyTable->sizeMask] = entryIndex;
     m_propertyTable->entries()[entryIndex - 1] = entry;
 
     ++m_propertyTable->keyCount;
+    m_propertyTableEntryCount = m_propertyTable->keyCount;
 }
 
 void Structure::createPropertyMapHashTable()
@@ -1082,8 +1176,10 @@ void Structure::createPropertyMapHashTable(unsigned newTableSize)
     checkConsistency();
 
     m_propertyTable = static_cast<PropertyMapHashTable*>(fastZeroedMalloc(PropertyMapHashTable::allocationSize(newTableSize)));
+    m_propertyTable->refCount = 1;
     m_propertyTable->size = newTableSize;
     m_propertyTable->sizeMask = newTableSize - 1;
+    m_propertyTableEntryCount = 0;
 
     checkConsistency();
 }
@@ -1091,7 +1187,23 @@ void Structure::createPropertyMapHashTable(unsigned newTableSize)
 void Structure::expandPropertyMapHashTable()
 {
     ASSERT(m_propertyTable);
+    PropertyMapHashTable* oldTable = m_propertyTable;
+    bool wasShared = oldTable->refCount > 1;
+
     rehashPropertyMapHashTable(m_propertyTable->size * 2);
+
+    if (!wasShared)
+        return;
+    ASSERT(!oldTable->deletedSentinelCount);
+
+    // A shared table has no deleted entries, so the new one has every entry at the
+    // same index, and the Structures before this one can move on to it. That way
+    // the old table is not kept alive just for them.
+    for (Structure* structure = m_previous.get(); structure && structure->m_propertyTable == oldTable; structure = structure->m_previous.get()) {
+        structure->m_propertyTable = m_propertyTable;
+        ++m_propertyTable->refCount;
+        derefPropertyTable(oldTable);
+    }
 }
 
 void Structure::rehashPropertyMapHashTable()
@@ -1109,23 +1221,29 @@ void Structure::rehashPropertyMapHashTable(unsigned newTableSize)
     checkConsistency();
 
     PropertyMapHashTable* oldTable = m_propertyTable;
+    unsigned entryCount = m_propertyTableEntryCount;
 
     m_propertyTable = static_cast<PropertyMapHashTable*>(fastZeroedMalloc(PropertyMapHashTable::allocationSize(newTableSize)));
+    m_propertyTable->refCount = 1;
     m_propertyTable->size = newTableSize;
     m_propertyTable->sizeMask = newTableSize - 1;
+    m_propertyTableEntryCount = 0;
 
+    // The old table may be shared, in which case it keeps its entries, and this
+    // Structure takes just the ones it sees.
     unsigned lastIndexUsed = 0;
-    unsigned entryCount = oldTable->keyCount + oldTable->deletedSentinelCount;
     for (unsigned i = 1; i <= entryCount; ++i) {
-        if (oldTable->entries()[i].key) {
+        if (UString::Rep* key = oldTable->entries()[i].key) {
+            key->ref();
             lastIndexUsed = max(oldTable->entries()[i].index, lastIndexUsed);
             insertIntoPropertyMapHashTable(oldTable->entries()[i]);
         }
     }
     m_propertyTable->lastIndexUsed = lastIndexUsed;
-    m_propertyTable->deletedOffsets = oldTable->deletedOffsets;
+    if (oldTable->deletedOffsets && !oldTable->deletedOffsets->isEmpty())
+        m_propertyTable->deletedOffsets = new Vector<unsigned>(*oldTable->deletedOffsets);
 
-    fastFree(oldTable);
+    derefPropertyTable(oldTable);
 
     checkConsistency();
 }
@@ -1147,10 +1265,10 @@ void Structure::getPropertyNames(PropertyNameArray& propertyNames, EnumerationMo
     if (!m_propertyTable)
         return;
 
-    if (m_propertyTable->keyCount < tinyMapThreshold) {
+    if (propertyTableKeyCount() < tinyMapThreshold) {
         PropertyMapEntry* a[tinyMapThreshold];
         int i = 0;
-        unsigned entryCount = m_propertyTable->keyCount + m_propertyTable->deletedSentinelCount;
+        unsigned entryCount = m_propertyTableEntryCount;
         for (unsigned k = 1; k <= entryCount; k++) {
             ASSERT(m_hasNonEnumerableProperties || !(m_propertyTable->entries()[k].attributes & DontEnum));
             if (m_propertyTable->entries()[k].key && (!(m_propertyTable->entries()[k].attributes & DontEnum) || (mode == IncludeDontEnumProperties))) {
@@ -1174,11 +1292,11 @@ void Structure::getPropertyNames(PropertyNameArray& propertyNames, EnumerationMo
     }
 
     // Allocate a buffer to use to sort the keys.
-    Vector<PropertyMapEntry*, smallMapThreshold> sortedEnumerables(m_propertyTable->keyCount);
+    Vector<PropertyMapEntry*, smallMapThreshold> sortedEnumerables(propertyTableKeyCount());
 
     // Get pointers to the enumerable entries in the buffer.
     PropertyMapEntry** p = sortedEnumerables.data();
-    unsigned entryCount = m_propertyTable->keyCount + m_propertyTable->deletedSentinelCount;
+    unsigned entryCount = m_propertyTableEntryCount;
     for (unsigned i = 1; i <= entryCount; i++) {
         if (m_propertyTable->entries()[i].key && (!(m_propertyTable->entries()[i].attributes & DontEnum) || (mode == IncludeDontEnumProperties)))
             *p++ = &m_propertyTable->entries()[i];
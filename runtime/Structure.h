@@ -57,13 +57,25 @@ namespace JSC {
         IncludeDontEnumProperties
     };
 
+    // How a JSArray with the Structure stores its elements. Arrays only ever move
+    // to a later kind, as they are given values the earlier ones cannot hold.
+    enum ArrayElementKind {
+        Int32ArrayElements, // Int32 JSValues.
+        DoubleArrayElements, // Unboxed doubles, see JSArray.h.
+        ContiguousArrayElements, // Any JSValues.
+        SparseArrayElements // Any JSValues, and the array has a sparse map.
+    };
+
     class Structure : public RefCounted<Structure> {
     public:
         friend class JIT;
         friend class StructureTransitionTable;
-        static PassRefPtr<Structure> create(JSValue prototype, const TypeInfo& typeInfo, unsigned anonymousSlotCount)
+        static PassRefPtr<Structure> create(JSValue prototype, const TypeInfo&, unsigned anonymousSlotCount);
+
+        // Only for plain JSObjects allocated with JSObject::allocationSize(inlineStorageCapacity) bytes.
+        static PassRefPtr<Structure> createWithInlineStorageCapacity(JSValue prototype, const TypeInfo& typeInfo, unsigned anonymousSlotCount, unsigned inlineStorageCapacity)
         {
-            return adoptRef(new Structure(prototype, typeInfo, anonymousSlotCount));
+            return adoptRef(new Structure(prototype, typeInfo, anonymousSlotCount, inlineStorageCapacity));
         }
 
         static void startIgnoringLeaks();
@@ -79,6 +91,7 @@ namespace JSC {
         static PassRefPtr<Structure> getterSetterTransition(Structure*);
         static PassRefPtr<Structure> toCacheableDictionaryTransition(Structure*);
         static PassRefPtr<Structure> toUncacheableDictionaryTransition(Structure*);
+        static PassRefPtr<Structure> arrayElementKindTransition(Structure*, ArrayElementKind);
 
         PassRefPtr<Structure> flattenDictionaryStructure(JSObject*);
 
@@ -87,12 +100,18 @@ namespace JSC {
         // These should be used with caution.  
         size_t addPropertyWithoutTransition(const Identifier& propertyName, unsigned attributes, JSCell* specificValue);
         size_t removePropertyWithoutTransition(const Identifier& propertyName);
-        void setPrototypeWithoutTransition(JSValue prototype) { m_prototype = prototype; }
+        void setPrototypeWithoutTransition(JSValue prototype)
+        {
+            m_prototype = prototype;
+            if (prototype.isCell())
+                Heap::pinCell(prototype.asCell());
+        }
         
         bool isDictionary() const { return m_dictionaryKind != NoneDictionaryKind; }
         bool isUncacheableDictionary() const { return m_dictionaryKind == UncachedDictionaryKind; }
 
         const TypeInfo& typeInfo() const { return m_typeInfo; }
+        ArrayElementKind arrayElementKind() const { return static_cast<ArrayElementKind>(m_arrayElementKind); }
 
         JSValue storedPrototype() const { return m_prototype; }
         JSValue prototypeForLookup(ExecState*) const;
@@ -102,7 +121,10 @@ namespace JSC {
 
         void growPropertyStorageCapacity();
         unsigned propertyStorageCapacity() const { return m_propertyStorageCapacity; }
-        unsigned propertyStorageSize() const { return m_anonymousSlotCount + (m_propertyTable ? m_propertyTable->keyCount + (m_propertyTable->deletedOffsets ? m_propertyTable->deletedOffsets->size() : 0) : static_cast<unsigned>(m_offset + 1)); }
+        unsigned inlineStorageCapacity() const { return m_inlineStorageCapacity; }
+        // The most storage any object starting out with this Structure has been seen to need.
+        unsigned observedPropertyStorageSize() const { return m_observedPropertyStorageSize; }
+        unsigned propertyStorageSize() const { return m_anonymousSlotCount + (m_propertyTable ? propertyTableKeyCount() + (m_propertyTable->deletedOffsets ? m_propertyTable->deletedOffsets->size() : 0) : static_cast<unsigned>(m_offset + 1)); }
         bool isUsingInlineStorage() const;
 
         size_t get(const Identifier& propertyName);
@@ -130,7 +152,7 @@ namespace JSC {
         bool hasAnonymousSlots() const { return !!m_anonymousSlotCount; }
         unsigned anonymousSlotCount() const { return m_anonymousSlotCount; }
         
-        bool isEmpty() const { return m_propertyTable ? !m_propertyTable->keyCount : m_offset == noOffset; }
+        bool isEmpty() const { return m_propertyTable ? !propertyTableKeyCount() : m_offset == noOffset; }
 
         void despecifyDictionaryFunction(const Identifier& propertyName);
         void disableSpecificFunctionTracking() { m_specificFunctionThrashCount = maxSpecificFunctionThrashCount; }
@@ -142,7 +164,7 @@ namespace JSC {
         
     private:
 
-        Structure(JSValue prototype, const TypeInfo&, unsigned anonymousSlotCount);
+        Structure(JSValue prototype, const TypeInfo&, unsigned anonymousSlotCount, unsigned inlineStorageCapacity);
         
         typedef enum { 
             NoneDictionaryKind = 0,
@@ -165,7 +187,14 @@ namespace JSC {
         bool despecifyFunction(const Identifier&);
         void despecifyAllFunctions();
 
-        PropertyMapHashTable* copyPropertyTable();
+        // Entries past m_propertyTableEntryCount were appended by Structures further
+        // along the chain that share the table. A table with deleted entries is
+        // never appended to while shared, so none of them come after it.
+        bool propertyTableEntryIsVisible(unsigned entryIndex) const { return entryIndex - 1 <= m_propertyTableEntryCount; }
+        unsigned propertyTableKeyCount() const { return m_propertyTableEntryCount - m_propertyTable->deletedSentinelCount; }
+        void sharePropertyTable(Structure*);
+        void prepareToAppendToPropertyTable();
+        void prepareToModifyPropertyTable();
         void materializePropertyMap();
         void materializePropertyMapIfNecessary()
         {
@@ -174,7 +203,7 @@ namespace JSC {
             materializePropertyMap();
         }
 
-        signed char transitionCount() const
+        int transitionCount() const
         {
             // Since the number of transitions is always the same as m_offset, we keep the size of Structure down by not storing both.
             return m_offset == noOffset ? 0 : m_offset + 1;
@@ -198,13 +227,16 @@ namespace JSC {
 
         static const unsigned emptyEntryIndex = 0;
     
-        static const signed char s_maxTransitionLength = 64;
+        // Objects that keep gaining new properties past this are used as maps, and
+        // are better off as dictionaries than with a Structure for every key.
+        static const int s_maxTransitionLength = 1024;
 
-        static const signed char noOffset = -1;
+        static const int noOffset = -1;
 
         static const unsigned maxSpecificFunctionThrashCount = 3;
 
         TypeInfo m_typeInfo;
+        unsigned char m_arrayElementKind;
 
         JSValue m_prototype;
         mutable RefPtr<StructureChain> m_cachedPrototypeChain;
@@ -213,6 +245,10 @@ namespace JSC {
         RefPtr<UString::Rep> m_nameInPrevious;
         JSCell* m_specificValueInPrevious;
 
+        // The Structure for the next ArrayElementKind, which shares the property
+        // table and is the same for every array that moves on from this one.
+        RefPtr<Structure> m_arrayElementKindTransition;
+
         // 'm_isUsingSingleSlot' indicates whether we are using the single transition optimisation.
         union {
             TransitionTable* m_table;
@@ -222,14 +258,18 @@ namespace JSC {
         WeakGCPtr<JSPropertyNameIterator> m_enumerationCache;
 
         PropertyMapHashTable* m_propertyTable;
+        unsigned m_propertyTableEntryCount; // How many of m_propertyTable's entries this Structure sees.
 
         uint32_t m_propertyStorageCapacity;
+        // Fixed by the size of the cells of the objects that have this Structure,
+        // so it is carried over by every transition.
+        uint32_t m_inlineStorageCapacity;
+        uint32_t m_observedPropertyStorageSize;
 
         // m_offset does not account for anonymous slots
-        signed char m_offset;
+        int m_offset;
 
         unsigned m_dictionaryKind : 2;
-        bool m_isPinnedPropertyTable : 1;
         bool m_hasGetterSetterProperties : 1;
         bool m_hasNonEnumerableProperties : 1;
 #if COMPILER(WINSCW)
@@ -243,7 +283,7 @@ namespace JSC {
         unsigned m_specificFunctionThrashCount : 2;
         unsigned m_anonymousSlotCount : 5;
         unsigned m_isUsingSingleSlot : 1;
-        // 4 free bits
+        // 5 free bits
     };
 
     inline size_t Structure::get(const Identifier& propertyName)
@@ -267,7 +307,7 @@ namespace JSC {
             return WTF::notFound;
 
         if (rep == m_propertyTable->entries()[entryIndex - 1].key)
-            return m_propertyTable->entries()[entryIndex - 1].offset;
+            return propertyTableEntryIsVisible(entryIndex) ? m_propertyTable->entries()[entryIndex - 1].offset : WTF::notFound;
 
 #if DUMP_PROPERTYMAP_STATS
         ++numCollisions;
@@ -287,7 +327,7 @@ namespace JSC {
                 return WTF::notFound;
 
             if (rep == m_propertyTable->entries()[entryIndex - 1].key)
-                return m_propertyTable->entries()[entryIndex - 1].offset;
+                return propertyTableEntryIsVisible(entryIndex) ? m_propertyTable->entries()[entryIndex - 1].offset : WTF::notFound;
         }
     }
 
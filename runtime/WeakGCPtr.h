@@ -77,6 +77,7 @@ private:
     {
         ASSERT(ptr);
         Heap::markCell(ptr);
+        Heap::pinCell(ptr);
         m_ptr = ptr;
     }
 
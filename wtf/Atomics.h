@@ -88,23 +88,31 @@ inline int atomicIncrement(int volatile* addend) { return InterlockedIncrement(r
 inline int atomicDecrement(int volatile* addend) { return InterlockedDecrement(reinterpret_cast<long volatile*>(addend)); }
 #endif
 
+inline bool weakCompareAndSwap(unsigned volatile* location, unsigned expected, unsigned newValue) { return InterlockedCompareExchange(reinterpret_cast<long volatile*>(location), newValue, expected) == static_cast<long>(expected); }
+
 #elif OS(DARWIN)
 #define WTF_USE_LOCKFREE_THREADSAFESHARED 1
 
 inline int atomicIncrement(int volatile* addend) { return OSAtomicIncrement32Barrier(const_cast<int*>(addend)); }
 inline int atomicDecrement(int volatile* addend) { return OSAtomicDecrement32Barrier(const_cast<int*>(addend)); }
 
+inline bool weakCompareAndSwap(unsigned volatile* location, unsigned expected, unsigned newValue) { return OSAtomicCompareAndSwap32Barrier(expected, newValue, reinterpret_cast<int32_t volatile*>(location)); }
+
 #elif OS(ANDROID)
 
 inline int atomicIncrement(int volatile* addend) { return android_atomic_inc(addend); }
 inline int atomicDecrement(int volatile* addend) { return android_atomic_dec(addend); }
 
+inline bool weakCompareAndSwap(unsigned volatile* location, unsigned expected, unsigned newValue) { return !android_atomic_cmpxchg(expected, newValue, reinterpret_cast<int32_t volatile*>(location)); }
+
 #elif COMPILER(GCC) && !CPU(SPARC64) && !OS(SYMBIAN) // sizeof(_Atomic_word) != sizeof(int) on sparc64 gcc
 #define WTF_USE_LOCKFREE_THREADSAFESHARED 1
 
 inline int atomicIncrement(int volatile* addend) { return __gnu_cxx::__exchange_and_add(addend, 1) + 1; }
 inline int atomicDecrement(int volatile* addend) { return __gnu_cxx::__exchange_and_add(addend, -1) - 1; }
 
+inline bool weakCompareAndSwap(unsigned volatile* location, unsigned expected, unsigned newValue) { return __sync_bool_compare_and_swap(location, expected, newValue); }
+
 #endif
 
 } // namespace WTF
@@ -112,6 +120,7 @@ inline int atomicDecrement(int volatile* addend) { return __gnu_cxx::__exchange_
 #if USE(LOCKFREE_THREADSAFESHARED)
 using WTF::atomicDecrement;
 using WTF::atomicIncrement;
+using WTF::weakCompareAndSwap;
 #endif
 
 #endif // Atomics_h
@@ -1034,6 +1034,20 @@ on MinGW. See https://bugs.webkit.org/show_bug.cgi?id=29268 */
 #ifndef ENABLE_JIT_OPTIMIZE_MOD
 #define ENABLE_JIT_OPTIMIZE_MOD 0
 #endif
+/* Hot functions are recompiled by a second, speculating tier that bails out to the baseline code. */
+#if !defined(ENABLE_JIT_OPTIMIZING_TIER) && USE(JSVALUE64) && CPU(X86_64)
+#define ENABLE_JIT_OPTIMIZING_TIER 1
+#endif
+#endif
+
+/* Global code starts in the interpreter and switches to JIT code at a hot loop header. */
+#if !defined(ENABLE_INTERPRETER_OSR) && ENABLE(JIT) && ENABLE(INTERPRETER)
+#define ENABLE_INTERPRETER_OSR 1
+#endif
+
+/* Record the kinds of value that arithmetic, property loads and calls produce. */
+#if !defined(ENABLE_VALUE_PROFILER) && (!ENABLE(JIT) || USE(JSVALUE64))
+#define ENABLE_VALUE_PROFILER 1
 #endif
 
 #if CPU(X86) && COMPILER(MSVC)
@@ -1160,6 +1174,17 @@ on MinGW. See https://bugs.webkit.org/show_bug.cgi?id=29268 */
 
 #define ENABLE_JSC_ZOMBIES 0
 
+/* Parallel marking needs threads and the compare-and-swap from Atomics.h. */
+#if !defined(ENABLE_PARALLEL_GC) && !ENABLE(SINGLE_THREADED) \
+    && (OS(WINDOWS) || OS(DARWIN) || OS(ANDROID) || (COMPILER(GCC) && !CPU(SPARC64) && !OS(SYMBIAN)))
+#define ENABLE_PARALLEL_GC 1
+#endif
+
+/* Blocks the collector no longer needs are returned to the system on a background thread. */
+#if !defined(ENABLE_BLOCK_FREEING_THREAD) && !ENABLE(SINGLE_THREADED) && !OS(SYMBIAN)
+#define ENABLE_BLOCK_FREEING_THREAD 1
+#endif
+
 #if CPU(ARM_THUMB2)
 #define ENABLE_BRANCH_COMPACTION 1
 #endif